@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+# Energy benchmark of the firmware on the host simulator
+#
+#   sim/bench/run.sh [hours] > bench.json
+#
+# Builds cp_sim once per scenario of scenarios.txt, with its settings of
+# app.h and ble.h, runs it for the simulated hours (default 24) and writes
+# one JSON document: the commit, the hours and the cp_sim --json report of
+# each scenario. Documents of two commits compare with diff or jq.
+#
+set -eu
+
+HOURS=${1:-24}
+BENCH=$(cd "$(dirname "$0")" && pwd)
+SIM=$(dirname "$BENCH")
+BUILD=${BUILD_DIR:-$SIM/../build-sim/bench}
+ENVIRONMENT="--temp 72 --temp-swing 4 --swing-period 1800 --temp-noise 0.2 --seed 1 --ble-connected"
+COMMIT=$(git -C "$SIM" describe --always --dirty 2>/dev/null || echo unknown)
+SECONDS_RUN=$(awk "BEGIN { print $HOURS * 3600 }")
+
+printf '{\n"commit": "%s",\n"hours": %s,\n"scenarios": {' "$COMMIT" "$HOURS"
+sep=""
+grep -v '^[[:space:]]*\(#\|$\)' "$BENCH/scenarios.txt" | while IFS='|' read -r name defines options; do
+	name=$(echo $name)
+	defines=$(echo $defines)
+	cmake -S "$SIM" -B "$BUILD/$name" -DCMAKE_BUILD_TYPE=Release "-DCP_SIM_DEFINES=$defines" >&2
+	cmake --build "$BUILD/$name" >&2
+	printf '%s\n"%s": ' "$sep" "$name"
+	"$BUILD/$name/cp_sim" --seconds "$SECONDS_RUN" $ENVIRONMENT $options --json
+	sep=","
+done
+printf '}\n}\n'
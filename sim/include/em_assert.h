@@ -0,0 +1,21 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_ASSERT_HG
+#define	EM_ASSERT_HG
+
+/* System include statements */
+#include <stdint.h>
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+/* Always checked on the host, a failed assertion ends the simulation */
+#define EFM_ASSERT(expr)	((expr) ? ((void)0) : assertEFM(__FILE__, __LINE__))
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void assertEFM(const char *file, int line) __attribute__((noreturn));
+
+#endif
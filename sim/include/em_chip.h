@@ -0,0 +1,16 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_CHIP_HG
+#define	EM_CHIP_HG
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+static inline void CHIP_Init(void){
+}
+
+#endif
@@ -0,0 +1,78 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_CMU_HG
+#define	EM_CMU_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+	cmuClock_HF,
+	cmuClock_HFPER,
+	cmuClock_CORELE,
+	cmuClock_GPIO,
+	cmuClock_LDMA,
+	cmuClock_GPCRC,
+	cmuClock_I2C0,
+	cmuClock_I2C1,
+	cmuClock_LFA,
+	cmuClock_LFB,
+	cmuClock_LFE,
+	cmuClock_LETIMER0,
+	cmuClock_LEUART0,
+	cmuClock_RTCC,
+	cmuClock_COUNT
+} CMU_Clock_TypeDef;
+
+typedef enum {
+	cmuOsc_LFXO,
+	cmuOsc_LFRCO,
+	cmuOsc_ULFRCO,
+	cmuOsc_HFXO,
+	cmuOsc_HFRCO,
+	cmuOsc_COUNT
+} CMU_Osc_TypeDef;
+
+typedef enum {
+	cmuSelect_Disabled,
+	cmuSelect_LFXO,
+	cmuSelect_LFRCO,
+	cmuSelect_ULFRCO,
+	cmuSelect_HFXO,
+	cmuSelect_HFRCO,
+} CMU_Select_TypeDef;
+
+typedef enum {
+	cmuHFRCOFreq_1M0Hz		= 1000000,
+	cmuHFRCOFreq_19M0Hz		= 19000000,
+	cmuHFRCOFreq_26M0Hz		= 26000000,
+	cmuHFRCOFreq_38M0Hz		= 38000000,
+} CMU_HFRCOFreq_TypeDef;
+
+typedef struct {
+	bool		lowPowerMode;
+	uint32_t	ctuneStartup;
+	uint32_t	ctuneSteadyState;
+} CMU_HFXOInit_TypeDef;
+
+#define CMU_HFXOINIT_DEFAULT	{ false, 0, 0 }
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait);
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef freq);
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+
+#endif
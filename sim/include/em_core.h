@@ -0,0 +1,32 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_CORE_HG
+#define	EM_CORE_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef uint32_t CORE_irqState_t;
+
+#define CORE_DECLARE_IRQ_STATE		CORE_irqState_t irqState
+#define CORE_ENTER_CRITICAL()		irqState = CORE_EnterCritical()
+#define CORE_EXIT_CRITICAL()		CORE_ExitCritical(irqState)
+#define CORE_ENTER_ATOMIC()			irqState = CORE_EnterAtomic()
+#define CORE_EXIT_ATOMIC()			CORE_ExitAtomic(irqState)
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+CORE_irqState_t CORE_EnterCritical(void);
+void CORE_ExitCritical(CORE_irqState_t irqState);
+CORE_irqState_t CORE_EnterAtomic(void);
+void CORE_ExitAtomic(CORE_irqState_t irqState);
+
+#endif
@@ -0,0 +1,291 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_DEVICE_HG
+#define	EM_DEVICE_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Simulator include statements */
+#include "sim.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+/* Host stand-in for the EFM32PG12B device header. Only the registers and bits
+ * the drivers in src/ use are declared, with the reference manual values. The
+ * register blocks live in pages the simulator traps, see sim.c, so every
+ * access from a driver reaches the peripheral model.
+ */
+#define __IM	volatile const
+#define __OM	volatile
+#define __IOM	volatile
+
+typedef enum {
+	LDMA_IRQn			= 8,
+	I2C0_IRQn			= 16,
+	LEUART0_IRQn		= 21,
+	LETIMER0_IRQn		= 26,
+	RTCC_IRQn			= 29,
+	I2C1_IRQn			= 38,
+} IRQn_Type;
+
+#define SIM_IRQ_COUNT		64
+#define __NVIC_PRIO_BITS	3
+
+/* Cortex-M4 debug, CoreDebug is plain memory, DWT CYCCNT is modelled in sim.c */
+typedef struct {
+	__IOM uint32_t CTRL;
+	__IOM uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	__IOM uint32_t DHCSR;
+	__OM  uint32_t DCRSR;
+	__IOM uint32_t DCRDR;
+	__IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk			0x00000001UL
+#define CoreDebug_DHCSR_C_DEBUGEN_Msk	0x00000001UL
+#define CoreDebug_DEMCR_TRCENA_Msk		0x01000000UL
+
+extern CoreDebug_Type	sim_core_debug;
+
+/* LETIMER */
+typedef struct {
+	__IOM uint32_t CTRL;
+	__IOM uint32_t CMD;
+	__IM  uint32_t STATUS;
+	__IOM uint32_t CNT;
+	__IOM uint32_t COMP0;
+	__IOM uint32_t COMP1;
+	__IOM uint32_t REP0;
+	__IOM uint32_t REP1;
+	__IM  uint32_t IF;
+	__IOM uint32_t IFS;
+	__IOM uint32_t IFC;
+	__IOM uint32_t IEN;
+	__IM  uint32_t SYNCBUSY;
+	__IOM uint32_t ROUTEPEN;
+	__IOM uint32_t ROUTELOC0;
+} LETIMER_TypeDef;
+
+#define LETIMER_CMD_START				0x00000001UL
+#define LETIMER_CMD_STOP				0x00000002UL
+#define LETIMER_CMD_CLEAR				0x00000004UL
+#define LETIMER_STATUS_RUNNING			0x00000001UL
+#define LETIMER_SYNCBUSY_CTRL			0x00000001UL
+#define LETIMER_SYNCBUSY_CMD			0x00000002UL
+#define LETIMER_SYNCBUSY_COMP0			0x00000004UL
+#define LETIMER_SYNCBUSY_COMP1			0x00000008UL
+#define LETIMER_SYNCBUSY_REP0			0x00000010UL
+#define LETIMER_SYNCBUSY_REP1			0x00000020UL
+#define LETIMER_SYNCBUSY_CNT			0x00000040UL
+#define LETIMER_IF_COMP0				0x00000001UL
+#define LETIMER_IF_COMP1				0x00000002UL
+#define LETIMER_IF_UF					0x00000004UL
+#define LETIMER_IF_REP0					0x00000008UL
+#define LETIMER_IF_REP1					0x00000010UL
+#define _LETIMER_IF_MASK				0x0000001FUL
+#define _LETIMER_IFC_MASK				0x0000001FUL
+#define LETIMER_IEN_COMP0				LETIMER_IF_COMP0
+#define LETIMER_IEN_COMP1				LETIMER_IF_COMP1
+#define LETIMER_IEN_UF					LETIMER_IF_UF
+#define LETIMER_IEN_REP0				LETIMER_IF_REP0
+#define LETIMER_IEN_REP1				LETIMER_IF_REP1
+#define LETIMER_ROUTEPEN_OUT0PEN		0x00000001UL
+#define LETIMER_ROUTEPEN_OUT1PEN		0x00000002UL
+#define LETIMER_ROUTELOC0_OUT0LOC_LOC28	(28UL << 0)
+#define LETIMER_ROUTELOC0_OUT1LOC_LOC28	(28UL << 8)
+
+/* LEUART */
+typedef struct {
+	__IOM uint32_t CTRL;
+	__IOM uint32_t CMD;
+	__IM  uint32_t STATUS;
+	__IOM uint32_t CLKDIV;
+	__IOM uint32_t STARTFRAME;
+	__IOM uint32_t SIGFRAME;
+	__IM  uint32_t RXDATAX;
+	__IM  uint32_t RXDATA;
+	__IM  uint32_t RXDATAXP;
+	__IOM uint32_t TXDATAX;
+	__IOM uint32_t TXDATA;
+	__IM  uint32_t IF;
+	__IOM uint32_t IFS;
+	__IOM uint32_t IFC;
+	__IOM uint32_t IEN;
+	__IM  uint32_t SYNCBUSY;
+	__IOM uint32_t ROUTEPEN;
+	__IOM uint32_t ROUTELOC0;
+} LEUART_TypeDef;
+
+#define LEUART_CTRL_SFUBRX				0x00000008UL
+#define LEUART_CTRL_RXDMAWU				0x00001000UL
+#define LEUART_CTRL_TXDMAWU				0x00002000UL
+#define LEUART_CMD_RXEN					0x00000001UL
+#define LEUART_CMD_RXDIS				0x00000002UL
+#define LEUART_CMD_TXEN					0x00000004UL
+#define LEUART_CMD_TXDIS				0x00000008UL
+#define LEUART_CMD_RXBLOCKEN			0x00000010UL
+#define LEUART_CMD_RXBLOCKDIS			0x00000020UL
+#define LEUART_CMD_CLEARTX				0x00000040UL
+#define LEUART_CMD_CLEARRX				0x00000080UL
+#define LEUART_STATUS_RXENS				0x00000001UL
+#define LEUART_STATUS_TXENS				0x00000002UL
+#define LEUART_STATUS_RXBLOCK			0x00000004UL
+#define LEUART_STATUS_TXC				0x00000008UL
+#define LEUART_STATUS_TXBL				0x00000010UL
+#define LEUART_STATUS_RXDATAV			0x00000020UL
+#define LEUART_STATUS_TXIDLE			0x00000040UL
+#define LEUART_SYNCBUSY_CTRL			0x00000001UL
+#define LEUART_SYNCBUSY_CMD				0x00000002UL
+#define LEUART_SYNCBUSY_CLKDIV			0x00000008UL
+#define LEUART_SYNCBUSY_STARTFRAME		0x00000010UL
+#define LEUART_SYNCBUSY_SIGFRAME		0x00000020UL
+#define LEUART_IF_TXC					0x00000001UL
+#define LEUART_IF_TXBL					0x00000002UL
+#define LEUART_IF_RXDATAV				0x00000004UL
+#define LEUART_IF_RXOF					0x00000008UL
+#define LEUART_IF_RXUF					0x00000010UL
+#define LEUART_IF_TXOF					0x00000020UL
+#define LEUART_IF_PERR					0x00000040UL
+#define LEUART_IF_FERR					0x00000080UL
+#define LEUART_IF_MPAF					0x00000100UL
+#define LEUART_IF_STARTF				0x00000200UL
+#define LEUART_IF_SIGF					0x00000400UL
+#define _LEUART_IF_MASK					0x000007FFUL
+#define LEUART_IFC_TXC					LEUART_IF_TXC
+#define LEUART_IEN_TXC					LEUART_IF_TXC
+#define LEUART_IEN_TXBL					LEUART_IF_TXBL
+#define LEUART_IEN_RXDATAV				LEUART_IF_RXDATAV
+#define LEUART_IEN_RXOF					LEUART_IF_RXOF
+#define LEUART_IEN_FERR					LEUART_IF_FERR
+#define LEUART_IEN_STARTF				LEUART_IF_STARTF
+#define LEUART_IEN_SIGF					LEUART_IF_SIGF
+#define LEUART_ROUTEPEN_RXPEN			0x00000001UL
+#define LEUART_ROUTEPEN_TXPEN			0x00000002UL
+#define LEUART_ROUTELOC0_RXLOC_LOC18	(18UL << 0)
+#define LEUART_ROUTELOC0_TXLOC_LOC18	(18UL << 8)
+
+/* I2C */
+typedef struct {
+	__IOM uint32_t CTRL;
+	__IOM uint32_t CMD;
+	__IM  uint32_t STATE;
+	__IM  uint32_t STATUS;
+	__IOM uint32_t CLKDIV;
+	__IOM uint32_t SADDR;
+	__IOM uint32_t SADDRMASK;
+	__IM  uint32_t RXDATA;
+	__IM  uint32_t RXDOUBLE;
+	__IM  uint32_t RXDATAP;
+	__IM  uint32_t RXDOUBLEP;
+	__IOM uint32_t TXDATA;
+	__IOM uint32_t TXDOUBLE;
+	__IM  uint32_t IF;
+	__IOM uint32_t IFS;
+	__IOM uint32_t IFC;
+	__IOM uint32_t IEN;
+	__IOM uint32_t ROUTEPEN;
+	__IOM uint32_t ROUTELOC0;
+} I2C_TypeDef;
+
+#define I2C_CTRL_EN						0x00000001UL
+#define I2C_CTRL_SLAVE					0x00000002UL
+#define I2C_CTRL_AUTOACK				0x00000004UL
+#define I2C_CMD_START					0x00000001UL
+#define I2C_CMD_STOP					0x00000002UL
+#define I2C_CMD_ACK						0x00000004UL
+#define I2C_CMD_NACK					0x00000008UL
+#define I2C_CMD_CONT					0x00000010UL
+#define I2C_CMD_ABORT					0x00000020UL
+#define I2C_CMD_CLEARTX					0x00000040UL
+#define I2C_CMD_CLEARPC					0x00000080UL
+#define I2C_STATE_BUSY					0x00000001UL
+#define I2C_STATE_MASTER				0x00000002UL
+#define I2C_STATE_TRANSMITTER			0x00000004UL
+#define I2C_STATE_NACKED				0x00000008UL
+#define I2C_STATE_BUSHOLD				0x00000010UL
+#define _I2C_STATE_STATE_MASK			0x000000E0UL
+#define I2C_STATE_STATE_IDLE			0x00000000UL
+#define I2C_STATE_STATE_WAIT			0x00000020UL
+#define I2C_STATE_STATE_START			0x00000040UL
+#define I2C_STATE_STATE_ADDR			0x00000060UL
+#define I2C_STATE_STATE_ADDRACK			0x00000080UL
+#define I2C_STATE_STATE_DATA			0x000000A0UL
+#define I2C_STATE_STATE_DATAACK			0x000000C0UL
+#define I2C_STATUS_TXBL					0x00000080UL
+#define I2C_STATUS_RXDATAV				0x00000100UL
+#define I2C_IF_START					0x00000001UL
+#define I2C_IF_RSTART					0x00000002UL
+#define I2C_IF_ADDR						0x00000004UL
+#define I2C_IF_TXC						0x00000008UL
+#define I2C_IF_TXBL						0x00000010UL
+#define I2C_IF_RXDATAV					0x00000020UL
+#define I2C_IF_ACK						0x00000040UL
+#define I2C_IF_NACK						0x00000080UL
+#define I2C_IF_MSTOP					0x00000100UL
+#define I2C_IF_ARBLOST					0x00000200UL
+#define I2C_IF_BUSERR					0x00000400UL
+#define I2C_IF_BUSHOLD					0x00000800UL
+#define _I2C_IF_MASK					0x0007FFFFUL
+#define I2C_IEN_ACK						I2C_IF_ACK
+#define I2C_IEN_NACK					I2C_IF_NACK
+#define I2C_IEN_MSTOP					I2C_IF_MSTOP
+#define I2C_IEN_RXDATAV					I2C_IF_RXDATAV
+#define I2C_ROUTEPEN_SDAPEN				0x00000001UL
+#define I2C_ROUTEPEN_SCLPEN				0x00000002UL
+#define I2C_ROUTELOC0_SDALOC_LOC15		(15UL << 0)
+#define I2C_ROUTELOC0_SCLLOC_LOC15		(15UL << 8)
+
+/* Peripheral instances, one trapped page each */
+#define LETIMER_COUNT	1
+#define LEUART_COUNT	1
+#define I2C_COUNT		2
+#define LETIMER0		((LETIMER_TypeDef *)sim_page(SIM_PAGE_LETIMER0))
+#define LEUART0			((LEUART_TypeDef *)sim_page(SIM_PAGE_LEUART0))
+#define I2C0			((I2C_TypeDef *)sim_page(SIM_PAGE_I2C0))
+#define I2C1			((I2C_TypeDef *)sim_page(SIM_PAGE_I2C1))
+#define DWT				((DWT_Type *)sim_page(SIM_PAGE_DWT))
+#define CoreDebug		(&sim_core_debug)
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+/* Cortex-M4 core, see sim.c */
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+void NVIC_SetPriorityGrouping(uint32_t group);
+uint32_t NVIC_GetPriorityGrouping(void);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+uint32_t __get_BASEPRI(void);
+void __set_BASEPRI(uint32_t value);
+void __set_BASEPRI_MAX(uint32_t value);
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+void __CLREX(void);
+
+/* Intrinsics, the host's builtins; a barrier only has to stop the compiler */
+#define __DMB()			__sync_synchronize()
+#define __DSB()			__sync_synchronize()
+#define __ISB()			__sync_synchronize()
+#define __CLZ(x)		((uint8_t)((x) ? __builtin_clz(x) : 32))
+
+/* As CMSIS core_cm4.h */
+static inline uint32_t NVIC_EncodePriority(uint32_t group, uint32_t preempt, uint32_t sub){
+	uint32_t group_bits = ((7 - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7 - group);
+	uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7) ? 0 : (group - 7 + __NVIC_PRIO_BITS);
+	return ((preempt & ((1u << group_bits) - 1)) << sub_bits) | (sub & ((1u << sub_bits) - 1));
+}
+
+#endif
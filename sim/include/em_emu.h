@@ -0,0 +1,45 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_EMU_HG
+#define	EM_EMU_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+	emuVScaleEM23_FastWakeup,
+	emuVScaleEM23_LowPower,
+} EMU_VScaleEM23_TypeDef;
+
+typedef struct {
+	bool					em23VregFullEn;
+	EMU_VScaleEM23_TypeDef	vScaleEM23Voltage;
+} EMU_EM23Init_TypeDef;
+
+typedef struct {
+	uint32_t	powerConfig;
+	uint32_t	dcdcMode;
+	uint16_t	mVout;
+} EMU_DCDCInit_TypeDef;
+
+#define EMU_EM23INIT_DEFAULT	{ false, emuVScaleEM23_FastWakeup }
+#define EMU_DCDCINIT_DEFAULT	{ 0, 0, 1800 }
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void EMU_EnterEM1(void);
+void EMU_EnterEM2(bool restore);
+void EMU_EnterEM3(bool restore);
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init);
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit);
+
+#endif
@@ -0,0 +1,51 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_GPCRC_HG
+#define	EM_GPCRC_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+/* Not trapped, the CRC is computed when the data is written */
+typedef struct {
+	uint32_t	poly;
+	uint32_t	init;
+	uint32_t	data;
+	bool		reverse_bits;
+	bool		reverse_bytes;
+} GPCRC_TypeDef;
+
+typedef struct {
+	uint32_t	crcPoly;
+	uint32_t	initValue;
+	bool		reverseByteOrder;
+	bool		reverseBits;
+	bool		enableByteMode;
+	bool		autoInit;
+	bool		enable;
+} GPCRC_Init_TypeDef;
+
+#define GPCRC_INIT_DEFAULT	{ 0x04C11DB7UL, 0x0UL, false, false, false, false, true }
+
+extern GPCRC_TypeDef		sim_gpcrc;
+#define GPCRC				(&sim_gpcrc)
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void GPCRC_Init(GPCRC_TypeDef *gpcrc, const GPCRC_Init_TypeDef *init);
+void GPCRC_Start(GPCRC_TypeDef *gpcrc);
+void GPCRC_InputU8(GPCRC_TypeDef *gpcrc, uint8_t data);
+void GPCRC_InputU16(GPCRC_TypeDef *gpcrc, uint16_t data);
+void GPCRC_InputU32(GPCRC_TypeDef *gpcrc, uint32_t data);
+uint32_t GPCRC_DataRead(GPCRC_TypeDef *gpcrc);
+
+#endif
@@ -0,0 +1,53 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_GPIO_HG
+#define	EM_GPIO_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+	gpioPortA,
+	gpioPortB,
+	gpioPortC,
+	gpioPortD,
+	gpioPortE,
+	gpioPortF,
+	gpioPortCount
+} GPIO_Port_TypeDef;
+
+typedef enum {
+	gpioModeDisabled,
+	gpioModeInput,
+	gpioModeInputPull,
+	gpioModePushPull,
+	gpioModeWiredAnd,
+	gpioModeWiredAndPullUp,
+} GPIO_Mode_TypeDef;
+
+typedef enum {
+	gpioDriveStrengthWeakAlternateWeak,
+	gpioDriveStrengthWeakAlternateStrong,
+	gpioDriveStrengthStrongAlternateWeak,
+	gpioDriveStrengthStrongAlternateStrong,
+} GPIO_DriveStrength_TypeDef;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out);
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+
+#endif
@@ -0,0 +1,40 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_I2C_HG
+#define	EM_I2C_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define I2C_FREQ_STANDARD_MAX	92000
+#define I2C_FREQ_FAST_MAX		392000
+#define I2C_FREQ_FASTPLUS_MAX	987000
+
+typedef enum {
+	i2cClockHLRStandard,
+	i2cClockHLRAsymetric,
+	i2cClockHLRFast,
+} I2C_ClockHLR_TypeDef;
+
+typedef struct {
+	bool					enable;
+	bool					master;
+	uint32_t				refFreq;
+	uint32_t				freq;
+	I2C_ClockHLR_TypeDef	clhr;
+} I2C_Init_TypeDef;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init);
+
+#endif
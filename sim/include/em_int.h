@@ -0,0 +1,13 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_INT_HG
+#define	EM_INT_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Simulator include statements */
+#include "em_core.h"
+
+#endif
@@ -0,0 +1,100 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_LDMA_HG
+#define	EM_LDMA_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LDMA_IF_ERROR		0x80000000UL
+#define _LDMA_IF_DONE_MASK	0x000000FFUL
+
+typedef enum {
+	ldmaPeripheralSignal_NONE			= SIM_LDMA_SIGNAL_NONE,
+	ldmaPeripheralSignal_LEUART0_TXBL	= SIM_LDMA_SIGNAL_LEUART0_TXBL,
+	ldmaPeripheralSignal_LEUART0_RXDATAV	= SIM_LDMA_SIGNAL_LEUART0_RXDATAV,
+} LDMA_PeripheralSignal_t;
+
+typedef enum {
+	ldmaLinkModeAbs,
+	ldmaLinkModeRel,
+} LDMA_LinkMode_t;
+
+typedef enum {
+	ldmaCtrlSizeByte,
+	ldmaCtrlSizeHalf,
+	ldmaCtrlSizeWord,
+} LDMA_CtrlSize_t;
+
+/* Addresses are pointer wide on the host */
+typedef union {
+	struct {
+		uint32_t	structType;
+		uint32_t	xferCnt;		// units minus one
+		uint32_t	blockSize;
+		uint32_t	doneIfs;
+		uint32_t	srcInc;			// 0 increments by one unit, 3 keeps the address
+		uint32_t	size;			// LDMA_CtrlSize_t
+		uint32_t	dstInc;
+		uint32_t	linkMode;		// LDMA_LinkMode_t
+		uint32_t	link;
+		uintptr_t	srcAddr;
+		uintptr_t	dstAddr;
+		intptr_t	linkAddr;		// relative, in words of a 4 word target descriptor
+	} xfer;
+} LDMA_Descriptor_t;
+
+typedef struct {
+	uint32_t	ldmaReqSel;			// LDMA_PeripheralSignal_t
+	uint32_t	ldmaCtrlSyncPrsClrOff;
+	uint32_t	ldmaCfgArbSlots;
+	uint32_t	ldmaCfgSrcIncSign;
+	uint32_t	ldmaCfgDstIncSign;
+	uint32_t	ldmaLoopCnt;
+} LDMA_TransferCfg_t;
+
+typedef struct {
+	uint8_t		ldmaInitCtrlNumFixed;
+	uint8_t		ldmaInitCtrlSyncPrsClrEn;
+	uint8_t		ldmaInitCtrlSyncPrsSetEn;
+	uint8_t		ldmaInitIrqPriority;
+} LDMA_Init_t;
+
+#define LDMA_INIT_DEFAULT						{ 0, 0, 0, 3 }
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal)	{ (signal), 0, 0, 0, 0, 0 }
+#define LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(src, dest, count)	\
+	{ .xfer = { .structType = 0, .xferCnt = (count) - 1, .blockSize = 0, .doneIfs = 1,	\
+				.srcInc = 0, .size = ldmaCtrlSizeByte, .dstInc = 3, .link = 0,			\
+				.srcAddr = (uintptr_t)(src), .dstAddr = (uintptr_t)(dest), .linkAddr = 0 } }
+#define LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(src, dest, count, linkjmp)	\
+	{ .xfer = { .structType = 0, .xferCnt = (count) - 1, .blockSize = 0, .doneIfs = 0,	\
+				.srcInc = 0, .size = ldmaCtrlSizeByte, .dstInc = 3,						\
+				.linkMode = ldmaLinkModeRel, .link = 1,									\
+				.srcAddr = (uintptr_t)(src), .dstAddr = (uintptr_t)(dest), .linkAddr = (linkjmp) * 4 } }
+#define LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(src, dest, count)	\
+	{ .xfer = { .structType = 0, .xferCnt = (count) - 1, .blockSize = 0, .doneIfs = 1,	\
+				.srcInc = 3, .size = ldmaCtrlSizeByte, .dstInc = 0, .link = 0,			\
+				.srcAddr = (uintptr_t)(src), .dstAddr = (uintptr_t)(dest), .linkAddr = 0 } }
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void LDMA_Init(const LDMA_Init_t *init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor);
+void LDMA_StopTransfer(int ch);
+bool LDMA_TransferDone(int ch);
+uint32_t LDMA_TransferRemainingCount(int ch);
+uint32_t LDMA_IntGetEnabled(void);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+void LDMA_IntDisable(uint32_t flags);
+
+#endif
@@ -0,0 +1,50 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_LETIMER_HG
+#define	EM_LETIMER_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+	letimerRepeatFree,
+	letimerRepeatOneshot,
+	letimerRepeatBuffered,
+	letimerRepeatDouble,
+} LETIMER_RepeatMode_TypeDef;
+
+typedef enum {
+	letimerUFOANone,
+	letimerUFOAToggle,
+	letimerUFOAPulse,
+	letimerUFOAPwm,
+} LETIMER_UFOA_TypeDef;
+
+typedef struct {
+	bool						enable;
+	bool						debugRun;
+	bool						comp0Top;
+	bool						bufTop;
+	uint8_t						out0Pol;
+	uint8_t						out1Pol;
+	LETIMER_UFOA_TypeDef		ufoa0;
+	LETIMER_UFOA_TypeDef		ufoa1;
+	LETIMER_RepeatMode_TypeDef	repMode;
+	uint32_t					topValue;
+} LETIMER_Init_TypeDef;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init);
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable);
+
+#endif
@@ -0,0 +1,79 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EM_RTCC_HG
+#define	EM_RTCC_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulator include statements */
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RTCC_IF_OF			0x00000001UL
+#define RTCC_IF_CC0			0x00000002UL
+#define RTCC_IF_CC1			0x00000004UL
+#define RTCC_IF_CC2			0x00000008UL
+#define RTCC_IEN_OF			RTCC_IF_OF
+#define RTCC_IEN_CC0		RTCC_IF_CC0
+#define RTCC_IEN_CC1		RTCC_IF_CC1
+#define RTCC_IEN_CC2		RTCC_IF_CC2
+
+typedef enum {
+	rtccCntPresc_1,
+	rtccCntPresc_2,
+	rtccCntPresc_4,
+	rtccCntPresc_8,
+} RTCC_CntPresc_TypeDef;
+
+typedef enum {
+	rtccCapComChModeOff,
+	rtccCapComChModeCapture,
+	rtccCapComChModeCompare,
+} RTCC_CapComChMode_TypeDef;
+
+typedef struct {
+	bool					enable;
+	bool					debugRun;
+	bool					precntWrapOnCCV0;
+	bool					cntWrapOnCCV1;
+	RTCC_CntPresc_TypeDef	presc;
+	uint32_t				prescMode;
+	bool					enaOSCFailDetect;
+	uint32_t				cntMode;
+	bool					disLeapYearCorr;
+} RTCC_Init_TypeDef;
+
+typedef struct {
+	RTCC_CapComChMode_TypeDef	chMode;
+	uint32_t					compMatchOutAction;
+	uint32_t					prsSel;
+	uint32_t					inputEdgeSel;
+	uint32_t					compBase;
+	uint8_t						compMask;
+	uint32_t					dayCompMode;
+} RTCC_CCChConf_TypeDef;
+
+#define RTCC_INIT_DEFAULT				{ true, false, false, false, rtccCntPresc_32768, 0, false, 0, false }
+#define RTCC_CH_INIT_COMPARE_DEFAULT	{ rtccCapComChModeCompare, 0, 0, 0, 0, 0, 0 }
+#define rtccCntPresc_32768				rtccCntPresc_8
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void RTCC_Init(const RTCC_Init_TypeDef *init);
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr);
+void RTCC_ChannelCCVSet(int ch, uint32_t value);
+uint32_t RTCC_ChannelCCVGet(int ch);
+uint32_t RTCC_CounterGet(void);
+void RTCC_IntEnable(uint32_t flags);
+void RTCC_IntDisable(uint32_t flags);
+void RTCC_IntClear(uint32_t flags);
+uint32_t RTCC_IntGet(void);
+uint32_t RTCC_IntGetEnabled(void);
+
+#endif
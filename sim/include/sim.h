@@ -0,0 +1,203 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	SIM_HG
+#define	SIM_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_NEVER			UINT64_MAX
+#define SIM_US(us)			((uint64_t)(us) * 1000u)
+#define SIM_MS(ms)			((uint64_t)(ms) * 1000000u)
+#define SIM_S(s)			((uint64_t)(s) * 1000000000u)
+#define SIM_NS_TO_S(ns)		((double)(ns) / 1e9)
+
+// CPU cost model, instructions are not counted
+#define SIM_REG_ACCESS_NS	100			// peripheral register access
+#define SIM_IRQ_NS			2000		// interrupt entry, handler and exit
+#define SIM_WAKE_NS			50000		// EM0 run time charged to every wakeup
+#define SIM_DMA_WAKE_NS		5000		// EM1 time of an LDMA request serviced from EM2
+
+// Energy model, EFM32PG12 datasheet typical currents from the 3.3 V DCDC
+#define SIM_VDD				3.3
+#define SIM_EM0_UA			1640.0		// 26 MHz HFRCO
+#define SIM_EM1_UA			1000.0
+#define SIM_EM2_UA			2.5
+#define SIM_EM3_UA			2.1
+#define SIM_EM4_UA			0.86
+#define SIM_EM_COUNT		5
+#define SIM_HM10_UA			8500.0		// HM-10 active mode, the firmware never puts it to sleep
+#define SIM_LEUART_UA		0.15		// LEUART on the LFXO while a frame is on the line
+
+// Energy modes, the same values as sleep_routines.h
+#define EM0					0
+#define EM1					1
+#define EM2					2
+#define EM3					3
+#define EM4					4
+
+// Clock domains an event runs on, see sim_clock_set()
+#define SIM_CLK_HF			0			// HFPERCLK, stops below EM1
+#define SIM_CLK_LFA			1			// LETIMER0
+#define SIM_CLK_LFB			2			// LEUART0
+#define SIM_CLK_LFE			3			// RTCC
+#define SIM_CLK_EXT			4			// devices outside the MCU, always running
+#define SIM_CLK_COUNT		5
+#define SIM_CLK_STOPPED		(-1)		// sim_clock_set() em_max of a stopped clock
+
+// Peripheral register blocks trapped by the simulator, one page each
+#define SIM_PAGE_LETIMER0	0
+#define SIM_PAGE_LEUART0	1
+#define SIM_PAGE_I2C0		2
+#define SIM_PAGE_I2C1		3
+#define SIM_PAGE_DWT		4
+#define SIM_PAGE_COUNT		5
+#define SIM_PAGE_SIZE		4096
+#define SIM_PAGE_NONE		SIM_PAGE_COUNT
+
+// LDMA request signals, see em_ldma.h
+#define SIM_LDMA_SIGNAL_NONE			0
+#define SIM_LDMA_SIGNAL_LEUART0_TXBL	1
+#define SIM_LDMA_SIGNAL_LEUART0_RXDATAV	2
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef void (*SIM_EVENT_FN)(void *ctx);
+
+/* A model's timed event, owned by the model */
+typedef struct SIM_EVENT {
+	struct SIM_EVENT	*next;
+	uint64_t			at;			// ns
+	uint32_t			clock;		// SIM_CLK_x, frozen while its clock is stopped
+	SIM_EVENT_FN		fn;
+	void				*ctx;
+	bool				active;
+} SIM_EVENT;
+
+/* Register hooks of a trapped peripheral, offsets are bytes into its block */
+typedef struct {
+	uint32_t	(*refresh)(void *ctx, uint32_t offset);					// value the CPU is about to access
+	void		(*read)(void *ctx, uint32_t offset);					// the CPU read it
+	void		(*write)(void *ctx, uint32_t offset, uint32_t value);	// the CPU wrote it
+	void		*ctx;
+} SIM_PERIPH_OPS;
+
+/* A device on a simulated I2C bus */
+typedef struct {
+	bool		(*address)(void *ctx, bool read);				// true to ACK
+	bool		(*write)(void *ctx, uint8_t data);				// true to ACK
+	uint8_t		(*read)(void *ctx, uint64_t *ready);			// next byte, SCL is held until ready
+	void		(*stop)(void *ctx);
+	void		*ctx;
+	uint32_t	addr;
+} SIM_I2C_SLAVE;
+
+/* Command line settings */
+typedef struct {
+	uint64_t	duration;			// ns of simulated time
+	double		temp_f;				// ambient temperature
+	double		temp_slope;			// F per hour
+	double		temp_swing;			// F amplitude of a sine on top
+	double		swing_period;		// s
+	double		temp_noise;			// F peak of uniform noise
+	double		rh;					// %RH
+	uint32_t	seed;
+	bool		ble_connected;		// a central is connected to the HM-10 at boot
+	bool		echo;				// copy BLE data to stderr
+	FILE		*capture;			// BLE data received by the central, or NULL
+	const char	*central_send;		// line the central writes once connected, or NULL
+	FILE		*report;
+	bool		json;				// report as a JSON object
+	uint32_t	hm10_baud;			// baud rate the HM-10 was left configured at
+} SIM_CONFIG_STRUCT;
+
+/* Counters printed by sim_finish() */
+typedef struct {
+	uint64_t	em_ns[SIM_EM_COUNT];
+	uint64_t	spin_ns;			// EM0 time spent polling a register
+	uint64_t	wakeups;
+	uint64_t	sleep_aborts;		// WFI with an interrupt already pending
+	uint64_t	irqs[64];
+	uint64_t	reg_accesses;
+	uint64_t	sync_violations;	// LE register written while SYNCBUSY
+	uint64_t	stalls;				// peripheral clock stopped by a too deep sleep
+	uint64_t	dma_wakeups;
+	uint64_t	dma_bytes;
+	uint64_t	i2c_transfers;		// START conditions
+	uint64_t	i2c_bytes;
+	uint64_t	i2c_nacks;
+	uint64_t	i2c_bus_ns;			// START to STOP
+	uint64_t	leuart_tx_bytes;
+	uint64_t	leuart_line_ns;		// transmit frames on the line
+	uint64_t	leuart_rx_bytes;
+	uint64_t	leuart_rx_dropped;
+	uint64_t	hm10_data_bytes;
+	uint64_t	hm10_commands;
+	uint64_t	hm10_garbled;		// bytes sent at the wrong baud rate
+	uint64_t	si7021_conversions;
+	double		si7021_charge_nc;
+	uint64_t	gpio_toggles;
+} SIM_STATS_STRUCT;
+
+extern SIM_CONFIG_STRUCT	sim_config;
+extern SIM_STATS_STRUCT		sim_stats;
+extern uint8_t				*sim_periph_base;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+static inline void *sim_page(uint32_t page){
+	return sim_periph_base + page * SIM_PAGE_SIZE;
+}
+
+/* sim.c, time, events, traps and interrupts */
+void sim_init(void);
+uint64_t sim_now(void);
+uint64_t sim_clock_now(uint32_t clock);
+void sim_clock_set(uint32_t clock, int32_t em_max);
+bool sim_clock_running(uint32_t clock);
+void sim_event_init(SIM_EVENT *ev, uint32_t clock, SIM_EVENT_FN fn, void *ctx);
+void sim_schedule(SIM_EVENT *ev, uint64_t at);
+void sim_cancel(SIM_EVENT *ev);
+void sim_cpu(uint64_t ns);
+void sim_sleep(uint32_t em);
+uint32_t sim_em(void);
+void sim_dma_wakeup(void);
+void sim_irq_level(uint32_t irq, bool level);
+void sim_irq_service(void);
+void sim_periph_register(uint32_t page, const SIM_PERIPH_OPS *ops);
+uint32_t sim_page_of(const volatile void *reg, uint32_t *offset);
+uint32_t sim_periph_read(const volatile void *reg);
+void sim_periph_write(const volatile void *reg, uint32_t value);
+void sim_warn(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void sim_fail(const char *fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
+void sim_finish(void) __attribute__((noreturn));
+
+/* sim_main.c */
+void sim_report(void);
+
+/* sim_cmu.c */
+void sim_cmu_init(void);
+uint32_t sim_cmu_lf_hz(uint32_t clock);
+
+/* peripheral models */
+void sim_letimer_init(void);
+void sim_rtcc_init(void);
+void sim_i2c_init(void);
+void sim_i2c_attach(uint32_t page, const SIM_I2C_SLAVE *slave);
+void sim_leuart_init(void);
+void sim_leuart_rx(uint8_t data, uint32_t baud);
+bool sim_leuart_signal(uint32_t signal);
+void sim_ldma_request(void);
+void sim_si7021_init(void);
+void sim_hm10_init(void);
+void sim_hm10_rx(uint8_t data, uint32_t baud);
+
+#endif
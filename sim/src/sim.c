@@ -0,0 +1,829 @@
+/**
+ * @file sim.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Core of the host simulator: simulated time and its event list, the
+ * energy mode the CPU sleeps in, interrupts, and the traps that connect the
+ * drivers' register accesses to the peripheral models.
+ *
+ * The peripheral register blocks sit in pages mapped without access. A driver
+ * access faults, the page is opened, the model refreshes the register and the
+ * faulting instruction is single stepped; the model then sees the value the
+ * driver wrote or the read it made, and the page is closed again. The drivers
+ * therefore compile unchanged, x86-64 Linux only.
+ *
+ * Interrupts are taken where the CPU could have been interrupted and the
+ * simulator has control: leaving a critical section, enabling an IRQ and
+ * waking from sleep. Time advances while the CPU sleeps, while it polls a
+ * register, and by a fixed cost per register access, interrupt and wakeup.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "em_device.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_TF				0x100		// x86 EFLAGS trap flag
+#define SIM_PF_WRITE		0x2			// page fault error code, write access
+#define SIM_SPIN_READS		2			// identical reads in a row before it is a poll loop
+#define SIM_WARN_MAX		20			// warnings printed, the rest only counted
+#define SIM_IRQ_STORM		100000		// interrupts in a row without time passing
+#define SIM_WATCHDOG_S		3			// wall clock seconds without progress
+#define IRQ_PRIORITY_BYTE(i)	(irq_priority[i] << (8 - __NVIC_PRIO_BITS))	// as the NVIC IPR field
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+SIM_CONFIG_STRUCT		sim_config;
+SIM_STATS_STRUCT		sim_stats;
+uint8_t					*sim_periph_base;
+
+static uint64_t			now;
+static uint32_t			current_em;
+static uint64_t			sleep_borrow;				// EM1 time of LDMA requests during a sleep
+static SIM_EVENT		*event_head;				// pending events, earliest first
+static int32_t			clock_em_max[SIM_CLK_COUNT];
+static uint64_t			clock_frozen[SIM_CLK_COUNT];	// time a clock stood still
+static const char		*clock_name[SIM_CLK_COUNT] = { "HFPER", "LFA", "LFB", "LFE", "external" };
+
+static const SIM_PERIPH_OPS	*periph_ops[SIM_PAGE_COUNT];
+
+static struct {
+	uint32_t			page;
+	uint32_t			offset;
+	bool				write;
+	uint32_t			before;
+	volatile uint32_t	*reg;
+	uint8_t				*spin_addr;				// last register read, for poll detection
+	uint32_t			spin_value;
+	uint32_t			spin_reads;				// reads of it in a row with that value
+} trap;
+
+static bool				primask;
+static uint32_t			basepri;
+static uint32_t			prigroup;
+static bool				exclusive;				// local monitor of LDREX/STREX
+static uint64_t			irq_enabled;
+static uint64_t			irq_level;
+static uint64_t			irq_active;
+static uint8_t			irq_priority[SIM_IRQ_COUNT];
+static uint32_t			irq_storm;
+static uint64_t			irq_storm_time;
+
+CoreDebug_Type			sim_core_debug;
+static struct {
+	uint32_t			ctrl;
+	uint32_t			base;						// CYCCNT at the last write
+	uint64_t			since;						// core time of the last write
+} dwt;
+
+static volatile uint64_t	progress;
+static uint64_t			watchdog_progress;
+static uint32_t			watchdog_idle;
+static uint64_t			warnings;
+
+extern void LDMA_IRQHandler(void) __attribute__((weak));
+extern void I2C0_IRQHandler(void) __attribute__((weak));
+extern void LEUART0_IRQHandler(void) __attribute__((weak));
+extern void LETIMER0_IRQHandler(void) __attribute__((weak));
+extern void RTCC_IRQHandler(void) __attribute__((weak));
+extern void I2C1_IRQHandler(void) __attribute__((weak));
+
+static void (*const irq_handler[SIM_IRQ_COUNT])(void) = {
+	[LDMA_IRQn]		= LDMA_IRQHandler,
+	[I2C0_IRQn]		= I2C0_IRQHandler,
+	[LEUART0_IRQn]	= LEUART0_IRQHandler,
+	[LETIMER0_IRQn]	= LETIMER0_IRQHandler,
+	[RTCC_IRQn]		= RTCC_IRQHandler,
+	[I2C1_IRQn]		= I2C1_IRQHandler,
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true if events of a clock domain run in an energy mode
+ *
+ ******************************************************************************/
+static bool clock_runs(uint32_t clock, uint32_t em){
+	return clock_em_max[clock] >= (int32_t)em;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the earliest pending event that can run in an energy mode
+ *
+ ******************************************************************************/
+static SIM_EVENT *next_event(uint32_t em){
+	for(SIM_EVENT *ev = event_head; ev != NULL; ev = ev->next){
+		if(clock_runs(ev->clock, em)) return ev;
+	}
+	return NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Runs the events due up to a time in the current energy mode
+ *
+ * @details
+ *	Time is set to each event before it runs, so a model sees the time it
+ *	was scheduled for, then to the end time.
+ *
+ ******************************************************************************/
+static void advance(uint64_t to){
+	SIM_EVENT *ev;
+	while(((ev = next_event(current_em)) != NULL) && (ev->at <= to)){
+		sim_cancel(ev);
+		if(ev->at > now) now = ev->at;
+		ev->fn(ev->ctx);
+		progress++;
+	}
+	if(to > now) now = to;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Preemption group of a priority byte, bits [7:PRIGROUP + 1]
+ *
+ ******************************************************************************/
+static uint32_t irq_group(uint32_t priority){
+	return (priority & 0xFF) >> (prigroup + 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true if an enabled interrupt that BASEPRI lets through is
+ *	pending, what ends a WFI
+ *
+ ******************************************************************************/
+static bool irq_wakeup_pending(void){
+	uint64_t pending = irq_level & irq_enabled & ~irq_active;
+	for(uint32_t i = 0; basepri && (i < SIM_IRQ_COUNT); i++){
+		if(irq_group(IRQ_PRIORITY_BYTE(i)) >= irq_group(basepri)) pending &= ~(1ull << i);
+	}
+	return pending != 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Highest priority interrupt that may preempt what runs now, or -1
+ *
+ ******************************************************************************/
+static int32_t irq_next(void){
+	uint32_t running = 0x100;
+	for(uint32_t i = 0; i < SIM_IRQ_COUNT; i++){
+		if((irq_active & (1ull << i)) && (irq_group(IRQ_PRIORITY_BYTE(i)) < running)){
+			running = irq_group(IRQ_PRIORITY_BYTE(i));
+		}
+	}
+	if(basepri && (irq_group(basepri) < running)) running = irq_group(basepri);
+	int32_t best = -1;
+	uint64_t ready = irq_level & irq_enabled & ~irq_active;
+	for(uint32_t i = 0; i < SIM_IRQ_COUNT; i++){
+		if(!(ready & (1ull << i)) || (irq_group(IRQ_PRIORITY_BYTE(i)) >= running)) continue;
+		if((best < 0) || (irq_priority[i] < irq_priority[best])) best = i;
+	}
+	return best;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Page fault on a peripheral page, the CPU is about to access a register
+ *
+ * @details
+ *	Opens the page, lets the model refresh the register and sets the trap
+ *	flag so sim_step() runs after the access. A fault anywhere else is a real
+ *	crash: the default action is restored and the access faults again.
+ *
+ ******************************************************************************/
+static void sim_fault(int sig, siginfo_t *info, void *context){
+	ucontext_t *uc = context;
+	uint8_t *addr = info->si_addr;
+	if((addr < sim_periph_base) || (addr >= sim_periph_base + SIM_PAGE_COUNT * SIM_PAGE_SIZE)){
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+	uint32_t off = addr - sim_periph_base;
+	trap.page = off / SIM_PAGE_SIZE;
+	trap.offset = (off % SIM_PAGE_SIZE) & ~3u;
+	trap.write = uc->uc_mcontext.gregs[REG_ERR] & SIM_PF_WRITE;
+	trap.reg = (volatile uint32_t *)(sim_periph_base + trap.page * SIM_PAGE_SIZE + trap.offset);
+	mprotect(sim_page(trap.page), SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+
+	sim_stats.reg_accesses++;
+	progress++;
+	sim_cpu(SIM_REG_ACCESS_NS);
+
+	const SIM_PERIPH_OPS *ops = periph_ops[trap.page];
+	uint32_t value = ops ? ops->refresh(ops->ctx, trap.offset) : 0;
+	if(!trap.write && ((uint8_t *)trap.reg == trap.spin_addr) && (value == trap.spin_value)
+			&& (trap.spin_reads >= SIM_SPIN_READS)){
+		// polled without a change: nothing the CPU does can change it, skip ahead
+		SIM_EVENT *ev = next_event(EM0);
+		if(ev == NULL) sim_fail("CPU polls page %u offset 0x%x with nothing pending", trap.page, trap.offset);
+		uint64_t start = now;
+		sim_cpu(ev->at > now ? ev->at - now : 0);
+		sim_stats.spin_ns += now - start;
+		value = ops ? ops->refresh(ops->ctx, trap.offset) : 0;
+	}
+	*trap.reg = value;
+	trap.before = value;
+	uc->uc_mcontext.gregs[REG_EFL] |= SIM_TF;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Single step trap after a register access
+ *
+ * @details
+ *	Hands the access to the model and closes the page. A write of the value
+ *	already held is still reported when the fault said write.
+ *
+ ******************************************************************************/
+static void sim_step(int sig, siginfo_t *info, void *context){
+	ucontext_t *uc = context;
+	uc->uc_mcontext.gregs[REG_EFL] &= ~SIM_TF;
+	uint32_t value = *trap.reg;
+	mprotect(sim_page(trap.page), SIM_PAGE_SIZE, PROT_NONE);
+
+	const SIM_PERIPH_OPS *ops = periph_ops[trap.page];
+	if(trap.write || (value != trap.before)){
+		trap.spin_addr = NULL;
+		trap.spin_reads = 0;
+		if(ops) ops->write(ops->ctx, trap.offset, value);
+	} else {
+		if(((uint8_t *)trap.reg == trap.spin_addr) && (value == trap.spin_value)) trap.spin_reads++;
+		else trap.spin_reads = 1;
+		trap.spin_addr = (uint8_t *)trap.reg;
+		trap.spin_value = value;
+		if(ops) ops->read(ops->ctx, trap.offset);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Prints the report and exits
+ *
+ ******************************************************************************/
+static void finish(int status) __attribute__((noreturn));
+static void finish(int status){
+	setitimer(ITIMER_REAL, &(struct itimerval){ { 0, 0 }, { 0, 0 } }, NULL);
+	sim_report();
+	if(sim_config.capture) fclose(sim_config.capture);
+	fflush(NULL);
+	exit(status);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Wall clock watchdog, ends a CPU that spins on RAM forever
+ *
+ * @details
+ *	A loop that never touches a peripheral never gives the simulator control,
+ *	so simulated time cannot reach what the loop waits for.
+ *
+ ******************************************************************************/
+static void sim_watchdog(int sig){
+	if(progress != watchdog_progress){
+		watchdog_progress = progress;
+		watchdog_idle = 0;
+		return;
+	}
+	if(++watchdog_idle < SIM_WATCHDOG_S) return;
+	static const char msg[] = "sim: the CPU spins without touching a peripheral, an interrupt it waits for is never taken\n";
+	if(write(2, msg, sizeof(msg) - 1) < 0) _exit(3);
+	_exit(3);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	DWT CYCCNT, the HF clock cycles of the time the core ran, EM0 and EM1
+ *
+ ******************************************************************************/
+static uint64_t core_ns(void){
+	return sim_stats.em_ns[EM0] + sim_stats.em_ns[EM1];
+}
+
+static uint32_t dwt_cyccnt(void){
+	if(!(dwt.ctrl & DWT_CTRL_CYCCNTENA_Msk) || !(sim_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk)) return dwt.base;
+	return dwt.base + (uint32_t)(((core_ns() - dwt.since) * (CMU_ClockFreqGet(cmuClock_HF) / 1000)) / 1000000);
+}
+
+static uint32_t dwt_refresh(void *ctx, uint32_t offset){
+	switch(offset){
+		case offsetof(DWT_Type, CTRL):		return dwt.ctrl;
+		case offsetof(DWT_Type, CYCCNT):	return dwt_cyccnt();
+		default:							return 0;
+	}
+}
+
+static void dwt_read(void *ctx, uint32_t offset){
+}
+
+static void dwt_write(void *ctx, uint32_t offset, uint32_t value){
+	switch(offset){
+		case offsetof(DWT_Type, CTRL):
+			dwt.base = dwt_cyccnt();
+			dwt.ctrl = value;
+			break;
+		case offsetof(DWT_Type, CYCCNT):
+			dwt.base = value;
+			break;
+		default:
+			return;
+	}
+	dwt.since = core_ns();
+}
+
+static const SIM_PERIPH_OPS dwt_ops = { dwt_refresh, dwt_read, dwt_write, NULL };
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Maps the peripheral pages and installs the trap handlers
+ *
+ ******************************************************************************/
+void sim_init(void){
+	sim_periph_base = mmap(NULL, SIM_PAGE_COUNT * SIM_PAGE_SIZE, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(sim_periph_base == MAP_FAILED) sim_fail("cannot map the peripheral pages");
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sigfillset(&sa.sa_mask);
+	sa.sa_flags = SA_SIGINFO;
+	sa.sa_sigaction = sim_fault;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = sim_step;
+	sigaction(SIGTRAP, &sa, NULL);
+	sa.sa_flags = SA_RESTART;
+	sa.sa_handler = sim_watchdog;
+	sigaction(SIGALRM, &sa, NULL);
+	struct itimerval tick = { { 1, 0 }, { 1, 0 } };
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	for(uint32_t i = 0; i < SIM_CLK_COUNT; i++) clock_em_max[i] = SIM_CLK_STOPPED;
+	clock_em_max[SIM_CLK_EXT] = SIM_EM_COUNT;
+	memset(irq_priority, 0, sizeof(irq_priority));
+	sim_periph_register(SIM_PAGE_DWT, &dwt_ops);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the simulated time in ns
+ *
+ ******************************************************************************/
+uint64_t sim_now(void){
+	return now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the time a clock domain has run, in ns
+ *
+ * @details
+ *	Less than sim_now() by the time the clock stood still in a too deep
+ *	sleep, so counters driven by it do not jump.
+ *
+ ******************************************************************************/
+uint64_t sim_clock_now(uint32_t clock){
+	return now - clock_frozen[clock];
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sets the deepest energy mode a clock domain runs in
+ *
+ * @param[in] em_max
+ *	EM0 to EM4, or SIM_CLK_STOPPED while its oscillator is off.
+ *
+ ******************************************************************************/
+void sim_clock_set(uint32_t clock, int32_t em_max){
+	clock_em_max[clock] = em_max;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true if a clock domain runs in the energy mode the CPU is in
+ *
+ ******************************************************************************/
+bool sim_clock_running(uint32_t clock){
+	return clock_runs(clock, current_em);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Initializes a model's event
+ *
+ ******************************************************************************/
+void sim_event_init(SIM_EVENT *ev, uint32_t clock, SIM_EVENT_FN fn, void *ctx){
+	ev->next = NULL;
+	ev->at = 0;
+	ev->clock = clock;
+	ev->fn = fn;
+	ev->ctx = ctx;
+	ev->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Schedules an event, rescheduling it if it was pending
+ *
+ * @note
+ *	Events at the same time run in the order they were scheduled.
+ *
+ ******************************************************************************/
+void sim_schedule(SIM_EVENT *ev, uint64_t at){
+	if(ev->active) sim_cancel(ev);
+	ev->at = at;
+	SIM_EVENT **link = &event_head;
+	while((*link != NULL) && ((*link)->at <= at)) link = &(*link)->next;
+	ev->next = *link;
+	*link = ev;
+	ev->active = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Removes an event if it is pending
+ *
+ ******************************************************************************/
+void sim_cancel(SIM_EVENT *ev){
+	if(!ev->active) return;
+	SIM_EVENT **link = &event_head;
+	while(*link != ev) link = &(*link)->next;
+	*link = ev->next;
+	ev->next = NULL;
+	ev->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	The CPU runs for a time in EM0
+ *
+ * @details
+ *	Events due in that time run. Ends the simulation once its duration has
+ *	passed.
+ *
+ ******************************************************************************/
+void sim_cpu(uint64_t ns){
+	uint64_t start = now;
+	advance(now + ns);
+	sim_stats.em_ns[EM0] += now - start;
+	if(now >= sim_config.duration) sim_finish();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	WFI in an energy mode
+ *
+ * @details
+ *	Returns at once when an enabled interrupt is pending. Otherwise time
+ *	jumps from event to event, running only the clock domains alive in this
+ *	mode, until an enabled interrupt becomes pending. Events of the domains
+ *	that stood still are delayed by the time slept and counted as stalls.
+ *	The wakeup is charged SIM_WAKE_NS of EM0.
+ *
+ ******************************************************************************/
+void sim_sleep(uint32_t em){
+	if(irq_wakeup_pending()){
+		sim_stats.sleep_aborts++;
+		return;
+	}
+	uint64_t start = now;
+	current_em = em;
+	sleep_borrow = 0;
+	while(!irq_wakeup_pending()){
+		SIM_EVENT *ev = next_event(em);
+		if(ev == NULL) sim_fail("sleeping in EM%u with no wake source", em);
+		if(ev->at >= sim_config.duration){
+			advance(sim_config.duration);
+			break;
+		}
+		advance(ev->at);
+	}
+	uint64_t slept = now - start;
+	sim_stats.em_ns[em] += slept - sleep_borrow;
+	current_em = EM0;
+
+	// the clocks that could not run in this mode lost the time slept
+	for(uint32_t clock = 0; clock < SIM_CLK_COUNT; clock++){
+		if(clock_runs(clock, em) || !clock_runs(clock, EM0)) continue;
+		bool pending = false;
+		for(SIM_EVENT *ev = event_head; ev != NULL; ev = ev->next){
+			if(ev->clock == clock) pending = true;
+		}
+		clock_frozen[clock] += slept;
+		if(!pending) continue;
+		sim_stats.stalls++;
+		sim_warn("%s clock stopped with work pending for %.6f s in EM%u", clock_name[clock], SIM_NS_TO_S(slept), em);
+		SIM_EVENT *frozen = NULL;
+		for(SIM_EVENT *ev = event_head, *next; ev != NULL; ev = next){
+			next = ev->next;
+			if(ev->clock != clock) continue;
+			sim_cancel(ev);
+			ev->next = frozen;
+			frozen = ev;
+		}
+		while(frozen != NULL){
+			SIM_EVENT *ev = frozen;
+			frozen = ev->next;
+			sim_schedule(ev, ev->at + slept);
+		}
+	}
+	if(now >= sim_config.duration) sim_finish();
+	sim_stats.wakeups++;
+	sim_cpu(SIM_WAKE_NS);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the energy mode the CPU is in, EM0 while it runs
+ *
+ ******************************************************************************/
+uint32_t sim_em(void){
+	return current_em;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	An LDMA request serviced while the CPU sleeps in EM2 or EM3
+ *
+ * @details
+ *	The system wakes to EM1 for the transfer and goes back to sleep without
+ *	waking the CPU, SIM_DMA_WAKE_NS is moved from the sleep to EM1.
+ *
+ ******************************************************************************/
+void sim_dma_wakeup(void){
+	if(current_em < EM2) return;
+	sim_stats.dma_wakeups++;
+	sim_stats.em_ns[EM1] += SIM_DMA_WAKE_NS;
+	sleep_borrow += SIM_DMA_WAKE_NS;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sets the level of a peripheral interrupt line, IF & IEN of the model
+ *
+ ******************************************************************************/
+void sim_irq_level(uint32_t irq, bool level){
+	if(level) irq_level |= 1ull << irq;
+	else irq_level &= ~(1ull << irq);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Takes the interrupts that are pending, enabled and not masked
+ *
+ * @details
+ *	A handler preempts another only with a higher priority, so nothing
+ *	nests at equal priority. Each interrupt costs SIM_IRQ_NS of EM0.
+ *
+ ******************************************************************************/
+void sim_irq_service(void){
+	int32_t irq;
+	while(!primask && ((irq = irq_next()) >= 0)){
+		if(irq_handler[irq] == NULL) sim_fail("IRQ %d has no handler", irq);
+		if(now != irq_storm_time){
+			irq_storm_time = now;
+			irq_storm = 0;
+		}
+		if(++irq_storm > SIM_IRQ_STORM) sim_fail("IRQ %d keeps firing, its flag is not cleared", irq);
+		sim_stats.irqs[irq]++;
+		exclusive = false;				// an exception clears the local monitor
+		irq_active |= 1ull << irq;
+		irq_handler[irq]();
+		irq_active &= ~(1ull << irq);
+		primask = false;				// exception return restores what the handler changed
+		sim_cpu(SIM_IRQ_NS);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Connects a trapped page to its model
+ *
+ ******************************************************************************/
+void sim_periph_register(uint32_t page, const SIM_PERIPH_OPS *ops){
+	periph_ops[page] = ops;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the page of a register and its offset, SIM_PAGE_NONE if it is
+ *	not a peripheral register
+ *
+ ******************************************************************************/
+uint32_t sim_page_of(const volatile void *reg, uint32_t *offset){
+	const uint8_t *addr = (const uint8_t *)reg;
+	if((addr < sim_periph_base) || (addr >= sim_periph_base + SIM_PAGE_COUNT * SIM_PAGE_SIZE)) return SIM_PAGE_NONE;
+	if(offset) *offset = (addr - sim_periph_base) % SIM_PAGE_SIZE;
+	return (addr - sim_periph_base) / SIM_PAGE_SIZE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A bus master other than the CPU reads a register, for the LDMA
+ *
+ ******************************************************************************/
+uint32_t sim_periph_read(const volatile void *reg){
+	uint32_t offset;
+	uint32_t page = sim_page_of(reg, &offset);
+	if((page == SIM_PAGE_NONE) || (periph_ops[page] == NULL)) sim_fail("LDMA read from %p is not a register", (const void *)reg);
+	uint32_t value = periph_ops[page]->refresh(periph_ops[page]->ctx, offset);
+	periph_ops[page]->read(periph_ops[page]->ctx, offset);
+	return value;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A bus master other than the CPU writes a register, for the LDMA
+ *
+ ******************************************************************************/
+void sim_periph_write(const volatile void *reg, uint32_t value){
+	uint32_t offset;
+	uint32_t page = sim_page_of(reg, &offset);
+	if((page == SIM_PAGE_NONE) || (periph_ops[page] == NULL)) sim_fail("LDMA write to %p is not a register", (const void *)reg);
+	periph_ops[page]->write(periph_ops[page]->ctx, offset, value);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Reports a suspicious condition, the run goes on
+ *
+ ******************************************************************************/
+void sim_warn(const char *fmt, ...){
+	if(++warnings > SIM_WARN_MAX) return;
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "sim: %.6f s: ", SIM_NS_TO_S(now));
+	vfprintf(stderr, fmt, ap);
+	fputc('\n', stderr);
+	va_end(ap);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Ends the run on an error, with the report so far
+ *
+ ******************************************************************************/
+void sim_fail(const char *fmt, ...){
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "sim: %.6f s: error: ", SIM_NS_TO_S(now));
+	vfprintf(stderr, fmt, ap);
+	fputc('\n', stderr);
+	va_end(ap);
+	finish(2);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Ends the run once its duration has passed
+ *
+ ******************************************************************************/
+void sim_finish(void){
+	finish(0);
+}
+
+//***********************************************************************************
+// Cortex-M4 core and emlib CORE/EMU
+//***********************************************************************************
+
+void NVIC_EnableIRQ(IRQn_Type irq){
+	irq_enabled |= 1ull << irq;
+	sim_irq_service();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq){
+	irq_enabled &= ~(1ull << irq);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq){
+	// pending is the level of the peripheral flags, cleared with them
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority){
+	irq_priority[irq] = priority;
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq){
+	return irq_priority[irq];
+}
+
+void NVIC_SetPriorityGrouping(uint32_t group){
+	prigroup = group & 7;
+}
+
+uint32_t NVIC_GetPriorityGrouping(void){
+	return prigroup;
+}
+
+void __disable_irq(void){
+	primask = true;
+}
+
+void __enable_irq(void){
+	primask = false;
+	sim_irq_service();
+}
+
+uint32_t __get_PRIMASK(void){
+	return primask;
+}
+
+uint32_t __get_BASEPRI(void){
+	return basepri;
+}
+
+void __set_BASEPRI(uint32_t value){
+	basepri = value & 0xFF;
+	sim_irq_service();
+}
+
+void __set_BASEPRI_MAX(uint32_t value){
+	value &= 0xFF;
+	if(value && (!basepri || (value < basepri))) basepri = value;
+}
+
+uint32_t __LDREXW(volatile uint32_t *addr){
+	exclusive = true;
+	return *addr;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr){
+	if(!exclusive) return 1;
+	exclusive = false;
+	*addr = value;
+	return 0;
+}
+
+void __CLREX(void){
+	exclusive = false;
+}
+
+CORE_irqState_t CORE_EnterCritical(void){
+	CORE_irqState_t state = primask;
+	primask = true;
+	return state;
+}
+
+void CORE_ExitCritical(CORE_irqState_t irqState){
+	primask = irqState;
+	sim_irq_service();
+}
+
+CORE_irqState_t CORE_EnterAtomic(void){
+	return CORE_EnterCritical();
+}
+
+void CORE_ExitAtomic(CORE_irqState_t irqState){
+	CORE_ExitCritical(irqState);
+}
+
+void EMU_EnterEM1(void){
+	sim_sleep(EM1);
+}
+
+void EMU_EnterEM2(bool restore){
+	sim_sleep(EM2);
+}
+
+void EMU_EnterEM3(bool restore){
+	sim_sleep(EM3);
+}
+
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init){
+}
+
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit){
+	return true;
+}
+
+void assertEFM(const char *file, int line){
+	sim_fail("EFM_ASSERT failed at %s:%d", file, line);
+}
@@ -0,0 +1,191 @@
+/**
+ * @file sim_cmu.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Clock management and GPIO models of the host simulator
+ *
+ * The CMU model tracks the oscillators, the LF clock tree selects and the
+ * clock enables and tells the simulator core, through sim_clock_set(), the
+ * deepest energy mode each clock domain keeps running in. GPIO only keeps
+ * the output latches and counts the edges the application drives.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_ULFRCO_HZ		1000
+#define SIM_LFXO_HZ			32768
+#define SIM_LFRCO_HZ		32768
+#define SIM_GPIO_PINS		16
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static bool					osc_on[cmuOsc_COUNT];
+static bool					clock_on[cmuClock_COUNT];
+static CMU_Select_TypeDef	lf_select[SIM_CLK_COUNT];
+static uint32_t				hfrco_hz;
+static uint16_t				gpio_out[gpioPortCount];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Oscillator behind an LF clock select, cmuOsc_COUNT if none
+ *
+ ******************************************************************************/
+static CMU_Osc_TypeDef select_osc(CMU_Select_TypeDef ref){
+	switch(ref){
+		case cmuSelect_LFXO:
+			return cmuOsc_LFXO;
+		case cmuSelect_LFRCO:
+			return cmuOsc_LFRCO;
+		case cmuSelect_ULFRCO:
+			return cmuOsc_ULFRCO;
+		default:
+			return cmuOsc_COUNT;
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Recomputes the deepest energy mode of every clock domain
+ *
+ * @details
+ *	The ULFRCO keeps running in EM3, the LFXO and LFRCO stop below EM2 and
+ *	the HF peripheral clock below EM1. The LE domains also need CORELE.
+ *
+ ******************************************************************************/
+static void update_domains(void){
+	sim_clock_set(SIM_CLK_HF, clock_on[cmuClock_HFPER] ? EM1 : SIM_CLK_STOPPED);
+	for(uint32_t clock = SIM_CLK_LFA; clock <= SIM_CLK_LFE; clock++){
+		CMU_Osc_TypeDef osc = select_osc(lf_select[clock]);
+		int32_t em_max = SIM_CLK_STOPPED;
+		if((osc != cmuOsc_COUNT) && osc_on[osc] && clock_on[cmuClock_CORELE]){
+			em_max = (osc == cmuOsc_ULFRCO) ? EM3 : EM2;
+		}
+		sim_clock_set(clock, em_max);
+	}
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Reset state of the CMU, HFRCO at 19 MHz and the ULFRCO always on
+ *
+ ******************************************************************************/
+void sim_cmu_init(void){
+	osc_on[cmuOsc_HFRCO] = true;
+	osc_on[cmuOsc_ULFRCO] = true;
+	osc_on[cmuOsc_LFRCO] = false;
+	osc_on[cmuOsc_LFXO] = false;
+	hfrco_hz = cmuHFRCOFreq_19M0Hz;
+	clock_on[cmuClock_HF] = true;
+	update_domains();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Frequency of a clock domain in Hz, 0 while it is stopped
+ *
+ ******************************************************************************/
+uint32_t sim_cmu_lf_hz(uint32_t clock){
+	if(clock == SIM_CLK_HF) return clock_on[cmuClock_HFPER] ? hfrco_hz : 0;
+	CMU_Osc_TypeDef osc = select_osc(lf_select[clock]);
+	if((osc == cmuOsc_COUNT) || !osc_on[osc]) return 0;
+	return (osc == cmuOsc_ULFRCO) ? SIM_ULFRCO_HZ : (osc == cmuOsc_LFXO) ? SIM_LFXO_HZ : SIM_LFRCO_HZ;
+}
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable){
+	clock_on[clock] = enable;
+	update_domains();
+}
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref){
+	switch(clock){
+		case cmuClock_LFA:
+			lf_select[SIM_CLK_LFA] = ref;
+			break;
+		case cmuClock_LFB:
+			lf_select[SIM_CLK_LFB] = ref;
+			break;
+		case cmuClock_LFE:
+			lf_select[SIM_CLK_LFE] = ref;
+			break;
+		case cmuClock_HF:
+			if(!osc_on[ref == cmuSelect_HFXO ? cmuOsc_HFXO : cmuOsc_HFRCO]) sim_fail("HFCLK selects an oscillator that is off");
+			break;
+		default:
+			sim_fail("CMU_ClockSelectSet() on clock %d", clock);
+	}
+	update_domains();
+}
+
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait){
+	osc_on[osc] = enable;
+	update_domains();
+}
+
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef freq){
+	hfrco_hz = freq;
+}
+
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit){
+}
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock){
+	switch(clock){
+		case cmuClock_LFA:
+		case cmuClock_LETIMER0:
+			return sim_cmu_lf_hz(SIM_CLK_LFA);
+		case cmuClock_LFB:
+		case cmuClock_LEUART0:
+			return sim_cmu_lf_hz(SIM_CLK_LFB);
+		case cmuClock_LFE:
+		case cmuClock_RTCC:
+			return sim_cmu_lf_hz(SIM_CLK_LFE);
+		default:
+			return hfrco_hz;
+	}
+}
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out){
+	EFM_ASSERT((port < gpioPortCount) && (pin < SIM_GPIO_PINS));
+	if(out) gpio_out[port] |= 1u << pin;
+	else gpio_out[port] &= ~(1u << pin);
+}
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength){
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin){
+	if(!(gpio_out[port] & (1u << pin))) sim_stats.gpio_toggles++;
+	gpio_out[port] |= 1u << pin;
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin){
+	if(gpio_out[port] & (1u << pin)) sim_stats.gpio_toggles++;
+	gpio_out[port] &= ~(1u << pin);
+}
+
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin){
+	sim_stats.gpio_toggles++;
+	gpio_out[port] ^= 1u << pin;
+}
+
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin){
+	return (gpio_out[port] >> pin) & 1u;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file sim_hm10.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief HM-10 BLE module model of the host simulator
+ *
+ * Not connected, the module takes AT commands: a command ends when no byte
+ * follows for SIM_HM10_GAP_MS, there is no line ending. The ones the
+ * application and its tests use are answered, at the module's baud rate:
+ * AT, AT+NAME, AT+ADVI, AT+POWE, AT+RESET, AT+BAUD, AT+ADDR? and AT+VERS?.
+ * A new baud rate takes effect at the next reset, as on the module.
+ *
+ * Connected, every byte is data for the central: it is counted, written to
+ * the capture file and optionally echoed. A lone "AT" still ends the
+ * connection with OK+LOST. With --ble-connected the central connects
+ * SIM_HM10_CONNECT_MS after the module starts advertising, at power up,
+ * after a reset or after a lost connection, and the module reports OK+CONN.
+ * The central then writes the --central-send line, with a LF, which the
+ * module forwards to the MCU.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <ctype.h>
+#include <string.h>
+
+#include "sim.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_HM10_GAP_MS			10			// silence that ends an AT command
+#define SIM_HM10_BOOT_MS		500			// deaf after AT+RESET
+#define SIM_HM10_CONNECT_MS		2000		// advertising until the central connects
+#define SIM_HM10_CMD_MAX		32
+#define SIM_HM10_REPLY_MAX		64
+#define SIM_HM10_NAME_MAX		12
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const uint32_t	baud_codes[] = { 9600, 19200, 38400, 57600, 115200, 4800, 2400, 1200, 230400 };
+
+static struct {
+	uint32_t	baud;
+	uint32_t	baud_code;			// active
+	uint32_t	next_baud_code;		// after the next reset
+	bool		connected;
+	bool		booting;
+	char		name[SIM_HM10_NAME_MAX + 1];
+	char		adv_interval;		// AT+ADVI code
+	char		tx_power;			// AT+POWE code
+	char		cmd[SIM_HM10_CMD_MAX + 1];
+	uint32_t	cmd_len;			// bytes since the last gap, may exceed SIM_HM10_CMD_MAX
+	char		reply[SIM_HM10_REPLY_MAX];
+	uint32_t	reply_head;
+	uint32_t	reply_len;
+	SIM_EVENT	gap_ev;
+	SIM_EVENT	reply_ev;
+	SIM_EVENT	boot_ev;
+	SIM_EVENT	connect_ev;
+} hm10;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static uint64_t frame_ns(void){
+	return 10000000000ull / hm10.baud;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Queues a reply to the MCU, sent a frame at a time
+ *
+ ******************************************************************************/
+static void reply(const char *str){
+	uint32_t len = strlen(str);
+	for(uint32_t i = 0; (i < len) && (hm10.reply_len < SIM_HM10_REPLY_MAX); i++){
+		hm10.reply[(hm10.reply_head + hm10.reply_len++) % SIM_HM10_REPLY_MAX] = str[i];
+	}
+	if(!hm10.reply_ev.active) sim_schedule(&hm10.reply_ev, sim_now() + frame_ns());
+}
+
+static void reply_event(void *ctx){
+	sim_leuart_rx(hm10.reply[hm10.reply_head], hm10.baud);
+	hm10.reply_head = (hm10.reply_head + 1) % SIM_HM10_REPLY_MAX;
+	if(--hm10.reply_len) sim_schedule(&hm10.reply_ev, sim_now() + frame_ns());
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Starts advertising, the central connects later if configured to
+ *
+ ******************************************************************************/
+static void advertise(void){
+	hm10.connected = false;
+	if(sim_config.ble_connected) sim_schedule(&hm10.connect_ev, sim_now() + SIM_MS(SIM_HM10_CONNECT_MS));
+}
+
+static void connect_event(void *ctx){
+	hm10.connected = true;
+	hm10.cmd_len = 0;
+	reply("OK+CONN");
+	if(sim_config.central_send){
+		reply(sim_config.central_send);
+		reply("\n");
+	}
+}
+
+static void boot_event(void *ctx){
+	hm10.booting = false;
+	hm10.baud_code = hm10.next_baud_code;
+	hm10.baud = baud_codes[hm10.baud_code];
+	advertise();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Executes the AT command received
+ *
+ ******************************************************************************/
+static void command(const char *cmd){
+	char buf[SIM_HM10_REPLY_MAX];
+	sim_stats.hm10_commands++;
+	if(!strcmp(cmd, "AT")){
+		reply("OK");
+	} else if(!strcmp(cmd, "AT+NAME?")){
+		snprintf(buf, sizeof(buf), "OK+NAME:%s", hm10.name);
+		reply(buf);
+	} else if(!strncmp(cmd, "AT+NAME", 7) && (strlen(cmd) > 7) && (strlen(cmd) <= 7 + SIM_HM10_NAME_MAX)){
+		strcpy(hm10.name, cmd + 7);
+		snprintf(buf, sizeof(buf), "OK+Set:%s", hm10.name);
+		reply(buf);
+	} else if(!strcmp(cmd, "AT+ADVI?")){
+		snprintf(buf, sizeof(buf), "OK+Get:%c", hm10.adv_interval);
+		reply(buf);
+	} else if(!strncmp(cmd, "AT+ADVI", 7) && (strlen(cmd) == 8) && isxdigit((unsigned char)cmd[7])){
+		hm10.adv_interval = cmd[7];
+		snprintf(buf, sizeof(buf), "OK+Set:%c", cmd[7]);
+		reply(buf);
+	} else if(!strcmp(cmd, "AT+POWE?")){
+		snprintf(buf, sizeof(buf), "OK+Get:%c", hm10.tx_power);
+		reply(buf);
+	} else if(!strncmp(cmd, "AT+POWE", 7) && (strlen(cmd) == 8) && (cmd[7] >= '0') && (cmd[7] <= '3')){
+		hm10.tx_power = cmd[7];
+		snprintf(buf, sizeof(buf), "OK+Set:%c", cmd[7]);
+		reply(buf);
+	} else if(!strcmp(cmd, "AT+RESET")){
+		reply("OK+RESET");
+		hm10.booting = true;
+		sim_cancel(&hm10.connect_ev);
+		sim_schedule(&hm10.boot_ev, sim_now() + 9 * frame_ns() + SIM_MS(SIM_HM10_BOOT_MS));
+	} else if(!strcmp(cmd, "AT+BAUD?")){
+		snprintf(buf, sizeof(buf), "OK+Get:%u", hm10.baud_code);
+		reply(buf);
+	} else if(!strncmp(cmd, "AT+BAUD", 7) && (strlen(cmd) == 8) && (cmd[7] >= '0') && (cmd[7] <= '8')){
+		hm10.next_baud_code = cmd[7] - '0';
+		snprintf(buf, sizeof(buf), "OK+Set:%c", cmd[7]);
+		reply(buf);
+	} else if(!strcmp(cmd, "AT+ADDR?")){
+		reply("OK+ADDR:D43639A1B2C3");
+	} else if(!strcmp(cmd, "AT+VERS?")){
+		reply("HMSoft V540");
+	} else {
+		sim_stats.hm10_commands--;
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	No byte for SIM_HM10_GAP_MS, what was received is one command
+ *
+ ******************************************************************************/
+static void gap_event(void *ctx){
+	uint32_t len = hm10.cmd_len;
+	hm10.cmd_len = 0;
+	if(len > SIM_HM10_CMD_MAX) return;
+	hm10.cmd[len] = 0;
+	if(hm10.connected){
+		if(strcmp(hm10.cmd, "AT")) return;
+		reply("OK+LOST");
+		advertise();
+	} else if(!strncmp(hm10.cmd, "AT", 2)){
+		command(hm10.cmd);
+	}
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Power up state, advertising at the --hm10-baud rate, 9600 by default
+ *
+ ******************************************************************************/
+void sim_hm10_init(void){
+	uint32_t code = 0;
+	uint32_t codes = sizeof(baud_codes) / sizeof(baud_codes[0]);
+	if(sim_config.hm10_baud){
+		while((code < codes) && (baud_codes[code] != sim_config.hm10_baud)) code++;
+		if(code == codes) sim_fail("the HM-10 has no %u baud setting", sim_config.hm10_baud);
+	}
+	sim_event_init(&hm10.gap_ev, SIM_CLK_EXT, gap_event, NULL);
+	sim_event_init(&hm10.reply_ev, SIM_CLK_EXT, reply_event, NULL);
+	sim_event_init(&hm10.boot_ev, SIM_CLK_EXT, boot_event, NULL);
+	sim_event_init(&hm10.connect_ev, SIM_CLK_EXT, connect_event, NULL);
+	strcpy(hm10.name, "HMSoft");
+	hm10.adv_interval = '0';
+	hm10.tx_power = '2';
+	hm10.baud_code = code;
+	hm10.next_baud_code = code;
+	hm10.baud = baud_codes[code];
+	advertise();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A frame from the MCU has ended
+ *
+ * @param[in] baud
+ *	Baud rate of the MCU, a frame more than 3 % off the module's is garbled.
+ *
+ ******************************************************************************/
+void sim_hm10_rx(uint8_t data, uint32_t baud){
+	if(hm10.booting) return;
+	if((baud * 100u < hm10.baud * 97u) || (baud * 100u > hm10.baud * 103u)){
+		sim_stats.hm10_garbled++;
+		data = ~data;
+	}
+	if(hm10.connected){
+		sim_stats.hm10_data_bytes++;
+		if(sim_config.capture) fputc(data, sim_config.capture);
+		if(sim_config.echo) fputc(data, stderr);
+	}
+	if(hm10.cmd_len < SIM_HM10_CMD_MAX) hm10.cmd[hm10.cmd_len] = data;
+	if(hm10.cmd_len <= SIM_HM10_CMD_MAX) hm10.cmd_len++;
+	sim_schedule(&hm10.gap_ev, sim_now() + SIM_MS(SIM_HM10_GAP_MS));
+}
@@ -0,0 +1,430 @@
+/**
+ * @file sim_i2c.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief I2C0 and I2C1 master models of the host simulator
+ *
+ * The bus is modelled a condition or a byte at a time: START, STOP and an
+ * ACK or NACK bit take one SCL period, an address or data byte with its
+ * acknowledge nine. The SCL period follows from CLKDIV, CTRL.CLHR and the
+ * HFPER clock as in the reference manual. Between those steps the bus is
+ * held and the master waits for software: a byte in TXDATA, a command, or
+ * the ACK or NACK of a received byte, as it does with AUTOACK off.
+ *
+ * Devices on the bus are attached with sim_i2c_attach(). A device can hold
+ * SCL low before a byte it sends, which is how the Si7021 model stretches
+ * the clock in hold master mode.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_i2c.h"
+#include "em_cmu.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_I2C_BUSES			2
+#define SIM_I2C_SLAVES			4
+
+#define SIM_I2C_CTRL_CLHR_SHIFT	8
+#define SIM_I2C_CTRL_CLHR_MASK	0x00000300UL
+#define SIM_I2C_CR_MAX			8			// SCL cycles of synchronization
+
+#define SIM_REG(reg)			offsetof(I2C_TypeDef, reg)
+
+typedef enum {
+	BUS_IDLE,
+	BUS_START,
+	BUS_ADDR,
+	BUS_TX,
+	BUS_RX,
+	BUS_ACK,
+	BUS_WAIT,
+	BUS_STOP,
+} SIM_I2C_PHASE;
+
+typedef struct {
+	uint32_t				page;
+	IRQn_Type				irq;
+	const char				*name;
+	uint32_t				ctrl;
+	uint32_t				clkdiv;
+	uint32_t				flags;
+	uint32_t				ien;
+	uint32_t				route_pen;
+	uint32_t				route_loc;
+	uint8_t					tx_buf;
+	bool					tx_full;
+	uint8_t					rx_buf;
+	bool					rx_valid;
+	uint8_t					shift;			// byte on the wire
+	bool					nack_bit;		// the ACK phase sends a NACK
+	bool					start_pending;
+	bool					stop_pending;
+	bool					need_addr;		// after a START, the next byte is an address
+	bool					addressed;		// the slave ACKed its address
+	bool					receiver;
+	bool					ack_due;		// a received byte waits for ACK or NACK
+	SIM_I2C_PHASE			phase;
+	uint64_t				busy_since;		// START that took the bus
+	const SIM_I2C_SLAVE		*slave;
+	const SIM_I2C_SLAVE		*slaves[SIM_I2C_SLAVES];
+	SIM_EVENT				ev;
+	SIM_PERIPH_OPS			ops;
+} SIM_I2C_BUS;
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static SIM_I2C_BUS	buses[SIM_I2C_BUSES] = {
+	{ .page = SIM_PAGE_I2C0, .irq = I2C0_IRQn, .name = "I2C0" },
+	{ .page = SIM_PAGE_I2C1, .irq = I2C1_IRQn, .name = "I2C1" },
+};
+
+static const uint32_t	clhr_cycles[] = { 8, 9, 17 };		// SCL low + high of each CLHR
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the model of a register block
+ *
+ ******************************************************************************/
+static SIM_I2C_BUS *bus_of(const I2C_TypeDef *i2c){
+	for(uint32_t i = 0; i < SIM_I2C_BUSES; i++){
+		if(sim_page(buses[i].page) == (void *)i2c) return &buses[i];
+	}
+	sim_fail("%p is not an I2C block", (const void *)i2c);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	SCL period in ns
+ *
+ ******************************************************************************/
+static uint64_t bit_ns(SIM_I2C_BUS *bus){
+	uint32_t hz = sim_cmu_lf_hz(SIM_CLK_HF);
+	if(!hz) sim_fail("%s used with HFPERCLK off", bus->name);
+	uint32_t clhr = (bus->ctrl & SIM_I2C_CTRL_CLHR_MASK) >> SIM_I2C_CTRL_CLHR_SHIFT;
+	uint64_t cycles = clhr_cycles[clhr] * (bus->clkdiv + 1ull) + SIM_I2C_CR_MAX;
+	return (cycles * 1000000000ull) / hz;
+}
+
+static uint32_t flags_now(SIM_I2C_BUS *bus){
+	return bus->flags | (bus->tx_full ? 0 : I2C_IF_TXBL) | (bus->rx_valid ? I2C_IF_RXDATAV : 0);
+}
+
+static void update_irq(SIM_I2C_BUS *bus){
+	sim_irq_level(bus->irq, flags_now(bus) & bus->ien);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Starts a bus step that lasts a number of SCL periods
+ *
+ ******************************************************************************/
+static void step(SIM_I2C_BUS *bus, SIM_I2C_PHASE phase, uint64_t start, uint32_t bits){
+	bus->phase = phase;
+	sim_schedule(&bus->ev, start + bits * bit_ns(bus));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Starts receiving a byte from the addressed slave
+ *
+ ******************************************************************************/
+static void receive(SIM_I2C_BUS *bus){
+	uint64_t ready = sim_now();
+	bus->shift = bus->slave->read(bus->slave->ctx, &ready);
+	step(bus, BUS_RX, ready > sim_now() ? ready : sim_now(), 8);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Lets a held bus go on with what software has asked for
+ *
+ ******************************************************************************/
+static void kick(SIM_I2C_BUS *bus){
+	if((bus->phase != BUS_IDLE) && (bus->phase != BUS_WAIT)) return;
+	if(bus->start_pending){
+		bus->start_pending = false;
+		sim_stats.i2c_transfers++;
+		if(bus->phase == BUS_IDLE) bus->busy_since = sim_now();
+		step(bus, BUS_START, sim_now(), 1);
+	} else if(bus->phase == BUS_IDLE){
+		bus->stop_pending = false;		// STOP on an idle bus does nothing
+	} else if(bus->need_addr && bus->tx_full){
+		bus->need_addr = false;
+		bus->shift = bus->tx_buf;
+		bus->tx_full = false;
+		step(bus, BUS_ADDR, sim_now(), 9);
+	} else if(bus->stop_pending){
+		bus->stop_pending = false;
+		step(bus, BUS_STOP, sim_now(), 1);
+	} else if(bus->addressed && !bus->receiver && bus->tx_full){
+		bus->shift = bus->tx_buf;
+		bus->tx_full = false;
+		step(bus, BUS_TX, sim_now(), 9);
+	}
+	update_irq(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	End of a bus step
+ *
+ ******************************************************************************/
+static void bus_event(void *ctx){
+	SIM_I2C_BUS *bus = ctx;
+	bool ack;
+	switch(bus->phase){
+		case BUS_START:
+			bus->phase = BUS_WAIT;
+			bus->need_addr = true;
+			bus->addressed = false;
+			bus->ack_due = false;
+			break;
+		case BUS_ADDR:
+			sim_stats.i2c_bytes++;
+			bus->slave = NULL;
+			for(uint32_t i = 0; i < SIM_I2C_SLAVES; i++){
+				if(bus->slaves[i] && (bus->slaves[i]->addr == (uint32_t)(bus->shift >> 1))) bus->slave = bus->slaves[i];
+			}
+			bus->receiver = bus->shift & 1;
+			ack = bus->slave && bus->slave->address(bus->slave->ctx, bus->receiver);
+			bus->addressed = ack;
+			bus->flags |= ack ? I2C_IF_ACK : I2C_IF_NACK;
+			if(!ack) sim_stats.i2c_nacks++;
+			if(ack && bus->receiver) receive(bus);
+			else bus->phase = BUS_WAIT;
+			break;
+		case BUS_TX:
+			sim_stats.i2c_bytes++;
+			ack = bus->slave->write(bus->slave->ctx, bus->shift);
+			bus->flags |= ack ? I2C_IF_ACK : I2C_IF_NACK;
+			if(!ack) sim_stats.i2c_nacks++;
+			bus->phase = BUS_WAIT;
+			break;
+		case BUS_RX:
+			sim_stats.i2c_bytes++;
+			if(bus->rx_valid) sim_warn("%s RXDATA overwritten before it was read", bus->name);
+			bus->rx_buf = bus->shift;
+			bus->rx_valid = true;
+			bus->ack_due = true;
+			bus->phase = BUS_WAIT;
+			break;
+		case BUS_ACK:
+			if(bus->nack_bit){
+				bus->addressed = false;
+				bus->phase = BUS_WAIT;
+			} else {
+				receive(bus);
+			}
+			break;
+		case BUS_STOP:
+			bus->flags |= I2C_IF_MSTOP;
+			if(bus->slave && bus->slave->stop) bus->slave->stop(bus->slave->ctx);
+			bus->slave = NULL;
+			bus->addressed = false;
+			bus->need_addr = false;
+			bus->phase = BUS_IDLE;
+			sim_stats.i2c_bus_ns += sim_now() - bus->busy_since;
+			break;
+		default:
+			sim_fail("%s event in phase %d", bus->name, bus->phase);
+	}
+	kick(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Executes the CMD register bits
+ *
+ ******************************************************************************/
+static void command(SIM_I2C_BUS *bus, uint32_t cmd){
+	if(cmd & I2C_CMD_ABORT){
+		if(bus->phase != BUS_IDLE) sim_stats.i2c_bus_ns += sim_now() - bus->busy_since;
+		sim_cancel(&bus->ev);
+		if(bus->slave && bus->slave->stop) bus->slave->stop(bus->slave->ctx);
+		bus->slave = NULL;
+		bus->phase = BUS_IDLE;
+		bus->start_pending = false;
+		bus->stop_pending = false;
+		bus->need_addr = false;
+		bus->addressed = false;
+		bus->ack_due = false;
+	}
+	if(cmd & I2C_CMD_CLEARTX) bus->tx_full = false;
+	if(cmd & (I2C_CMD_ACK | I2C_CMD_NACK)){
+		if(bus->ack_due && (bus->phase == BUS_WAIT)){
+			bus->ack_due = false;
+			bus->nack_bit = cmd & I2C_CMD_NACK;
+			step(bus, BUS_ACK, sim_now(), 1);
+		}
+	}
+	if(cmd & I2C_CMD_START) bus->start_pending = true;
+	if(cmd & I2C_CMD_STOP) bus->stop_pending = true;
+	kick(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	STATE register
+ *
+ ******************************************************************************/
+static uint32_t state_reg(SIM_I2C_BUS *bus){
+	uint32_t state = 0;
+	switch(bus->phase){
+		case BUS_IDLE:
+			return I2C_STATE_STATE_IDLE;
+		case BUS_START:
+			state = I2C_STATE_STATE_START;
+			break;
+		case BUS_ADDR:
+			state = I2C_STATE_STATE_ADDR;
+			break;
+		case BUS_TX:
+		case BUS_RX:
+			state = I2C_STATE_STATE_DATA;
+			break;
+		case BUS_ACK:
+			state = I2C_STATE_STATE_DATAACK;
+			break;
+		case BUS_WAIT:
+			state = bus->need_addr ? I2C_STATE_STATE_START : I2C_STATE_STATE_WAIT;
+			state |= I2C_STATE_BUSHOLD;
+			break;
+		case BUS_STOP:
+			state = I2C_STATE_STATE_WAIT;
+			break;
+	}
+	state |= I2C_STATE_BUSY | I2C_STATE_MASTER;
+	if(!bus->receiver) state |= I2C_STATE_TRANSMITTER;
+	return state;
+}
+
+static uint32_t i2c_refresh(void *ctx, uint32_t offset){
+	SIM_I2C_BUS *bus = ctx;
+	switch(offset){
+		case SIM_REG(CTRL):			return bus->ctrl;
+		case SIM_REG(STATE):		return state_reg(bus);
+		case SIM_REG(STATUS):		return (bus->tx_full ? 0 : I2C_STATUS_TXBL) | (bus->rx_valid ? I2C_STATUS_RXDATAV : 0);
+		case SIM_REG(CLKDIV):		return bus->clkdiv;
+		case SIM_REG(RXDATA):		return bus->rx_buf;
+		case SIM_REG(RXDATAP):		return bus->rx_buf;
+		case SIM_REG(IF):			return flags_now(bus);
+		case SIM_REG(IEN):			return bus->ien;
+		case SIM_REG(ROUTEPEN):		return bus->route_pen;
+		case SIM_REG(ROUTELOC0):	return bus->route_loc;
+		default:					return 0;
+	}
+}
+
+static void i2c_read(void *ctx, uint32_t offset){
+	SIM_I2C_BUS *bus = ctx;
+	if(offset == SIM_REG(RXDATA)){
+		if(!bus->rx_valid) sim_warn("%s RXDATA read while empty", bus->name);
+		bus->rx_valid = false;
+		update_irq(bus);
+	}
+}
+
+static void i2c_write(void *ctx, uint32_t offset, uint32_t value){
+	SIM_I2C_BUS *bus = ctx;
+	switch(offset){
+		case SIM_REG(CTRL):
+			bus->ctrl = value;
+			break;
+		case SIM_REG(CMD):
+			if(!(bus->ctrl & I2C_CTRL_EN) && value) sim_warn("%s command 0x%x while disabled", bus->name, value);
+			command(bus, value);
+			break;
+		case SIM_REG(CLKDIV):
+			bus->clkdiv = value & 0x1FF;
+			break;
+		case SIM_REG(TXDATA):
+			if(bus->tx_full) sim_warn("%s TXDATA overflow", bus->name);
+			bus->tx_buf = value;
+			bus->tx_full = true;
+			kick(bus);
+			break;
+		case SIM_REG(IFS):
+			bus->flags |= value & _I2C_IF_MASK & ~(I2C_IF_TXBL | I2C_IF_RXDATAV);
+			break;
+		case SIM_REG(IFC):
+			bus->flags &= ~value;
+			break;
+		case SIM_REG(IEN):
+			bus->ien = value & _I2C_IF_MASK;
+			break;
+		case SIM_REG(ROUTEPEN):
+			bus->route_pen = value;
+			break;
+		case SIM_REG(ROUTELOC0):
+			bus->route_loc = value;
+			break;
+		default:
+			break;
+	}
+	update_irq(bus);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Reset state of both buses
+ *
+ ******************************************************************************/
+void sim_i2c_init(void){
+	for(uint32_t i = 0; i < SIM_I2C_BUSES; i++){
+		SIM_I2C_BUS *bus = &buses[i];
+		sim_event_init(&bus->ev, SIM_CLK_HF, bus_event, bus);
+		bus->ops = (SIM_PERIPH_OPS){ i2c_refresh, i2c_read, i2c_write, bus };
+		sim_periph_register(bus->page, &bus->ops);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Puts a device on a bus
+ *
+ ******************************************************************************/
+void sim_i2c_attach(uint32_t page, const SIM_I2C_SLAVE *slave){
+	for(uint32_t i = 0; i < SIM_I2C_BUSES; i++){
+		if(buses[i].page != page) continue;
+		for(uint32_t j = 0; j < SIM_I2C_SLAVES; j++){
+			if(buses[i].slaves[j] == NULL){
+				buses[i].slaves[j] = slave;
+				return;
+			}
+		}
+	}
+	sim_fail("cannot attach I2C device 0x%02x", slave->addr);
+}
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init){
+	SIM_I2C_BUS *bus = bus_of(i2c);
+	uint32_t ref = init->refFreq ? init->refFreq : CMU_ClockFreqGet(cmuClock_HFPER);
+	uint32_t n = clhr_cycles[init->clhr];
+	EFM_ASSERT(init->freq && (ref > SIM_I2C_CR_MAX * init->freq));
+	uint32_t div = (ref - SIM_I2C_CR_MAX * init->freq + n * init->freq - 1) / (n * init->freq);
+	if(div) div--;
+
+	i2c->IEN = 0;
+	i2c->IFC = _I2C_IF_MASK;
+	i2c->CLKDIV = div;
+	i2c->CTRL = (i2c->CTRL & ~(SIM_I2C_CTRL_CLHR_MASK | I2C_CTRL_SLAVE | I2C_CTRL_EN))
+			| ((uint32_t)init->clhr << SIM_I2C_CTRL_CLHR_SHIFT)
+			| (init->master ? 0 : I2C_CTRL_SLAVE)
+			| (init->enable ? I2C_CTRL_EN : 0);
+	if(!init->master) sim_warn("%s slave mode is not modelled", bus->name);
+}
@@ -0,0 +1,219 @@
+/**
+ * @file sim_ldma.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief LDMA and GPCRC models of the host simulator, behind their emlib
+ * functions
+ *
+ * Each LDMA channel runs a chain of descriptors, relative links, byte units,
+ * one unit per request of its peripheral signal. A descriptor is read from
+ * memory when the channel gets to it, as on the target. Peripheral registers
+ * are accessed through the register hooks of their model, so the LEUART sees
+ * the LDMA write TXDATA as it sees the CPU. A request served while the CPU sleeps in EM2 or deeper
+ * is counted as a DMA wakeup.
+ *
+ * The GPCRC is computed when the data is written. Without reverseBits the
+ * data is shifted in least significant bit first, the GPCRC default, so the
+ * 16 bit polynomial 0x1021 with 0xFFFF gives CRC-16/MCRF4XX.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_ldma.h"
+#include "em_gpcrc.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_LDMA_CHANNELS		8
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+GPCRC_TypeDef	sim_gpcrc;
+
+static struct {
+	bool				active;
+	bool				done;
+	uint32_t			signal;
+	uint32_t			remaining;
+	LDMA_Descriptor_t	desc;			// loaded copy, its addresses advance
+	const LDMA_Descriptor_t	*at;		// where it was loaded from, for the link
+} channel[SIM_LDMA_CHANNELS];
+
+static uint32_t		ldma_flags;
+static uint32_t		ldma_ien;
+static bool			ldma_serving;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void update_irq(void){
+	sim_irq_level(LDMA_IRQn, ldma_flags & ldma_ien);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Loads a descriptor into a channel
+ *
+ ******************************************************************************/
+static void load(int ch, const LDMA_Descriptor_t *descriptor){
+	EFM_ASSERT(descriptor->xfer.size == ldmaCtrlSizeByte);
+	EFM_ASSERT(!descriptor->xfer.link || (descriptor->xfer.linkMode == ldmaLinkModeRel));
+	channel[ch].at = descriptor;
+	channel[ch].desc = *descriptor;
+	channel[ch].remaining = descriptor->xfer.xferCnt + 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Moves one byte of a channel
+ *
+ ******************************************************************************/
+static void transfer_unit(int ch){
+	LDMA_Descriptor_t *desc = &channel[ch].desc;
+	uint8_t data;
+	if(sim_page_of((void *)desc->xfer.srcAddr, NULL) != SIM_PAGE_NONE) data = sim_periph_read((void *)desc->xfer.srcAddr);
+	else data = *(const uint8_t *)desc->xfer.srcAddr;
+	if(sim_page_of((void *)desc->xfer.dstAddr, NULL) != SIM_PAGE_NONE) sim_periph_write((void *)desc->xfer.dstAddr, data);
+	else *(uint8_t *)desc->xfer.dstAddr = data;
+	if(desc->xfer.srcInc == 0) desc->xfer.srcAddr++;
+	if(desc->xfer.dstInc == 0) desc->xfer.dstAddr++;
+	sim_stats.dma_bytes++;
+	sim_dma_wakeup();
+	if(--channel[ch].remaining == 0){
+		if(desc->xfer.doneIfs) ldma_flags |= 1u << ch;
+		if(desc->xfer.link){
+			load(ch, channel[ch].at + desc->xfer.linkAddr / 4);
+		} else {
+			channel[ch].active = false;
+			channel[ch].done = true;
+		}
+		update_irq();
+	}
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	A peripheral request signal may have changed, serves the channels on it
+ *
+ * @details
+ *	Called by the peripheral models. A write by the LDMA can raise the
+ *	request again, that is served by the loop rather than by recursion.
+ *
+ ******************************************************************************/
+void sim_ldma_request(void){
+	if(ldma_serving) return;
+	ldma_serving = true;
+	bool served;
+	do {
+		served = false;
+		for(int ch = 0; ch < SIM_LDMA_CHANNELS; ch++){
+			if(channel[ch].active && sim_leuart_signal(channel[ch].signal)){
+				transfer_unit(ch);
+				served = true;
+			}
+		}
+	} while(served);
+	ldma_serving = false;
+}
+
+void LDMA_Init(const LDMA_Init_t *init){
+	ldma_flags = 0;
+	ldma_ien = LDMA_IF_ERROR;
+	NVIC_SetPriority(LDMA_IRQn, init->ldmaInitIrqPriority);
+	NVIC_EnableIRQ(LDMA_IRQn);
+}
+
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor){
+	EFM_ASSERT(ch < SIM_LDMA_CHANNELS);
+	load(ch, descriptor);
+	channel[ch].signal = transfer->ldmaReqSel;
+	channel[ch].done = false;
+	channel[ch].active = true;
+	ldma_flags &= ~(1u << ch);
+	ldma_ien |= 1u << ch;
+	update_irq();
+	sim_ldma_request();
+}
+
+void LDMA_StopTransfer(int ch){
+	channel[ch].active = false;
+	ldma_ien &= ~(1u << ch);
+	update_irq();
+}
+
+bool LDMA_TransferDone(int ch){
+	return channel[ch].done;
+}
+
+uint32_t LDMA_TransferRemainingCount(int ch){
+	return channel[ch].active ? channel[ch].remaining : 0;
+}
+
+uint32_t LDMA_IntGetEnabled(void){
+	return ldma_flags & ldma_ien;
+}
+
+void LDMA_IntClear(uint32_t flags){
+	ldma_flags &= ~flags;
+	update_irq();
+}
+
+void LDMA_IntEnable(uint32_t flags){
+	ldma_ien |= flags;
+	update_irq();
+}
+
+void LDMA_IntDisable(uint32_t flags){
+	ldma_ien &= ~flags;
+	update_irq();
+}
+
+void GPCRC_Init(GPCRC_TypeDef *gpcrc, const GPCRC_Init_TypeDef *init){
+	EFM_ASSERT((init->crcPoly == 0x04C11DB7UL) || (init->crcPoly <= 0xFFFF));
+	gpcrc->poly = init->crcPoly;
+	gpcrc->init = init->initValue;
+	gpcrc->reverse_bits = init->reverseBits;
+	gpcrc->reverse_bytes = init->reverseByteOrder;
+	gpcrc->data = gpcrc->init;
+}
+
+void GPCRC_Start(GPCRC_TypeDef *gpcrc){
+	gpcrc->data = gpcrc->init;
+}
+
+void GPCRC_InputU8(GPCRC_TypeDef *gpcrc, uint8_t data){
+	uint32_t width = (gpcrc->poly == 0x04C11DB7UL) ? 32 : 16;
+	uint32_t poly = 0;
+	for(uint32_t i = 0; i < width; i++){
+		if(gpcrc->poly & (1u << i)) poly |= 1u << (width - 1 - i);
+	}
+	if(gpcrc->reverse_bits) data = (uint8_t)(((data * 0x0802u & 0x22110u) | (data * 0x8020u & 0x88440u)) * 0x10101u >> 16);
+	gpcrc->data ^= data;
+	for(int bit = 0; bit < 8; bit++){
+		gpcrc->data = (gpcrc->data & 1) ? (gpcrc->data >> 1) ^ poly : gpcrc->data >> 1;
+	}
+}
+
+void GPCRC_InputU16(GPCRC_TypeDef *gpcrc, uint16_t data){
+	GPCRC_InputU8(gpcrc, data & 0xFF);
+	GPCRC_InputU8(gpcrc, data >> 8);
+}
+
+void GPCRC_InputU32(GPCRC_TypeDef *gpcrc, uint32_t data){
+	GPCRC_InputU16(gpcrc, data & 0xFFFF);
+	GPCRC_InputU16(gpcrc, data >> 16);
+}
+
+uint32_t GPCRC_DataRead(GPCRC_TypeDef *gpcrc){
+	return gpcrc->data;
+}
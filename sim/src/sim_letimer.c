@@ -0,0 +1,289 @@
+/**
+ * @file sim_letimer.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief LETIMER0 model of the host simulator and the emlib LETIMER functions
+ *
+ * The counter counts down at the LFA clock. It is not stepped tick by tick:
+ * the model keeps the count at a reference time and schedules an event for
+ * the next COMP1 match or underflow. On underflow CNT reloads from COMP0
+ * when COMP0TOP is set, which also sets the COMP0 flag, as the drivers use it
+ * in free running PWM mode. REP0 and REP1 are stored but not counted.
+ *
+ * Writes to CTRL, CMD, CNT, COMP0, COMP1, REP0 and REP1 take effect at once
+ * but hold SYNCBUSY for SIM_LE_SYNC_CYCLES of the LF clock, the time they
+ * take to cross into the low frequency domain. Writing one of them again
+ * before SYNCBUSY cleared would be lost on the part and is counted.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_letimer.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_LE_SYNC_CYCLES			2
+
+#define SIM_LETIMER_CTRL_REPMODE	0x00000003UL
+#define SIM_LETIMER_CTRL_BUFTOP		0x00000100UL
+#define SIM_LETIMER_CTRL_COMP0TOP	0x00000200UL
+#define SIM_LETIMER_CTRL_DEBUGRUN	0x00001000UL
+#define SIM_LETIMER_CNT_MASK		0x0000FFFFUL
+
+#define SIM_REG(reg)				offsetof(LETIMER_TypeDef, reg)
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static struct {
+	uint32_t	ctrl;
+	bool		running;
+	uint32_t	cnt;			// count at base
+	uint64_t	base;			// LFA clock time of cnt, on a tick
+	uint32_t	comp0;
+	uint32_t	comp1;
+	uint32_t	rep0;
+	uint32_t	rep1;
+	uint32_t	flags;
+	uint32_t	ien;
+	uint32_t	route_pen;
+	uint32_t	route_loc;
+	uint32_t	sync_busy;			// SYNCBUSY bits of the writes crossing
+	bool		next_uf;		// the pending count event is an underflow, else a COMP1 match
+	SIM_EVENT	count_ev;
+	SIM_EVENT	sync_ev;
+} letimer;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Length of an LFA clock cycle in ns, 0 while the clock is stopped
+ *
+ ******************************************************************************/
+static uint64_t tick_ns(void){
+	uint32_t hz = sim_cmu_lf_hz(SIM_CLK_LFA);
+	return hz ? 1000000000ull / hz : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Counter value now
+ *
+ ******************************************************************************/
+static uint32_t cnt_now(void){
+	uint64_t tick = tick_ns();
+	if(!letimer.running || !tick) return letimer.cnt;
+	uint64_t elapsed = (sim_clock_now(SIM_CLK_LFA) - letimer.base) / tick;
+	if(elapsed <= letimer.cnt) return letimer.cnt - elapsed;
+	elapsed -= letimer.cnt + 1;
+	uint32_t top = (letimer.ctrl & SIM_LETIMER_CTRL_COMP0TOP) ? letimer.comp0 : SIM_LETIMER_CNT_MASK;
+	return top - (elapsed % (top + 1ull));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Moves the reference to the tick in progress
+ *
+ ******************************************************************************/
+static void rebase(void){
+	uint64_t tick = tick_ns();
+	uint64_t clock = sim_clock_now(SIM_CLK_LFA);
+	letimer.cnt = cnt_now();
+	if(tick) letimer.base = clock - ((clock - letimer.base) % tick);
+	else letimer.base = clock;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sets the interrupt line from IF and IEN
+ *
+ ******************************************************************************/
+static void update_irq(void){
+	sim_irq_level(LETIMER0_IRQn, letimer.flags & letimer.ien);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Schedules the next COMP1 match or underflow
+ *
+ ******************************************************************************/
+static void schedule_count(void){
+	uint64_t tick = tick_ns();
+	if(!letimer.running || !tick){
+		sim_cancel(&letimer.count_ev);
+		return;
+	}
+	uint32_t ticks = letimer.cnt + 1;
+	letimer.next_uf = true;
+	if(letimer.comp1 < letimer.cnt){
+		ticks = letimer.cnt - letimer.comp1;
+		letimer.next_uf = false;
+	}
+	uint64_t at = letimer.base + ticks * tick;
+	sim_schedule(&letimer.count_ev, sim_now() + (at - sim_clock_now(SIM_CLK_LFA)));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Count event, a COMP1 match or an underflow
+ *
+ ******************************************************************************/
+static void count_event(void *ctx){
+	letimer.base = sim_clock_now(SIM_CLK_LFA);
+	if(letimer.next_uf){
+		letimer.flags |= LETIMER_IF_UF;
+		if(letimer.ctrl & SIM_LETIMER_CTRL_COMP0TOP){
+			letimer.cnt = letimer.comp0;
+			letimer.flags |= LETIMER_IF_COMP0;
+		} else {
+			letimer.cnt = SIM_LETIMER_CNT_MASK;
+		}
+		if(letimer.cnt == letimer.comp1) letimer.flags |= LETIMER_IF_COMP1;
+	} else {
+		letimer.cnt = letimer.comp1;
+		letimer.flags |= LETIMER_IF_COMP1;
+	}
+	update_irq();
+	schedule_count();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A synchronized write reached the LF domain
+ *
+ ******************************************************************************/
+static void sync_event(void *ctx){
+	letimer.sync_busy = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Starts the synchronization of a write
+ *
+ ******************************************************************************/
+static void sync_start(uint32_t busy){
+	if(letimer.sync_busy & busy) sim_stats.sync_violations++;
+	letimer.sync_busy |= busy;
+	uint64_t tick = tick_ns();
+	if(tick) sim_schedule(&letimer.sync_ev, sim_now() + SIM_LE_SYNC_CYCLES * tick);
+	else sim_cancel(&letimer.sync_ev);
+}
+
+static uint32_t letimer_refresh(void *ctx, uint32_t offset){
+	switch(offset){
+		case SIM_REG(CTRL):			return letimer.ctrl;
+		case SIM_REG(STATUS):		return letimer.running ? LETIMER_STATUS_RUNNING : 0;
+		case SIM_REG(CNT):			return cnt_now();
+		case SIM_REG(COMP0):		return letimer.comp0;
+		case SIM_REG(COMP1):		return letimer.comp1;
+		case SIM_REG(REP0):			return letimer.rep0;
+		case SIM_REG(REP1):			return letimer.rep1;
+		case SIM_REG(IF):			return letimer.flags;
+		case SIM_REG(IEN):			return letimer.ien;
+		case SIM_REG(SYNCBUSY):		return letimer.sync_busy;
+		case SIM_REG(ROUTEPEN):		return letimer.route_pen;
+		case SIM_REG(ROUTELOC0):	return letimer.route_loc;
+		default:					return 0;
+	}
+}
+
+static void letimer_read(void *ctx, uint32_t offset){
+}
+
+static void letimer_write(void *ctx, uint32_t offset, uint32_t value){
+	rebase();
+	switch(offset){
+		case SIM_REG(CTRL):
+			sync_start(LETIMER_SYNCBUSY_CTRL);
+			letimer.ctrl = value;
+			break;
+		case SIM_REG(CMD):
+			sync_start(LETIMER_SYNCBUSY_CMD);
+			if(value & LETIMER_CMD_START) letimer.running = true;
+			if(value & LETIMER_CMD_STOP) letimer.running = false;
+			if(value & LETIMER_CMD_CLEAR) letimer.cnt = 0;
+			break;
+		case SIM_REG(CNT):
+			sync_start(LETIMER_SYNCBUSY_CNT);
+			letimer.cnt = value & SIM_LETIMER_CNT_MASK;
+			break;
+		case SIM_REG(COMP0):
+			sync_start(LETIMER_SYNCBUSY_COMP0);
+			letimer.comp0 = value & SIM_LETIMER_CNT_MASK;
+			break;
+		case SIM_REG(COMP1):
+			sync_start(LETIMER_SYNCBUSY_COMP1);
+			letimer.comp1 = value & SIM_LETIMER_CNT_MASK;
+			break;
+		case SIM_REG(REP0):
+			sync_start(LETIMER_SYNCBUSY_REP0);
+			letimer.rep0 = value & 0xFF;
+			break;
+		case SIM_REG(REP1):
+			sync_start(LETIMER_SYNCBUSY_REP1);
+			letimer.rep1 = value & 0xFF;
+			break;
+		case SIM_REG(IFS):
+			letimer.flags |= value & _LETIMER_IF_MASK;
+			break;
+		case SIM_REG(IFC):
+			letimer.flags &= ~value;
+			break;
+		case SIM_REG(IEN):
+			letimer.ien = value & _LETIMER_IF_MASK;
+			break;
+		case SIM_REG(ROUTEPEN):
+			letimer.route_pen = value;
+			break;
+		case SIM_REG(ROUTELOC0):
+			letimer.route_loc = value;
+			break;
+		default:
+			sim_warn("LETIMER0 write to read only offset 0x%x", offset);
+	}
+	update_irq();
+	schedule_count();
+}
+
+static const SIM_PERIPH_OPS letimer_ops = { letimer_refresh, letimer_read, letimer_write, NULL };
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Reset state of LETIMER0
+ *
+ ******************************************************************************/
+void sim_letimer_init(void){
+	sim_event_init(&letimer.count_ev, SIM_CLK_LFA, count_event, NULL);
+	sim_event_init(&letimer.sync_ev, SIM_CLK_LFA, sync_event, NULL);
+	sim_periph_register(SIM_PAGE_LETIMER0, &letimer_ops);
+}
+
+void LETIMER_Init(LETIMER_TypeDef *letimer_reg, const LETIMER_Init_TypeDef *init){
+	EFM_ASSERT(letimer_reg == LETIMER0);
+	if(letimer_reg->STATUS & LETIMER_STATUS_RUNNING) LETIMER_Enable(letimer_reg, false);
+	while(letimer_reg->SYNCBUSY);
+	letimer_reg->CTRL = (init->repMode & SIM_LETIMER_CTRL_REPMODE)
+			| (init->bufTop ? SIM_LETIMER_CTRL_BUFTOP : 0)
+			| (init->comp0Top ? SIM_LETIMER_CTRL_COMP0TOP : 0)
+			| (init->debugRun ? SIM_LETIMER_CTRL_DEBUGRUN : 0);
+	if(init->enable){
+		while(letimer_reg->SYNCBUSY);
+		letimer_reg->CMD = LETIMER_CMD_START;
+	}
+}
+
+void LETIMER_Enable(LETIMER_TypeDef *letimer_reg, bool enable){
+	while(letimer_reg->SYNCBUSY);
+	letimer_reg->CMD = enable ? LETIMER_CMD_START : LETIMER_CMD_STOP;
+}
@@ -0,0 +1,369 @@
+/**
+ * @file sim_leuart.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief LEUART0 model of the host simulator and the emlib LEUART functions
+ *
+ * A frame is 10 bit times of the baud rate set in CLKDIV, 8N1 as the HM-10
+ * is used. The transmitter has one TXDATA buffer in front of the shift
+ * register, the receiver a two byte FIFO. Frames sent go to the HM-10 model,
+ * frames from it arrive with sim_leuart_rx() and are received only while the
+ * LFB clock runs and RX is enabled and not blocked.
+ *
+ * TXBL and RXDATAV follow the buffers and cannot be cleared in IFC. TXC is
+ * set when the shift register empties with nothing buffered and is cleared
+ * by IFC or by the next TXDATA write. Writes to CTRL, CMD, CLKDIV, STARTFRAME
+ * and SIGFRAME hold their SYNCBUSY bit for two LFB cycles, writing the same
+ * register again during that time is counted as a synchronization violation.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_leuart.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_LE_SYNC_CYCLES		2
+#define SIM_LEUART_FRAME_BITS	10
+#define SIM_LEUART_RX_FIFO		2
+#define SIM_LEUART_CLKDIV_MASK	0x00007FF8UL
+
+#define SIM_REG(reg)			offsetof(LEUART_TypeDef, reg)
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static struct {
+	uint32_t	ctrl;
+	uint32_t	clkdiv;
+	uint32_t	startframe;
+	uint32_t	sigframe;
+	uint32_t	flags;
+	uint32_t	ien;
+	uint32_t	route_pen;
+	uint32_t	route_loc;
+	bool		rx_en;
+	bool		tx_en;
+	bool		rx_block;
+	bool		tx_full;
+	uint8_t		tx_buf;
+	bool		shifting;
+	uint8_t		shift;
+	bool		txc;
+	uint8_t		rx_fifo[SIM_LEUART_RX_FIFO];
+	uint32_t	rx_count;
+	uint32_t	sync_busy;			// SYNCBUSY bits of the writes crossing
+	bool		dma_wu_warned;
+	SIM_EVENT	tx_ev;
+	SIM_EVENT	sync_ev;
+} leuart;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Baud rate from CLKDIV and the LFB clock, 0 while the clock is stopped
+ *
+ ******************************************************************************/
+static uint32_t baud(void){
+	uint64_t hz = sim_cmu_lf_hz(SIM_CLK_LFB);
+	return (hz * 256) / (256 + leuart.clkdiv);
+}
+
+static uint32_t flags_now(void){
+	return leuart.flags | (leuart.tx_full ? 0 : LEUART_IF_TXBL) | (leuart.rx_count ? LEUART_IF_RXDATAV : 0);
+}
+
+static void update_irq(void){
+	sim_irq_level(LEUART0_IRQn, flags_now() & leuart.ien);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Moves the TXDATA buffer into the shift register
+ *
+ ******************************************************************************/
+static void shift_next(void){
+	uint32_t rate = baud();
+	if(leuart.shifting || !leuart.tx_full || !leuart.tx_en) return;
+	if(!rate) sim_fail("LEUART0 transmits with the LFB clock off");
+	leuart.shift = leuart.tx_buf;
+	leuart.tx_full = false;
+	leuart.shifting = true;
+	uint64_t frame_ns = (SIM_LEUART_FRAME_BITS * 1000000000ull) / rate;
+	sim_stats.leuart_line_ns += frame_ns;
+	sim_schedule(&leuart.tx_ev, sim_now() + frame_ns);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A frame has left the shift register
+ *
+ ******************************************************************************/
+static void tx_event(void *ctx){
+	leuart.shifting = false;
+	sim_stats.leuart_tx_bytes++;
+	sim_hm10_rx(leuart.shift, baud());
+	shift_next();
+	if(!leuart.shifting){
+		leuart.txc = true;
+		leuart.flags |= LEUART_IF_TXC;
+	}
+	update_irq();
+	sim_ldma_request();
+}
+
+static void sync_event(void *ctx){
+	leuart.sync_busy = 0;
+}
+
+static void sync_start(uint32_t busy){
+	uint32_t hz = sim_cmu_lf_hz(SIM_CLK_LFB);
+	if(leuart.sync_busy & busy) sim_stats.sync_violations++;
+	leuart.sync_busy |= busy;
+	if(hz) sim_schedule(&leuart.sync_ev, sim_now() + (SIM_LE_SYNC_CYCLES * 1000000000ull) / hz);
+	else sim_cancel(&leuart.sync_ev);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Executes the CMD register bits
+ *
+ ******************************************************************************/
+static void command(uint32_t cmd){
+	if(cmd & LEUART_CMD_RXEN) leuart.rx_en = true;
+	if(cmd & LEUART_CMD_RXDIS) leuart.rx_en = false;
+	if(cmd & LEUART_CMD_TXEN) leuart.tx_en = true;
+	if(cmd & LEUART_CMD_TXDIS){
+		if(leuart.shifting || leuart.tx_full) sim_warn("LEUART0 TX disabled with a frame in progress");
+		leuart.tx_en = false;
+		leuart.shifting = false;
+		sim_cancel(&leuart.tx_ev);
+	}
+	if(cmd & LEUART_CMD_RXBLOCKEN) leuart.rx_block = true;
+	if(cmd & LEUART_CMD_RXBLOCKDIS) leuart.rx_block = false;
+	if(cmd & LEUART_CMD_CLEARTX) leuart.tx_full = false;
+	if(cmd & LEUART_CMD_CLEARRX) leuart.rx_count = 0;
+	shift_next();
+}
+
+static uint32_t leuart_refresh(void *ctx, uint32_t offset){
+	switch(offset){
+		case SIM_REG(CTRL):			return leuart.ctrl;
+		case SIM_REG(STATUS):
+			return (leuart.rx_en ? LEUART_STATUS_RXENS : 0)
+					| (leuart.tx_en ? LEUART_STATUS_TXENS : 0)
+					| (leuart.rx_block ? LEUART_STATUS_RXBLOCK : 0)
+					| (leuart.txc ? LEUART_STATUS_TXC : 0)
+					| (leuart.tx_full ? 0 : LEUART_STATUS_TXBL)
+					| (leuart.rx_count ? LEUART_STATUS_RXDATAV : 0)
+					| ((leuart.shifting || leuart.tx_full) ? 0 : LEUART_STATUS_TXIDLE);
+		case SIM_REG(CLKDIV):		return leuart.clkdiv;
+		case SIM_REG(STARTFRAME):	return leuart.startframe;
+		case SIM_REG(SIGFRAME):		return leuart.sigframe;
+		case SIM_REG(RXDATA):
+		case SIM_REG(RXDATAX):
+		case SIM_REG(RXDATAXP):		return leuart.rx_fifo[0];
+		case SIM_REG(IF):			return flags_now();
+		case SIM_REG(IEN):			return leuart.ien;
+		case SIM_REG(SYNCBUSY):		return leuart.sync_busy;
+		case SIM_REG(ROUTEPEN):		return leuart.route_pen;
+		case SIM_REG(ROUTELOC0):	return leuart.route_loc;
+		default:					return 0;
+	}
+}
+
+static void leuart_read(void *ctx, uint32_t offset){
+	if((offset != SIM_REG(RXDATA)) && (offset != SIM_REG(RXDATAX))) return;
+	if(!leuart.rx_count){
+		leuart.flags |= LEUART_IF_RXUF;
+	} else {
+		leuart.rx_fifo[0] = leuart.rx_fifo[1];
+		leuart.rx_count--;
+	}
+	update_irq();
+}
+
+static void leuart_write(void *ctx, uint32_t offset, uint32_t value){
+	switch(offset){
+		case SIM_REG(CTRL):
+			sync_start(LEUART_SYNCBUSY_CTRL);
+			leuart.ctrl = value;
+			break;
+		case SIM_REG(CMD):
+			sync_start(LEUART_SYNCBUSY_CMD);
+			command(value);
+			break;
+		case SIM_REG(CLKDIV):
+			sync_start(LEUART_SYNCBUSY_CLKDIV);
+			leuart.clkdiv = value & SIM_LEUART_CLKDIV_MASK;
+			break;
+		case SIM_REG(STARTFRAME):
+			sync_start(LEUART_SYNCBUSY_STARTFRAME);
+			leuart.startframe = value & 0x1FF;
+			break;
+		case SIM_REG(SIGFRAME):
+			sync_start(LEUART_SYNCBUSY_SIGFRAME);
+			leuart.sigframe = value & 0x1FF;
+			break;
+		case SIM_REG(TXDATA):
+		case SIM_REG(TXDATAX):
+			if(!leuart.tx_en) sim_warn("LEUART0 TXDATA written with TX disabled");
+			if(leuart.tx_full){
+				leuart.flags |= LEUART_IF_TXOF;
+				break;
+			}
+			leuart.tx_buf = value;
+			leuart.tx_full = true;
+			leuart.txc = false;
+			leuart.flags &= ~LEUART_IF_TXC;
+			shift_next();
+			break;
+		case SIM_REG(IFS):
+			leuart.flags |= value & _LEUART_IF_MASK & ~(LEUART_IF_TXBL | LEUART_IF_RXDATAV);
+			break;
+		case SIM_REG(IFC):
+			leuart.flags &= ~value;
+			break;
+		case SIM_REG(IEN):
+			leuart.ien = value & _LEUART_IF_MASK;
+			break;
+		case SIM_REG(ROUTEPEN):
+			leuart.route_pen = value;
+			break;
+		case SIM_REG(ROUTELOC0):
+			leuart.route_loc = value;
+			break;
+		default:
+			break;
+	}
+	update_irq();
+	sim_ldma_request();
+}
+
+static const SIM_PERIPH_OPS leuart_ops = { leuart_refresh, leuart_read, leuart_write, NULL };
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Reset state of LEUART0
+ *
+ ******************************************************************************/
+void sim_leuart_init(void){
+	sim_event_init(&leuart.tx_ev, SIM_CLK_LFB, tx_event, NULL);
+	sim_event_init(&leuart.sync_ev, SIM_CLK_LFB, sync_event, NULL);
+	sim_periph_register(SIM_PAGE_LEUART0, &leuart_ops);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	A frame sent to LEUART0 has ended
+ *
+ * @details
+ *	A frame at a baud rate more than 3 % from the receiver's is taken with a
+ *	framing error and its data garbled, as the sampling point drifts out of
+ *	the last bits.
+ *
+ * @param[in] baud_rate
+ *	Baud rate of the sender.
+ *
+ ******************************************************************************/
+void sim_leuart_rx(uint8_t data, uint32_t baud_rate){
+	uint32_t rate = baud();
+	if(!leuart.rx_en || !rate || !sim_clock_running(SIM_CLK_LFB)){
+		sim_stats.leuart_rx_dropped++;
+		return;
+	}
+	if((baud_rate * 100u < rate * 97u) || (baud_rate * 100u > rate * 103u)){
+		leuart.flags |= LEUART_IF_FERR;
+		data = ~data;
+	}
+	if(leuart.rx_block){
+		if(!(leuart.ctrl & LEUART_CTRL_SFUBRX) || (data != leuart.startframe)){
+			sim_stats.leuart_rx_dropped++;
+			update_irq();
+			return;
+		}
+		leuart.rx_block = false;
+	}
+	if(data == leuart.startframe) leuart.flags |= LEUART_IF_STARTF;
+	if(data == leuart.sigframe) leuart.flags |= LEUART_IF_SIGF;
+	if(leuart.rx_count == SIM_LEUART_RX_FIFO){
+		leuart.flags |= LEUART_IF_RXOF;
+		sim_stats.leuart_rx_dropped++;
+	} else {
+		leuart.rx_fifo[leuart.rx_count++] = data;
+		sim_stats.leuart_rx_bytes++;
+	}
+	update_irq();
+	sim_ldma_request();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true while an LDMA request signal of LEUART0 is active
+ *
+ * @details
+ *	In EM2 a request only reaches the LDMA with TXDMAWU or RXDMAWU set. The
+ *	model serves it anyway and counts a stall, the part would sleep on.
+ *
+ ******************************************************************************/
+bool sim_leuart_signal(uint32_t signal){
+	bool active;
+	uint32_t wakeup;
+	switch(signal){
+		case SIM_LDMA_SIGNAL_LEUART0_TXBL:
+			active = leuart.tx_en && !leuart.tx_full;
+			wakeup = LEUART_CTRL_TXDMAWU;
+			break;
+		case SIM_LDMA_SIGNAL_LEUART0_RXDATAV:
+			active = leuart.rx_count != 0;
+			wakeup = LEUART_CTRL_RXDMAWU;
+			break;
+		default:
+			return false;
+	}
+	if(active && (sim_em() >= EM2) && !(leuart.ctrl & wakeup)){
+		sim_stats.stalls++;
+		if(!leuart.dma_wu_warned) sim_warn("LEUART0 LDMA request in EM%u without its DMA wakeup bit", sim_em());
+		leuart.dma_wu_warned = true;
+	}
+	return active;
+}
+
+void LEUART_BaudrateSet(LEUART_TypeDef *leuart_reg, uint32_t refFreq, uint32_t baudrate){
+	if(!refFreq) refFreq = CMU_ClockFreqGet(cmuClock_LEUART0);
+	uint32_t clkdiv = ((32 * refFreq) / baudrate - 32) * 8;
+	while(leuart_reg->SYNCBUSY);
+	leuart_reg->CLKDIV = clkdiv & SIM_LEUART_CLKDIV_MASK;
+}
+
+uint32_t LEUART_BaudrateGet(LEUART_TypeDef *leuart_reg){
+	return baud();
+}
+
+void LEUART_Enable(LEUART_TypeDef *leuart_reg, LEUART_Enable_TypeDef enable){
+	uint32_t cmd = (uint32_t)enable | (((uint32_t)~enable & leuartEnable) << 1);
+	while(leuart_reg->SYNCBUSY);
+	leuart_reg->CMD = cmd;
+}
+
+void LEUART_Init(LEUART_TypeDef *leuart_reg, const LEUART_Init_TypeDef *init){
+	EFM_ASSERT(leuart_reg == LEUART0);
+	EFM_ASSERT((init->databits == leuartDatabits8) && (init->parity == leuartNoParity) && (init->stopbits == leuartStopbits1));
+	while(leuart_reg->SYNCBUSY);
+	leuart_reg->CMD = LEUART_CMD_RXDIS | LEUART_CMD_TXDIS;
+	LEUART_BaudrateSet(leuart_reg, init->refFreq, init->baudrate);
+	LEUART_Enable(leuart_reg, init->enable);
+}
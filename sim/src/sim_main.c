@@ -0,0 +1,263 @@
+/**
+ * @file sim_main.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Entry point and report of the host simulator
+ *
+ * Parses the command line, brings up the peripheral models and runs the
+ * application's main(), built as sim_app_main(), until the simulated time
+ * has passed. The report is one "key value" line per metric, units in the
+ * key, so runs can be compared with diff or a script, or with --json the
+ * same keys in one JSON object for sim/bench.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "em_device.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_DEFAULT_SECONDS		60
+#define SIM_DEFAULT_TEMP_F		72.0
+#define SIM_DEFAULT_RH			45.0
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const double			em_ua[SIM_EM_COUNT] = { SIM_EM0_UA, SIM_EM1_UA, SIM_EM2_UA, SIM_EM3_UA, SIM_EM4_UA };
+
+static const struct {
+	uint32_t	irq;
+	const char	*name;
+} irq_names[] = {
+	{ LDMA_IRQn,		"ldma" },
+	{ I2C0_IRQn,		"i2c0" },
+	{ LEUART0_IRQn,		"leuart0" },
+	{ LETIMER0_IRQn,	"letimer0" },
+	{ RTCC_IRQn,		"rtcc" },
+	{ I2C1_IRQn,		"i2c1" },
+};
+
+static const struct option options[] = {
+	{ "seconds",		required_argument,	NULL, 's' },
+	{ "temp",			required_argument,	NULL, 't' },
+	{ "temp-slope",		required_argument,	NULL, 'S' },
+	{ "temp-swing",		required_argument,	NULL, 'w' },
+	{ "swing-period",	required_argument,	NULL, 'p' },
+	{ "temp-noise",		required_argument,	NULL, 'n' },
+	{ "rh",				required_argument,	NULL, 'r' },
+	{ "seed",			required_argument,	NULL, 'x' },
+	{ "ble-connected",	no_argument,		NULL, 'c' },
+	{ "capture",		required_argument,	NULL, 'o' },
+	{ "echo",			no_argument,		NULL, 'e' },
+	{ "central-send",	required_argument,	NULL, 'C' },
+	{ "report",			required_argument,	NULL, 'R' },
+	{ "json",			no_argument,		NULL, 'j' },
+	{ "hm10-baud",		required_argument,	NULL, 'b' },
+	{ "help",			no_argument,		NULL, 'h' },
+	{ NULL, 0, NULL, 0 }
+};
+
+static FILE					*report_out;
+static bool					report_first;
+
+int sim_app_main(void);
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void usage(FILE *out){
+	fprintf(out,
+		"usage: cp_sim [options]\n"
+		"  --seconds N        simulated time, default %d\n"
+		"  --temp F           ambient temperature, default %.1f\n"
+		"  --temp-slope F     drift in F per hour\n"
+		"  --temp-swing F     amplitude of a sine on the temperature\n"
+		"  --swing-period S   period of the sine in seconds\n"
+		"  --temp-noise F     peak uniform noise on each reading\n"
+		"  --rh P             relative humidity in %%, default %.1f\n"
+		"  --seed N           noise seed\n"
+		"  --ble-connected    a central connects to the HM-10 when it advertises\n"
+		"  --capture FILE     data received by the central\n"
+		"  --echo             copy data received by the central to stderr\n"
+		"  --central-send S   line the central writes to the module once connected\n"
+		"  --report FILE      report to FILE instead of stdout\n"
+		"  --json             report as a JSON object\n"
+		"  --hm10-baud N      baud rate the HM-10 is configured at, default 9600\n",
+		SIM_DEFAULT_SECONDS, SIM_DEFAULT_TEMP_F, SIM_DEFAULT_RH);
+}
+
+static FILE *open_or_die(const char *path){
+	FILE *file = fopen(path, "w");
+	if(file == NULL){
+		perror(path);
+		exit(1);
+	}
+	return file;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Writes one metric of the report, as a line or as a JSON member
+ *
+ ******************************************************************************/
+static void put_key(const char *key){
+	if(sim_config.json) fprintf(report_out, "%s\n\t\"%s\": ", report_first ? "{" : ",", key);
+	else fprintf(report_out, "%s ", key);
+	report_first = false;
+}
+
+static void put_u(const char *key, uint64_t value){
+	put_key(key);
+	fprintf(report_out, sim_config.json ? "%lu" : "%lu\n", value);
+}
+
+static void put_f(const char *key, double value, int decimals){
+	put_key(key);
+	fprintf(report_out, sim_config.json ? "%.*f" : "%.*f\n", decimals, value);
+}
+
+static double per(double value, uint64_t count){
+	return count ? value / count : 0.0;
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Prints the report of the run
+ *
+ * @details
+ *	Energy is the MCU's from the time spent in each energy mode at the
+ *	datasheet currents, plus the LEUART while it transmits, which makes the
+ *	baud rate count, and the Si7021 conversions. The HM-10 draws its
+ *	active current all the time and is only added in the system_ keys so a
+ *	driver change is not lost in it. A sample is a sensor conversion.
+ *
+ ******************************************************************************/
+void sim_report(void){
+	char key[32];
+	uint64_t total_ns = 0;
+	double mcu_uj = 0;
+	report_out = sim_config.report ? sim_config.report : stdout;
+	report_first = true;
+	for(uint32_t em = 0; em < SIM_EM_COUNT; em++){
+		total_ns += sim_stats.em_ns[em];
+		mcu_uj += SIM_NS_TO_S(sim_stats.em_ns[em]) * em_ua[em] * SIM_VDD;
+	}
+	mcu_uj += SIM_NS_TO_S(sim_stats.leuart_line_ns) * SIM_LEUART_UA * SIM_VDD;
+	double seconds = SIM_NS_TO_S(total_ns);
+	double sensor_uj = sim_stats.si7021_charge_nc * SIM_VDD / 1000.0;
+	double hm10_uj = seconds * SIM_HM10_UA * SIM_VDD;
+	uint64_t samples = sim_stats.si7021_conversions;
+
+	put_f("sim_time_s", SIM_NS_TO_S(sim_now()), 6);
+	for(uint32_t em = 0; em < SIM_EM_COUNT; em++){
+		snprintf(key, sizeof(key), "em%u_time_s", em);
+		put_f(key, SIM_NS_TO_S(sim_stats.em_ns[em]), 6);
+	}
+	for(uint32_t em = 0; em < SIM_EM_COUNT; em++){
+		snprintf(key, sizeof(key), "em%u_residency_pct", em);
+		put_f(key, 100.0 * per(sim_stats.em_ns[em], total_ns), 4);
+	}
+	put_f("em0_spin_s", SIM_NS_TO_S(sim_stats.spin_ns), 6);
+	put_f("em0_ms_per_sample", per(sim_stats.em_ns[EM0] / 1e6, samples), 4);
+	put_f("mcu_energy_uj", mcu_uj, 3);
+	put_f("si7021_energy_uj", sensor_uj, 3);
+	put_f("total_energy_uj", mcu_uj + sensor_uj, 3);
+	put_f("avg_current_ua", seconds ? (mcu_uj + sensor_uj) / SIM_VDD / seconds : 0.0, 4);
+	put_f("hm10_energy_uj", hm10_uj, 3);
+	put_f("system_avg_current_ua", seconds ? (mcu_uj + sensor_uj + hm10_uj) / SIM_VDD / seconds : 0.0, 4);
+	put_f("energy_per_sample_uj", per(mcu_uj + sensor_uj, samples), 4);
+	put_u("wakeups", sim_stats.wakeups);
+	put_f("wakeups_per_hour", seconds ? sim_stats.wakeups * 3600.0 / seconds : 0.0, 2);
+	put_u("sleep_aborts", sim_stats.sleep_aborts);
+	put_u("samples", samples);
+	put_f("wakeups_per_sample", per(sim_stats.wakeups, samples), 3);
+	for(uint32_t i = 0; i < sizeof(irq_names) / sizeof(irq_names[0]); i++){
+		snprintf(key, sizeof(key), "irq_%s", irq_names[i].name);
+		put_u(key, sim_stats.irqs[irq_names[i].irq]);
+	}
+	put_u("reg_accesses", sim_stats.reg_accesses);
+	put_u("i2c_transfers", sim_stats.i2c_transfers);
+	put_u("i2c_bytes", sim_stats.i2c_bytes);
+	put_u("i2c_nacks", sim_stats.i2c_nacks);
+	put_f("i2c_bus_s", SIM_NS_TO_S(sim_stats.i2c_bus_ns), 6);
+	put_f("i2c_bus_ms_per_sample", per(sim_stats.i2c_bus_ns / 1e6, samples), 4);
+	put_u("leuart_tx_bytes", sim_stats.leuart_tx_bytes);
+	put_f("leuart_line_s", SIM_NS_TO_S(sim_stats.leuart_line_ns), 6);
+	put_u("leuart_rx_bytes", sim_stats.leuart_rx_bytes);
+	put_u("leuart_rx_dropped", sim_stats.leuart_rx_dropped);
+	put_u("ble_data_bytes", sim_stats.hm10_data_bytes);
+	put_f("ble_bytes_per_sample", per(sim_stats.leuart_tx_bytes, samples), 3);
+	put_u("hm10_commands", sim_stats.hm10_commands);
+	put_u("hm10_garbled", sim_stats.hm10_garbled);
+	put_u("dma_bytes", sim_stats.dma_bytes);
+	put_u("dma_wakeups", sim_stats.dma_wakeups);
+	put_u("gpio_toggles", sim_stats.gpio_toggles);
+	put_u("sync_violations", sim_stats.sync_violations);
+	put_u("clock_stalls", sim_stats.stalls);
+	if(sim_config.json) fprintf(report_out, "\n}\n");
+	if(sim_config.report) fclose(sim_config.report);
+	sim_config.report = NULL;
+}
+
+int main(int argc, char **argv){
+	int opt;
+	double seconds = SIM_DEFAULT_SECONDS;
+	sim_config.temp_f = SIM_DEFAULT_TEMP_F;
+	sim_config.rh = SIM_DEFAULT_RH;
+	sim_config.seed = 1;
+	while((opt = getopt_long(argc, argv, "h", options, NULL)) != -1){
+		switch(opt){
+			case 's':	seconds = atof(optarg);							break;
+			case 't':	sim_config.temp_f = atof(optarg);				break;
+			case 'S':	sim_config.temp_slope = atof(optarg);			break;
+			case 'w':	sim_config.temp_swing = atof(optarg);			break;
+			case 'p':	sim_config.swing_period = atof(optarg);			break;
+			case 'n':	sim_config.temp_noise = atof(optarg);			break;
+			case 'r':	sim_config.rh = atof(optarg);					break;
+			case 'x':	sim_config.seed = strtoul(optarg, NULL, 0);		break;
+			case 'c':	sim_config.ble_connected = true;				break;
+			case 'o':	sim_config.capture = open_or_die(optarg);		break;
+			case 'e':	sim_config.echo = true;							break;
+			case 'C':	sim_config.central_send = optarg;				break;
+			case 'R':	sim_config.report = open_or_die(optarg);		break;
+			case 'j':	sim_config.json = true;							break;
+			case 'b':	sim_config.hm10_baud = strtoul(optarg, NULL, 0);	break;
+			case 'h':
+				usage(stdout);
+				return 0;
+			default:
+				usage(stderr);
+				return 1;
+		}
+	}
+	if((optind != argc) || (seconds <= 0)){
+		usage(stderr);
+		return 1;
+	}
+	sim_config.duration = seconds * 1e9;
+
+	sim_init();
+	sim_cmu_init();
+	sim_letimer_init();
+	sim_rtcc_init();
+	sim_i2c_init();
+	sim_leuart_init();
+	sim_si7021_init();
+	sim_hm10_init();
+
+	sim_app_main();
+	sim_fail("the application returned from main()");
+}
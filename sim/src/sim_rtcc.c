@@ -0,0 +1,161 @@
+/**
+ * @file sim_rtcc.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief RTCC model of the host simulator, behind the emlib RTCC functions
+ *
+ * The drivers only reach the RTCC through emlib, so it is not trapped. The
+ * counter is derived from the LFE clock time, which stands still while the
+ * CPU sleeps deeper than the LFE oscillator runs. Compare matches of the
+ * channels are events at the tick the counter reaches their value.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_rtcc.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_RTCC_CHANNELS		3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static struct {
+	bool		enabled;
+	uint32_t	presc;
+	uint64_t	base;			// LFE clock time the counter was 0
+	uint32_t	flags;
+	uint32_t	ien;
+	uint32_t	ccv[SIM_RTCC_CHANNELS];
+	bool		compare[SIM_RTCC_CHANNELS];
+	SIM_EVENT	cc_ev[SIM_RTCC_CHANNELS];
+} rtcc;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Counter frequency in Hz, 0 while the LFE clock is stopped
+ *
+ ******************************************************************************/
+static uint32_t rtcc_hz(void){
+	return sim_cmu_lf_hz(SIM_CLK_LFE) >> rtcc.presc;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Counter ticks since enable, not wrapped
+ *
+ ******************************************************************************/
+static uint64_t rtcc_ticks(void){
+	uint32_t hz = rtcc_hz();
+	if(!rtcc.enabled || !hz) return 0;
+	uint64_t ns = sim_clock_now(SIM_CLK_LFE) - rtcc.base;
+	return (ns / 1000000000ull) * hz + ((ns % 1000000000ull) * hz) / 1000000000ull;
+}
+
+static void update_irq(void){
+	sim_irq_level(RTCC_IRQn, rtcc.flags & rtcc.ien);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Schedules the next match of a compare channel
+ *
+ * @details
+ *	A value equal to the counter matches on the next wrap, as on the part.
+ *
+ ******************************************************************************/
+static void schedule_cc(int ch){
+	uint32_t hz = rtcc_hz();
+	if(!rtcc.enabled || !rtcc.compare[ch] || !hz){
+		sim_cancel(&rtcc.cc_ev[ch]);
+		return;
+	}
+	uint64_t ticks = rtcc_ticks();
+	uint32_t ahead = rtcc.ccv[ch] - (uint32_t)ticks;
+	if(ahead == 0) ahead = UINT32_MAX;
+	uint64_t target = ticks + ahead;
+	uint64_t at = (target / hz) * 1000000000ull + ((target % hz) * 1000000000ull + hz - 1) / hz;
+	sim_schedule(&rtcc.cc_ev[ch], sim_now() + (rtcc.base + at - sim_clock_now(SIM_CLK_LFE)));
+}
+
+static void cc_event(void *ctx){
+	int ch = (int)(intptr_t)ctx;
+	rtcc.flags |= RTCC_IF_CC0 << ch;
+	update_irq();
+	schedule_cc(ch);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Reset state of the RTCC
+ *
+ ******************************************************************************/
+void sim_rtcc_init(void){
+	for(int ch = 0; ch < SIM_RTCC_CHANNELS; ch++){
+		sim_event_init(&rtcc.cc_ev[ch], SIM_CLK_LFE, cc_event, (void *)(intptr_t)ch);
+	}
+}
+
+void RTCC_Init(const RTCC_Init_TypeDef *init){
+	rtcc.presc = init->presc;
+	rtcc.enabled = init->enable;
+	rtcc.base = sim_clock_now(SIM_CLK_LFE);
+	for(int ch = 0; ch < SIM_RTCC_CHANNELS; ch++) schedule_cc(ch);
+}
+
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr){
+	EFM_ASSERT(ch < SIM_RTCC_CHANNELS);
+	rtcc.compare[ch] = (confPtr->chMode == rtccCapComChModeCompare);
+	schedule_cc(ch);
+}
+
+void RTCC_ChannelCCVSet(int ch, uint32_t value){
+	EFM_ASSERT(ch < SIM_RTCC_CHANNELS);
+	rtcc.ccv[ch] = value;
+	schedule_cc(ch);
+}
+
+uint32_t RTCC_ChannelCCVGet(int ch){
+	return rtcc.ccv[ch];
+}
+
+uint32_t RTCC_CounterGet(void){
+	sim_cpu(SIM_REG_ACCESS_NS);
+	return (uint32_t)rtcc_ticks();
+}
+
+void RTCC_IntEnable(uint32_t flags){
+	rtcc.ien |= flags;
+	update_irq();
+}
+
+void RTCC_IntDisable(uint32_t flags){
+	rtcc.ien &= ~flags;
+	update_irq();
+}
+
+void RTCC_IntClear(uint32_t flags){
+	rtcc.flags &= ~flags;
+	update_irq();
+}
+
+uint32_t RTCC_IntGet(void){
+	return rtcc.flags;
+}
+
+uint32_t RTCC_IntGetEnabled(void){
+	return rtcc.flags & rtcc.ien;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file sim_si7021.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Si7021 temperature and humidity sensor model of the host simulator
+ *
+ * The sensor sits at 0x40 on I2C0. It answers the User 1 register commands,
+ * the hold and no hold measurements of temperature and RH, the temperature
+ * of the last RH measurement and reset. A no hold measurement NACKs its
+ * address until the conversion is done; a hold measurement ACKs the read and
+ * stretches SCL until it is. Measurements are followed by their CRC-8 if the
+ * master reads a third byte.
+ *
+ * Conversions take the datasheet typical time of the resolution set in User
+ * 1, an RH measurement also converts the temperature. Their charge at the
+ * typical supply current is reported. The temperature follows the settings
+ * on the command line: a level, a slope, a sine and uniform noise.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <math.h>
+
+#include "sim.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_SI7021_ADDR			0x40
+#define SIM_SI7021_USER1_RESET	0x3A
+#define SIM_SI7021_USER1_WMASK	0x85		// RES1, HTRE and RES0
+#define SIM_SI7021_RESET_US		15000
+#define SIM_SI7021_TEMP_UA		90.0
+#define SIM_SI7021_RH_UA		150.0
+#define SIM_SI7021_OUT_MAX		3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// Typical conversion times in us by the RES1:RES0 code of User 1
+static const uint32_t	temp_us[4] = { 7000, 2400, 4000, 1500 };
+static const uint32_t	rh_us[4] = { 10000, 2600, 3700, 5800 };
+
+static struct {
+	uint8_t		user1;
+	uint8_t		cmd;
+	uint32_t	written;			// bytes written since the address
+	uint64_t	busy_until;			// conversion or reset
+	bool		hold;				// the conversion in progress is a hold measurement
+	uint16_t	temp_code;			// of the last measurement
+	uint16_t	rh_code;
+	uint8_t		out[SIM_SI7021_OUT_MAX];
+	uint32_t	out_len;
+	uint32_t	out_pos;
+	uint32_t	rng;
+} si7021;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Uniform random number in [-1, 1), xorshift32
+ *
+ ******************************************************************************/
+static double noise(void){
+	si7021.rng ^= si7021.rng << 13;
+	si7021.rng ^= si7021.rng >> 17;
+	si7021.rng ^= si7021.rng << 5;
+	return (si7021.rng / 2147483648.0) - 1.0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Ambient temperature in F at a time
+ *
+ ******************************************************************************/
+static double ambient_f(uint64_t now){
+	double t = SIM_NS_TO_S(now);
+	double f = sim_config.temp_f + sim_config.temp_slope * t / 3600.0;
+	if(sim_config.swing_period > 0) f += sim_config.temp_swing * sin(2.0 * M_PI * t / sim_config.swing_period);
+	return f + sim_config.temp_noise * noise();
+}
+
+static uint16_t code(double value){
+	if(value < 0) value = 0;
+	if(value > 65535) value = 65535;
+	return (uint16_t)value & ~3u;
+}
+
+static uint8_t crc8(const uint8_t *data, uint32_t len){
+	uint8_t crc = 0;
+	for(uint32_t i = 0; i < len; i++){
+		crc ^= data[i];
+		for(int bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+	}
+	return crc;
+}
+
+static uint32_t resolution(void){
+	return ((si7021.user1 >> 6) & 0x2) | (si7021.user1 & 0x1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Starts a measurement, its result is ready when the conversion ends
+ *
+ ******************************************************************************/
+static void measure(bool rh, bool hold){
+	uint32_t us = temp_us[resolution()];
+	double celsius = (ambient_f(sim_now()) - 32.0) * 5.0 / 9.0;
+	si7021.temp_code = code((celsius + 46.85) * 65536.0 / 175.72);
+	sim_stats.si7021_conversions++;
+	sim_stats.si7021_charge_nc += us * SIM_SI7021_TEMP_UA / 1000.0;
+	if(rh){
+		si7021.rh_code = code((sim_config.rh + 6.0) * 65536.0 / 125.0);
+		us += rh_us[resolution()];
+		sim_stats.si7021_charge_nc += rh_us[resolution()] * SIM_SI7021_RH_UA / 1000.0;
+	}
+	uint16_t value = rh ? si7021.rh_code : si7021.temp_code;
+	si7021.out[0] = value >> 8;
+	si7021.out[1] = value & 0xFF;
+	si7021.out[2] = crc8(si7021.out, 2);
+	si7021.out_len = 3;
+	si7021.busy_until = sim_now() + SIM_US(us);
+	si7021.hold = hold;
+}
+
+static bool busy(void){
+	return sim_now() < si7021.busy_until;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Address byte, the sensor does not answer while it converts or resets
+ *	unless the master waits in a hold measurement
+ *
+ ******************************************************************************/
+static bool si7021_address(void *ctx, bool read){
+	si7021.written = 0;
+	si7021.out_pos = 0;
+	if(busy() && !(read && si7021.hold)) return false;
+	return true;
+}
+
+static bool si7021_write(void *ctx, uint8_t data){
+	if(si7021.written++ == 0){
+		si7021.cmd = data;
+		si7021.out_len = 0;
+		switch(data){
+			case 0xE7:
+				si7021.out[0] = si7021.user1;
+				si7021.out_len = 1;
+				return true;
+			case 0xE6:
+				return true;
+			case 0xE3:
+			case 0xF3:
+				measure(false, data == 0xE3);
+				return true;
+			case 0xE5:
+			case 0xF5:
+				measure(true, data == 0xE5);
+				return true;
+			case 0xE0:
+				si7021.out[0] = si7021.temp_code >> 8;
+				si7021.out[1] = si7021.temp_code & 0xFF;
+				si7021.out_len = 2;
+				return true;
+			case 0xFE:
+				si7021.user1 = SIM_SI7021_USER1_RESET;
+				si7021.busy_until = sim_now() + SIM_US(SIM_SI7021_RESET_US);
+				si7021.hold = false;
+				return true;
+			default:
+				return false;
+		}
+	}
+	if((si7021.cmd == 0xE6) && (si7021.written == 2)){
+		si7021.user1 = (data & SIM_SI7021_USER1_WMASK) | SIM_SI7021_USER1_RESET;
+		return true;
+	}
+	return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Next byte to the master, the first one of a hold measurement is held
+ *	until the conversion ends
+ *
+ ******************************************************************************/
+static uint8_t si7021_read(void *ctx, uint64_t *ready){
+	if((si7021.out_pos == 0) && si7021.hold && busy()) *ready = si7021.busy_until;
+	if(si7021.out_pos < si7021.out_len) return si7021.out[si7021.out_pos++];
+	return 0xFF;
+}
+
+static void si7021_stop(void *ctx){
+	if(!busy()) si7021.hold = false;
+}
+
+static const SIM_I2C_SLAVE si7021_slave = {
+	si7021_address, si7021_write, si7021_read, si7021_stop, NULL, SIM_SI7021_ADDR
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Power up state, on I2C0
+ *
+ ******************************************************************************/
+void sim_si7021_init(void){
+	si7021.user1 = SIM_SI7021_USER1_RESET;
+	si7021.rng = sim_config.seed ? sim_config.seed : 1;
+	sim_i2c_attach(SIM_PAGE_I2C0, &si7021_slave);
+}
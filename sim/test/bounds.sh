@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Checks the cp_sim report against bounds, run by ctest
+#
+#   sim/test/bounds.sh build-sim/cp_sim sim/test/bounds.txt
+#
+# Runs an hour of the sim/bench room and fails with the keys out of their
+# bounds, or a key missing from the report.
+#
+set -eu
+
+SIM=$1
+BOUNDS=$2
+ENVIRONMENT="--temp 72 --temp-swing 4 --swing-period 1800 --temp-noise 0.2 --seed 1 --ble-connected"
+REPORT=$(mktemp)
+trap 'rm -f "$REPORT"' EXIT
+
+"$SIM" --seconds 3600 $ENVIRONMENT --report "$REPORT"
+grep -v '^[[:space:]]*\(#\|$\)' "$BOUNDS" | tr -d ' \t' | awk -F'|' -v report="$REPORT" '
+	BEGIN { while((getline line < report) > 0){ split(line, kv, " "); value[kv[1]] = kv[2] } }
+	{
+		if(!($1 in value)){ printf "%s: missing\n", $1; failed = 1; next }
+		v = value[$1] + 0
+		if((v < $2 + 0) || (v > $3 + 0)){ printf "%s: %s not in %s..%s\n", $1, value[$1], $2, $3; failed = 1 }
+		else printf "%s: %s\n", $1, value[$1]
+	}
+	END { exit failed }'
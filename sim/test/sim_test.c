@@ -0,0 +1,93 @@
+/**
+ * @file sim_test.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Support of the host unit tests of sim/test
+ *
+ * A test is its own program linked with the simulator and the drivers, run
+ * by ctest. It brings up the simulator with sim_test_start() and the models
+ * it needs, drives the drivers directly and ends with sim_test_done(). A
+ * SIM_CHECK() failure is printed and the test goes on, an EFM_ASSERT() or a
+ * simulator error ends it at once with a non zero status.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "sim_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_TEST_PRINT_MAX	20			// failures printed, the rest only counted
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t			checks;
+static uint32_t			failures;
+static uint32_t			random_state = 1;
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Maps the peripheral pages and starts the clock model, with no end to the
+ *	simulated time
+ *
+ ******************************************************************************/
+void sim_test_start(void){
+	sim_config.duration = SIM_NEVER;
+	sim_init();
+	sim_cmu_init();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Counts a check and prints it if it failed, see SIM_CHECK()
+ *
+ ******************************************************************************/
+bool sim_test_check(bool ok, const char *expr, const char *file, int line){
+	checks++;
+	if(ok) return true;
+	if(++failures > SIM_TEST_PRINT_MAX) return false;
+	fprintf(stderr, "%s:%d: %.6f s: check failed: %s\n", file, line, SIM_NS_TO_S(sim_now()), expr);
+	return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	xorshift32, the same sequence on every run
+ *
+ ******************************************************************************/
+uint32_t sim_test_random(void){
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Prints the result of the test
+ *
+ * @return
+ *	The exit status of the test, 0 if every check passed.
+ *
+ ******************************************************************************/
+int sim_test_done(const char *name){
+	printf("%s: %u checks, %u failed\n", name, checks, failures);
+	return failures ? 1 : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Report of a simulator error or a failed EFM_ASSERT(), a test has none
+ *
+ ******************************************************************************/
+void sim_report(void){
+	fprintf(stderr, "%u checks before the error, %u failed\n", checks, failures);
+}
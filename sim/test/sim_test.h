@@ -0,0 +1,30 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	SIM_TEST_HG
+#define	SIM_TEST_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* The developer's include statements */
+#include "sim.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+/* Checks a condition, a failure is printed and counted, the test goes on */
+#define SIM_CHECK(expr)		sim_test_check((expr), #expr, __FILE__, __LINE__)
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void sim_test_start(void);
+bool sim_test_check(bool ok, const char *expr, const char *file, int line);
+uint32_t sim_test_random(void);
+int sim_test_done(const char *name);
+
+#endif
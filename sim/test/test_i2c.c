@@ -0,0 +1,441 @@
+/**
+ * @file test_i2c.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief I2C transfer queue test against a simulated slave
+ *
+ * A register file device is attached to the I2C1 model. The first byte
+ * written after its address sets the register pointer, the bytes after it
+ * are stored from there; a read returns the registers from the pointer on.
+ * Writing TEST_CONVERT starts a conversion during which the device NACKs
+ * its read address, as the Si7021 does in no hold master mode. The last
+ * register is read only, a write to it is NACKed.
+ *
+ * Scripted transfers cover write only, read only and write-then-read
+ * transfers, NACK polling with and without I2C_XFER_RETRY_NACK, a device
+ * that never ACKs its read address, an absent address and a NACKed data
+ * byte. A chain submitted without waiting, one
+ * of them submitted again from a completion callback, must complete in
+ * order with its events. Random chains then check every byte against a
+ * copy of the registers.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <string.h>
+
+#include "sim_test.h"
+#include "i2c.h"
+#include "irq.h"
+#include "cmu.h"
+#include "rtcc.h"
+#include "trace.h"
+#include "scheduler.h"
+#include "sleep_routines.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_ADDR			0x40
+#define TEST_ABSENT_ADDR	0x55
+#define TEST_REGS			16
+#define TEST_READ_ONLY		(TEST_REGS - 1)
+#define TEST_CONVERT		0x20			// pointer byte that starts a conversion
+#define TEST_CONVERT_NACKS	5				// read addresses NACKed by a conversion
+#define TEST_EVENT			1				// scheduler event of the chained transfers
+#define TEST_CHAIN			4				// transfers of a chain, under EVENT_QUEUE_SIZE
+#define TEST_CHAINS			150
+#define TEST_MAX_LEN		12
+
+typedef struct {
+	uint8_t		regs[TEST_REGS];
+	uint32_t	ptr;
+	bool		ptr_due;			// the next byte written is the pointer
+	bool		on_bus;				// addressed since the last STOP
+	uint32_t	busy;				// read addresses left to NACK
+	uint32_t	addresses;
+	uint32_t	restarts;			// addressed again without a STOP
+	uint32_t	address_nacks;
+	uint32_t	writes;
+	uint32_t	reads;
+	uint32_t	stops;
+} TEST_DEVICE;
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static TEST_DEVICE		dev;
+static uint8_t			regs_ref[TEST_REGS];	// what the registers must hold
+static I2C_XFER_STRUCT	*done_order[2 * TEST_CHAIN];
+static uint32_t			done_count;
+static I2C_XFER_STRUCT	resubmit;
+static uint8_t			resubmit_rx[2];
+static uint32_t			event_calls;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static bool dev_address(void *ctx, bool read){
+	TEST_DEVICE *d = ctx;
+	d->addresses++;
+	if(d->on_bus) d->restarts++;
+	d->on_bus = true;
+	if(read && d->busy){
+		d->busy--;
+		d->address_nacks++;
+		return false;
+	}
+	d->ptr_due = !read;
+	return true;
+}
+
+static bool dev_write(void *ctx, uint8_t data){
+	TEST_DEVICE *d = ctx;
+	d->writes++;
+	if(d->ptr_due){
+		d->ptr_due = false;
+		if(data == TEST_CONVERT){
+			d->busy = TEST_CONVERT_NACKS;
+			return true;
+		}
+		if(data >= TEST_REGS) return false;
+		d->ptr = data;
+		return true;
+	}
+	if(d->ptr == TEST_READ_ONLY) return false;
+	d->regs[d->ptr] = data;
+	d->ptr = (d->ptr + 1) % TEST_REGS;
+	return true;
+}
+
+static uint8_t dev_read(void *ctx, uint64_t *ready){
+	TEST_DEVICE *d = ctx;
+	(void)ready;
+	d->reads++;
+	uint8_t data = d->regs[d->ptr];
+	d->ptr = (d->ptr + 1) % TEST_REGS;
+	return data;
+}
+
+static void dev_stop(void *ctx){
+	TEST_DEVICE *d = ctx;
+	d->stops++;
+	d->on_bus = false;
+}
+
+static const SIM_I2C_SLAVE slave = { dev_address, dev_write, dev_read, dev_stop, &dev, TEST_ADDR };
+
+/***************************************************************************//**
+ * @brief
+ *	Submits a transfer and sleeps until it completes
+ *
+ ******************************************************************************/
+static uint32_t run(I2C_XFER_STRUCT *xfer){
+	i2c_submit(I2C1, xfer);
+	i2c_wait(xfer);
+	SIM_CHECK(!i2c_sm_busy(I2C1));
+	return xfer->status;
+}
+
+static uint32_t write_regs(uint32_t reg, const uint8_t *data, uint32_t len){
+	uint8_t tx[1 + TEST_MAX_LEN];
+	I2C_XFER_STRUCT xfer;
+	tx[0] = reg;
+	memcpy(&tx[1], data, len);
+	i2c_xfer_init(&xfer, TEST_ADDR, tx, 1 + len, NULL, 0);
+	return run(&xfer);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Write only, read only and write-then-read transfers
+ *
+ ******************************************************************************/
+static void test_phases(void){
+	static const uint8_t data[] = { 0x11, 0x22, 0x33, 0x44, 0x55 };
+	uint8_t rx[sizeof(data)];
+	I2C_XFER_STRUCT xfer;
+
+	// write only: address, pointer and data, then STOP
+	uint32_t stops = dev.stops;
+	SIM_CHECK(write_regs(3, data, sizeof(data)) == I2C_XFER_DONE);
+	SIM_CHECK(memcmp(&dev.regs[3], data, sizeof(data)) == 0);
+	SIM_CHECK(dev.stops == stops + 1);
+	memcpy(&regs_ref[3], data, sizeof(data));
+
+	// write-then-read: the read phase follows a repeated START
+	uint32_t restarts = dev.restarts;
+	uint8_t reg = 4;
+	i2c_xfer_init(&xfer, TEST_ADDR, &reg, 1, rx, 3);
+	SIM_CHECK(run(&xfer) == I2C_XFER_DONE);
+	SIM_CHECK(memcmp(rx, &data[1], 3) == 0);
+	SIM_CHECK(dev.restarts == restarts + 1);
+
+	// read only: goes on from the pointer the last transfer left
+	uint32_t reads = dev.reads;
+	uint32_t writes = dev.writes;
+	i2c_xfer_init(&xfer, TEST_ADDR, NULL, 0, rx, 1);
+	SIM_CHECK(run(&xfer) == I2C_XFER_DONE);
+	SIM_CHECK(rx[0] == data[4]);
+	SIM_CHECK(dev.reads == reads + 1);
+	SIM_CHECK(dev.writes == writes);
+	SIM_CHECK(!dev.on_bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Conversion NACK polling, a dead device, an absent address and a NACKed
+ *	data byte
+ *
+ ******************************************************************************/
+static void test_nacks(void){
+	uint8_t cmd = TEST_CONVERT;
+	uint8_t rx[2];
+	I2C_XFER_STRUCT xfer;
+
+	// retried until the device ACKs the read address
+	dev.ptr = 3;
+	i2c_xfer_init(&xfer, TEST_ADDR, &cmd, 1, rx, 2);
+	xfer.flags = I2C_XFER_RETRY_NACK;
+	uint32_t restarts = dev.restarts;
+	SIM_CHECK(run(&xfer) == I2C_XFER_DONE);
+	SIM_CHECK(xfer.nacks == TEST_CONVERT_NACKS);
+	SIM_CHECK(dev.restarts == restarts + TEST_CONVERT_NACKS + 1);
+	SIM_CHECK(memcmp(rx, &regs_ref[3], 2) == 0);
+
+	// without the flag the first NACK ends the transfer
+	i2c_xfer_init(&xfer, TEST_ADDR, &cmd, 1, rx, 2);
+	SIM_CHECK(run(&xfer) == I2C_XFER_NACK);
+	SIM_CHECK(xfer.nacks == 0);
+	SIM_CHECK(dev.busy == TEST_CONVERT_NACKS - 1);
+
+	// a device that never ACKs is given up after nack_max retries, without
+	// holding up the transfer queued behind it
+	static const uint8_t write_next[] = { 5, 0x5A };
+	I2C_XFER_STRUCT next;
+	dev.busy = UINT32_MAX;
+	uint32_t address_nacks = dev.address_nacks;
+	i2c_xfer_init(&xfer, TEST_ADDR, NULL, 0, rx, 2);
+	xfer.flags = I2C_XFER_RETRY_NACK;
+	SIM_CHECK(xfer.nack_max == I2C_XFER_NACK_MAX);
+	i2c_xfer_init(&next, TEST_ADDR, write_next, sizeof(write_next), NULL, 0);
+	i2c_submit(I2C1, &xfer);
+	i2c_submit(I2C1, &next);
+	i2c_wait(&next);
+	SIM_CHECK(xfer.status == I2C_XFER_NACK);
+	SIM_CHECK(xfer.nacks == I2C_XFER_NACK_MAX);
+	SIM_CHECK(dev.address_nacks == address_nacks + I2C_XFER_NACK_MAX + 1);
+	SIM_CHECK(next.status == I2C_XFER_DONE);
+	SIM_CHECK(dev.regs[5] == 0x5A);
+	regs_ref[5] = 0x5A;
+
+	// a lower limit of its own
+	address_nacks = dev.address_nacks;
+	i2c_xfer_init(&xfer, TEST_ADDR, NULL, 0, rx, 2);
+	xfer.flags = I2C_XFER_RETRY_NACK;
+	xfer.nack_max = 3;
+	SIM_CHECK(run(&xfer) == I2C_XFER_NACK);
+	SIM_CHECK(xfer.nacks == 3);
+	SIM_CHECK(dev.address_nacks == address_nacks + 4);
+	dev.busy = 0;
+
+	// nobody answers an absent address, the device never sees the STOP
+	uint32_t stops = dev.stops;
+	uint64_t nacks = sim_stats.i2c_nacks;
+	i2c_xfer_init(&xfer, TEST_ABSENT_ADDR, NULL, 0, rx, 2);
+	SIM_CHECK(run(&xfer) == I2C_XFER_NACK);
+	i2c_xfer_init(&xfer, TEST_ABSENT_ADDR, &cmd, 1, NULL, 0);
+	SIM_CHECK(run(&xfer) == I2C_XFER_NACK);
+	SIM_CHECK(dev.stops == stops);
+	SIM_CHECK(sim_stats.i2c_nacks == nacks + 2);
+
+	// a NACKed data byte ends the write, the bytes after it are not sent
+	uint32_t writes = dev.writes;
+	static const uint8_t data[] = { 0xAA, 0xBB, 0xCC };
+	SIM_CHECK(write_regs(TEST_READ_ONLY - 1, data, sizeof(data)) == I2C_XFER_NACK);
+	SIM_CHECK(dev.writes == writes + 3);
+	SIM_CHECK(dev.regs[TEST_READ_ONLY - 1] == 0xAA);
+	regs_ref[TEST_READ_ONLY - 1] = 0xAA;
+
+	// and the bus works on
+	SIM_CHECK(write_regs(0, data, 1) == I2C_XFER_DONE);
+	regs_ref[0] = data[0];
+	SIM_CHECK(memcmp(dev.regs, regs_ref, TEST_REGS) == 0);
+}
+
+static void event_handler(void){
+	event_calls++;
+}
+
+static void record_done(I2C_XFER_STRUCT *xfer, void *ctx){
+	(void)ctx;
+	SIM_CHECK(!i2c_xfer_pending(xfer));
+	if(SIM_CHECK(done_count < 2 * TEST_CHAIN)) done_order[done_count++] = xfer;
+}
+
+static void submit_again(I2C_XFER_STRUCT *xfer, void *ctx){
+	record_done(xfer, ctx);
+	// a callback may queue the next transfer
+	i2c_xfer_init(&resubmit, TEST_ADDR, NULL, 0, resubmit_rx, 2);
+	resubmit.callback = record_done;
+	i2c_submit(I2C1, &resubmit);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Transfers queued back to back complete in order with their events
+ *
+ ******************************************************************************/
+static void test_chain(void){
+	static const uint8_t write_a[] = { 8, 0xDE, 0xAD, 0xBE, 0xEF };
+	static const uint8_t reg_c = 8;
+	uint8_t rx_b[2];
+	uint8_t rx_c[4];
+	uint8_t rx_d[2];
+	I2C_XFER_STRUCT xfers[TEST_CHAIN];
+	EVENT_MSG_STRUCT msg;
+
+	i2c_xfer_init(&xfers[0], TEST_ADDR, write_a, sizeof(write_a), NULL, 0);
+	i2c_xfer_init(&xfers[1], TEST_ABSENT_ADDR, NULL, 0, rx_b, sizeof(rx_b));
+	i2c_xfer_init(&xfers[2], TEST_ADDR, &reg_c, 1, rx_c, sizeof(rx_c));
+	i2c_xfer_init(&xfers[3], TEST_ADDR, NULL, 0, rx_d, sizeof(rx_d));
+	uint32_t block = current_block_energy_mode();
+	done_count = 0;
+	for(uint32_t i = 0; i < TEST_CHAIN; i++){
+		xfers[i].event = TEST_EVENT;
+		xfers[i].callback = (i == TEST_CHAIN - 1) ? submit_again : record_done;
+		i2c_submit(I2C1, &xfers[i]);
+		SIM_CHECK(i2c_xfer_pending(&xfers[i]));
+	}
+	SIM_CHECK(xfers[0].status == I2C_XFER_BUSY);
+	SIM_CHECK(xfers[1].status == I2C_XFER_QUEUED);
+	SIM_CHECK(current_block_energy_mode() == I2C_EM_BLOCK);
+	i2c_wait(&xfers[TEST_CHAIN - 1]);
+	i2c_wait(&resubmit);
+
+	SIM_CHECK(done_count == TEST_CHAIN + 1);
+	for(uint32_t i = 0; i < TEST_CHAIN; i++) SIM_CHECK(done_order[i] == &xfers[i]);
+	SIM_CHECK(done_order[TEST_CHAIN] == &resubmit);
+	SIM_CHECK(xfers[0].status == I2C_XFER_DONE);
+	SIM_CHECK(xfers[1].status == I2C_XFER_NACK);
+	SIM_CHECK(xfers[2].status == I2C_XFER_DONE);
+	SIM_CHECK(xfers[3].status == I2C_XFER_DONE);
+	SIM_CHECK(resubmit.status == I2C_XFER_DONE);
+	SIM_CHECK(memcmp(rx_c, &write_a[1], sizeof(rx_c)) == 0);
+	SIM_CHECK(memcmp(rx_d, &regs_ref[12], sizeof(rx_d)) == 0);
+	SIM_CHECK(memcmp(resubmit_rx, &regs_ref[14], sizeof(resubmit_rx)) == 0);
+	memcpy(&regs_ref[8], &write_a[1], 4);
+
+	// one record per transfer with an event, the first bytes read in the payload
+	uint32_t records = 0;
+	while(i2c_get_event(I2C1, &msg)){
+		SIM_CHECK(msg.event == TEST_EVENT);
+		if(records == 2) SIM_CHECK(msg.payload == 0xDEADBEEF);
+		if(records == 3) SIM_CHECK(msg.payload == (((uint32_t)rx_d[0] << 8) | rx_d[1]));
+		records++;
+	}
+	SIM_CHECK(records == TEST_CHAIN);
+	SIM_CHECK(!i2c_sm_busy(I2C1));
+	SIM_CHECK(current_block_energy_mode() == block);
+	scheduler_dispatch();
+	SIM_CHECK(event_calls == 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Random chains of transfers, every byte checked against the registers
+ *
+ ******************************************************************************/
+static void test_random(void){
+	I2C_XFER_STRUCT xfers[TEST_CHAIN];
+	uint8_t tx[TEST_CHAIN][1 + TEST_MAX_LEN];
+	uint8_t rx[TEST_CHAIN][TEST_MAX_LEN];
+	uint8_t expect[TEST_CHAIN][TEST_MAX_LEN];
+	uint32_t transfers = 0;
+	uint32_t absent = 0;
+	for(uint32_t chain = 0; chain < TEST_CHAINS; chain++){
+		uint32_t count = 1 + sim_test_random() % TEST_CHAIN;
+		uint32_t ptr = dev.ptr;
+		for(uint32_t i = 0; i < count; i++){
+			uint32_t kind = sim_test_random() % 4;
+			uint32_t tx_len = 0;
+			uint32_t rx_len = 0;
+			uint32_t addr = TEST_ADDR;
+			if(kind != 0){
+				// pointer and data, none to the read only register
+				tx[i][0] = sim_test_random() % TEST_READ_ONLY;
+				tx_len = 1 + sim_test_random() % (TEST_READ_ONLY - tx[i][0]);
+				for(uint32_t j = 1; j < tx_len; j++) tx[i][j] = sim_test_random();
+			}
+			if(kind != 1) rx_len = 1 + sim_test_random() % TEST_MAX_LEN;
+			if((sim_test_random() % 8) == 0){
+				addr = TEST_ABSENT_ADDR;
+				absent++;
+			}
+			i2c_xfer_init(&xfers[i], addr, tx[i], tx_len, rx[i], rx_len);
+			if(addr == TEST_ABSENT_ADDR) continue;
+			// what the device does with it, in queue order
+			if(tx_len){
+				ptr = tx[i][0];
+				for(uint32_t j = 1; j < tx_len; j++) regs_ref[ptr++] = tx[i][j];
+			}
+			for(uint32_t j = 0; j < rx_len; j++){
+				expect[i][j] = regs_ref[ptr];
+				ptr = (ptr + 1) % TEST_REGS;
+			}
+		}
+		for(uint32_t i = 0; i < count; i++) i2c_submit(I2C1, &xfers[i]);
+		i2c_wait(&xfers[count - 1]);
+		for(uint32_t i = 0; i < count; i++){
+			transfers++;
+			if(xfers[i].addr == TEST_ABSENT_ADDR){
+				SIM_CHECK(xfers[i].status == I2C_XFER_NACK);
+				continue;
+			}
+			SIM_CHECK(xfers[i].status == I2C_XFER_DONE);
+			SIM_CHECK(memcmp(rx[i], expect[i], xfers[i].rx_len) == 0);
+		}
+		SIM_CHECK(memcmp(dev.regs, regs_ref, TEST_REGS) == 0);
+		SIM_CHECK(!dev.on_bus);
+	}
+	SIM_CHECK(absent > 0);
+	printf("%u random transfers, %u to an absent address\n", transfers, absent);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	sim_test_start();
+	sim_rtcc_init();
+	sim_i2c_init();
+	sim_i2c_attach(SIM_PAGE_I2C1, &slave);
+	irq_open();
+	cmu_open();
+	trace_open();
+	sleep_open();
+	rtcc_open();
+	scheduler_open();
+	scheduler_register(TEST_EVENT, event_handler, 0);
+
+	I2C_OPEN_STRUCT i2c_setup = {
+		.enable = true,
+		.master = true,
+		.refFreq = 0,
+		.freq = I2C_FREQ_FAST_MAX,
+		.clhr = i2cClockHLRAsymetric,
+	};
+	i2c_open(I2C1, &i2c_setup);
+
+	test_phases();
+	test_nacks();
+	test_chain();
+	test_random();
+	printf("%llu bytes in %llu transfers, %llu NACKs\n", (unsigned long long)sim_stats.i2c_bytes,
+			(unsigned long long)sim_stats.i2c_transfers, (unsigned long long)sim_stats.i2c_nacks);
+	return sim_test_done("test_i2c");
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_leuart_dma.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief LEUART0 transmit test through the LDMA and the TXBL interrupt
+ *
+ * LEUART0 is opened on its own, the HM-10 model connected to a central
+ * whose capture is kept in memory. Random packets of up to LEUART_SPAN_MAX
+ * segments, empty ones among them, are sent with leuart_start_spans() and
+ * the core sleeps until the transmission is done. Every packet must reach
+ * the central byte for byte, raise tx_done_evt once, and wake the core
+ * once with the LDMA moving the bytes from EM2, or for every byte but the
+ * two written before the core sleeps and once more for TXC with the TXBL
+ * interrupt.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_test.h"
+#include "leuart.h"
+#include "ldma.h"
+#include "irq.h"
+#include "cmu.h"
+#include "rtcc.h"
+#include "trace.h"
+#include "sw_timer.h"
+#include "HW_delay.h"
+#include "scheduler.h"
+#include "sleep_routines.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_BAUD			9600
+#define TEST_CONNECT_MS		2100			// the central connects SIM_HM10_CONNECT_MS after power up
+#define TEST_EVENT			1				// tx_done_evt
+#define TEST_DMA_PACKETS	40
+#define TEST_IRQ_PACKETS	10
+#define TEST_SPAN_LEN		48				// longest segment, at least TEST_EARLY_BYTES in the first
+#define TEST_EARLY_BYTES	2				// fill the shift register and TXDATA before the core sleeps
+#define TEST_PACKET_MAX		(LEUART_SPAN_MAX * TEST_SPAN_LEN)
+#define TEST_STREAM_MAX		((TEST_DMA_PACKETS + TEST_IRQ_PACKETS) * TEST_PACKET_MAX)
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static char				*capture;
+static size_t			capture_len;
+static char				sent[TEST_STREAM_MAX];
+static uint32_t			sent_len;
+static uint32_t			tx_done_calls;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void tx_done(void){
+	tx_done_calls++;
+}
+
+static void open_leuart(bool dma){
+	LEUART_OPEN_STRUCT settings;
+	memset(&settings, 0, sizeof(settings));
+	settings.baudrate = TEST_BAUD;
+	settings.databits = leuartDatabits8;
+	settings.enable = leuartEnableTx;
+	settings.parity = leuartNoParity;
+	settings.stopbits = leuartStopbits1;
+	settings.tx_loc = LEUART_ROUTELOC0_TXLOC_LOC18;
+	settings.tx_pin_en = true;
+	settings.tx_en = true;
+	settings.tx_done_evt = TEST_EVENT;
+	settings.tx_dma_en = dma;
+	leuart_open(LEUART0, &settings);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sends a random packet and sleeps until it is on the line
+ *
+ * @return
+ *	Bytes sent
+ *
+ ******************************************************************************/
+static uint32_t send_packet(void){
+	static char data[TEST_PACKET_MAX];
+	LEUART_SPAN_STRUCT spans[LEUART_SPAN_MAX];
+	uint32_t count = 1 + sim_test_random() % LEUART_SPAN_MAX;
+	uint32_t len = 0;
+	for(uint32_t i = 0; i < count; i++){
+		// lowercase only, a lone "AT" would end the connection
+		uint32_t span_len = sim_test_random() % (TEST_SPAN_LEN + 1);
+		if((i == 0) && (span_len < TEST_EARLY_BYTES)) span_len = TEST_EARLY_BYTES;
+		if((i != 0) && ((sim_test_random() % 4) == 0)) span_len = 0;
+		spans[i].src = &data[len];
+		spans[i].len = span_len;
+		for(uint32_t j = 0; j < span_len; j++) data[len++] = 'a' + sim_test_random() % 26;
+	}
+	memcpy(&sent[sent_len], data, len);
+	sent_len += len;
+
+	leuart_start_spans(LEUART0, spans, count);
+	SIM_CHECK(leuart_tx_busy(LEUART0));
+	CORE_DECLARE_IRQ_STATE;
+	while(leuart_tx_busy(LEUART0)){
+		CORE_ENTER_CRITICAL();
+		if(leuart_tx_busy(LEUART0)) enter_sleep();
+		CORE_EXIT_CRITICAL();
+	}
+	scheduler_dispatch();
+	return len;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sends packets, checking the wakeups each one took
+ *
+ ******************************************************************************/
+static void send_packets(bool dma, uint32_t packets){
+	uint64_t bytes = 0;
+	uint64_t wakeups = 0;
+	uint64_t dma_wakeups = sim_stats.dma_wakeups;
+	uint32_t calls = tx_done_calls;
+	open_leuart(dma);
+	for(uint32_t i = 0; i < packets; i++){
+		uint64_t before = sim_stats.wakeups;
+		uint64_t tx_bytes = sim_stats.leuart_tx_bytes;
+		uint32_t len = send_packet();
+		uint64_t woke = sim_stats.wakeups - before;
+		SIM_CHECK(sim_stats.leuart_tx_bytes - tx_bytes == len);
+		if(dma) SIM_CHECK(woke == 1);
+		else SIM_CHECK(woke == len + 1 - TEST_EARLY_BYTES);
+		bytes += len;
+		wakeups += woke;
+	}
+	SIM_CHECK(tx_done_calls - calls == packets);
+	if(dma){
+		// the LDMA serves TXBL from EM2 for every byte written after the core sleeps
+		SIM_CHECK(sim_stats.dma_wakeups - dma_wakeups == bytes - TEST_EARLY_BYTES * packets);
+	} else {
+		SIM_CHECK(sim_stats.dma_wakeups == dma_wakeups);
+	}
+	printf("%s: %llu bytes in %u packets, %llu wakeups, %llu LDMA wakeups\n", dma ? "LDMA" : "TXBL",
+			(unsigned long long)bytes, packets, (unsigned long long)wakeups,
+			(unsigned long long)(sim_stats.dma_wakeups - dma_wakeups));
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	sim_config.ble_connected = true;
+	sim_config.capture = open_memstream(&capture, &capture_len);
+	sim_test_start();
+	sim_rtcc_init();
+	sim_leuart_init();
+	sim_hm10_init();
+	irq_open();
+	cmu_open();
+	trace_open();
+	sleep_open();
+	rtcc_open();
+	sw_timer_open(&rtcc_timer_port);
+	scheduler_open();
+	scheduler_register(TEST_EVENT, tx_done, 0);
+	ldma_open();
+	timer_delay(TEST_CONNECT_MS);
+
+	send_packets(true, TEST_DMA_PACKETS);
+	send_packets(false, TEST_IRQ_PACKETS);
+
+	// the central received the packets in order, nothing garbled
+	fflush(sim_config.capture);
+	SIM_CHECK(capture_len == sent_len);
+	SIM_CHECK((capture_len == sent_len) && !memcmp(capture, sent, sent_len));
+	SIM_CHECK(sim_stats.hm10_garbled == 0);
+	SIM_CHECK(sim_stats.sync_violations == 0);
+	SIM_CHECK(sim_stats.stalls == 0);
+	fclose(sim_config.capture);
+	free(capture);
+	return sim_test_done("test_leuart_dma");
+}
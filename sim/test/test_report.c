@@ -0,0 +1,180 @@
+/**
+ * @file test_report.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Report-on-change test on synthetic traces
+ *
+ * Scripted traces step through each rule of report_check(): the first
+ * reading, the deadband edges, min_interval, the max_interval heartbeat,
+ * the alarm hysteresis and a timestamp that wraps between two readings.
+ * Each reading lists the flags it must return; a reading that is sent is
+ * passed to report_sent() as the application does.
+ *
+ * A long random walk, its timestamps starting just below the wrap, then
+ * checks the rules hold together: every report is the first, an alarm
+ * edge, a heartbeat or a change past the deadband no sooner than
+ * min_interval, no report is more than a sample late past max_interval,
+ * and the alarm follows a hysteresis reference.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdlib.h>
+
+#include "sim_test.h"
+#include "report.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_SEND			REPORT_SEND
+#define TEST_EDGE			(REPORT_SEND | REPORT_ALARM_EDGE)
+#define TEST_WALK_SAMPLES	200000
+#define TEST_WALK_STEP		2700			// ticks between samples
+#define TEST_WALK_START		0xFFF00000u
+
+typedef struct {
+	uint32_t	now;
+	int32_t		value;
+	uint32_t	flags;				// report_check() must return these
+} TEST_READING;
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const REPORT_CONFIG_STRUCT plain = {
+	.deadband = 10, .min_interval = 100, .max_interval = 1000,
+	.alarm_en = false,
+};
+
+static const REPORT_CONFIG_STRUCT alarmed = {
+	.deadband = 10, .min_interval = 100, .max_interval = 0,
+	.alarm_en = true, .alarm_on = 8000, .alarm_off = 7900,
+};
+
+// first reading, deadband edges both ways, min_interval, heartbeat
+static const TEST_READING deadband_trace[] = {
+	{    0, 7000, TEST_SEND },		// first reading
+	{  200, 7010, 0 },				// exactly the deadband is no change
+	{  300, 6990, 0 },
+	{  400, 7011, TEST_SEND },		// past it
+	{  450, 7030, 0 },				// moved, but before min_interval
+	{  499, 7030, 0 },
+	{  500, 7030, TEST_SEND },		// min_interval passed
+	{  600, 7019, TEST_SEND },		// past it downwards
+	{ 1599, 7019, 0 },				// unchanged, heartbeat not due
+	{ 1600, 7019, TEST_SEND },		// heartbeat
+};
+
+// hysteresis, and an edge inside min_interval
+static const TEST_READING alarm_trace[] = {
+	{    0, 7950, TEST_SEND },		// first reading, below alarm_on
+	{   50, 8000, 0 },				// at alarm_on is not above it
+	{   60, 8001, TEST_EDGE },		// asserts, min_interval ignored
+	{  300, 7950, TEST_SEND },		// between the thresholds it stays, a change is sent
+	{  310, 7901, 0 },
+	{  320, 7900, TEST_EDGE },		// clears at alarm_off
+	{  330, 7950, 0 },				// stays cleared below alarm_on
+	{  430, 8005, TEST_EDGE },
+};
+
+// the timestamps wrap between two readings
+static const TEST_READING wrap_trace[] = {
+	{ 0xFFFFFF00u, 7000, TEST_SEND },
+	{ 0xFFFFFF50u, 7100, 0 },		// 0x50 ticks, before min_interval
+	{ 0x00000010u, 7100, TEST_SEND },	// 0x110 ticks across the wrap
+	{ 0x000003F0u, 7100, 0 },
+	{ 0x00000410u, 7100, TEST_SEND },	// heartbeat 1000 ticks later
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Runs a scripted trace on a new channel
+ *
+ ******************************************************************************/
+static void run_trace(const REPORT_CONFIG_STRUCT *config, const TEST_READING *trace, uint32_t count){
+	REPORT_CHANNEL_STRUCT channel;
+	report_init(&channel, config);
+	for(uint32_t i = 0; i < count; i++){
+		uint32_t flags = report_check(&channel, trace[i].now, trace[i].value);
+		if(!SIM_CHECK(flags == trace[i].flags)){
+			fprintf(stderr, "  reading %u: %ld at %lu returned 0x%lx\n", i, (long)trace[i].value,
+					(unsigned long)trace[i].now, (unsigned long)flags);
+		}
+		if(flags & REPORT_SEND) report_sent(&channel, trace[i].now, trace[i].value);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Random walk of the temperature, with the rules checked on every reading
+ *
+ ******************************************************************************/
+static void run_walk(void){
+	REPORT_CONFIG_STRUCT config = alarmed;
+	config.max_interval = 20 * TEST_WALK_STEP;
+	config.min_interval = 3 * TEST_WALK_STEP;
+	REPORT_CHANNEL_STRUCT channel;
+	report_init(&channel, &config);
+
+	uint32_t now = TEST_WALK_START;
+	int32_t value = 7950;
+	bool alarm = false;
+	bool first = true;
+	uint32_t last_time = 0;
+	int32_t last_value = 0;
+	uint32_t sends = 0;
+	uint32_t edges = 0;
+	for(uint32_t i = 0; i < TEST_WALK_SAMPLES; i++){
+		value += (int32_t)(sim_test_random() % 9) - 4;
+		if(value < 7700) value = 7700;
+		if(value > 8200) value = 8200;
+		now += TEST_WALK_STEP;
+
+		bool alarm_ref = alarm ? (value > config.alarm_off) : (value > config.alarm_on);
+		uint32_t flags = report_check(&channel, now, value);
+		SIM_CHECK(report_alarm(&channel) == alarm_ref);
+		SIM_CHECK(((flags & REPORT_ALARM_EDGE) != 0) == (alarm_ref != alarm));
+		alarm = alarm_ref;
+		if(flags & REPORT_ALARM_EDGE) edges++;
+
+		uint32_t elapsed = now - last_time;
+		if(!first){
+			// the heartbeat is never more than a sample late
+			SIM_CHECK(elapsed < config.max_interval + TEST_WALK_STEP);
+		}
+		if(!(flags & REPORT_SEND)) continue;
+		if(!first && !(flags & REPORT_ALARM_EDGE) && (elapsed < config.max_interval)){
+			// a change report: past the deadband and no sooner than min_interval
+			SIM_CHECK(abs(value - last_value) > config.deadband);
+			SIM_CHECK(elapsed >= config.min_interval);
+		}
+		report_sent(&channel, now, value);
+		first = false;
+		last_time = now;
+		last_value = value;
+		sends++;
+	}
+	SIM_CHECK(now < TEST_WALK_START);		// the timestamps wrapped
+	SIM_CHECK(edges > 0);
+	printf("random walk: %u readings, %u reported, %u alarm edges\n", TEST_WALK_SAMPLES, sends, edges);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	sim_test_start();
+	run_trace(&plain, deadband_trace, sizeof(deadband_trace) / sizeof(deadband_trace[0]));
+	run_trace(&alarmed, alarm_trace, sizeof(alarm_trace) / sizeof(alarm_trace[0]));
+	run_trace(&plain, wrap_trace, sizeof(wrap_trace) / sizeof(wrap_trace[0]));
+	run_walk();
+	return sim_test_done("test_report");
+}
@@ -0,0 +1,239 @@
+/**
+ * @file test_ring_buffer.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Stress test of the frame ring buffer
+ *
+ * Random producer and consumer operations, against a reference queue of the
+ * frames that should be in the ring. Every ring size of the firmware and
+ * every full buffer policy is run, frame lengths from empty to the whole
+ * buffer so the wrap marker is hit on most laps. Each frame's payload is a
+ * pattern of its sequence number, so a lost, repeated, reordered or torn
+ * frame is caught when it comes out.
+ *
+ * Checked after every operation: the ring is empty exactly when the
+ * reference is, the free space never exceeds the size, a frame handed out
+ * is contiguous inside the storage, and frames that fit in an empty ring
+ * are never refused.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <string.h>
+
+#include "sim_test.h"
+#include "ring_buffer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_OPERATIONS		200000		// per size and policy
+#define TEST_REF_MAX		1024		// frames the reference holds, more than any ring
+#define TEST_PEEK_MAX		4			// frames handed out by one peek
+#define TEST_RING_MAX		512
+
+typedef struct {
+	uint32_t	seq;
+	uint32_t	len;
+} TEST_FRAME;
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static RING_BUF_STRUCT		ring;
+static uint8_t				storage[TEST_RING_MAX + 16];	// guard bytes past the ring
+static TEST_FRAME			ref[TEST_REF_MAX];
+static uint32_t				ref_head;
+static uint32_t				ref_tail;
+static uint32_t				next_seq;
+static uint32_t				ref_dropped;
+static uint32_t				block_waits;
+static uint32_t				out_count;		// frames handed out by the last peek
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static uint8_t pattern(uint32_t seq, uint32_t i){
+	return (uint8_t)(seq * 31 + i * 7 + 1);
+}
+
+static uint32_t ref_count(void){
+	return ref_tail - ref_head;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Checks a frame that came out of the ring against the oldest reference
+ *
+ ******************************************************************************/
+static void check_frame(const uint8_t *frame, uint32_t len, uint32_t nth){
+	if(!SIM_CHECK(nth < ref_count())) return;
+	TEST_FRAME *expect = &ref[(ref_head + nth) % TEST_REF_MAX];
+	SIM_CHECK(len == expect->len);
+	for(uint32_t i = 0; (i < len) && (i < expect->len); i++){
+		if(!SIM_CHECK(frame[i] == pattern(expect->seq, i))) break;
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Consumer side of a full ring, as the LEUART would make progress
+ *
+ * @details
+ *	Frames handed out by a peek finish their transfer and are released,
+ *	otherwise the oldest frame is sent.
+ *
+ ******************************************************************************/
+static void test_block_wait(void){
+	uint8_t frame[TEST_RING_MAX];
+	block_waits++;
+	if(ring.peeked){
+		ring_buf_release(&ring);
+		ref_head += out_count;
+		out_count = 0;
+		return;
+	}
+	uint32_t len = ring_buf_pop(&ring, frame, sizeof(frame));
+	SIM_CHECK(ref_count() > 0);
+	check_frame(frame, len, 0);
+	ref_head++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Queues a frame, by push or by reserve and a shorter commit
+ *
+ ******************************************************************************/
+static void produce(uint32_t max_len){
+	uint32_t len = sim_test_random() % (max_len + 1);
+	uint32_t reserve = len;
+	bool in_place = sim_test_random() & 1;
+	if(in_place) reserve += sim_test_random() % 8;
+	if(ring_buf_frame_size(reserve) > ring.size) return;
+
+	bool was_empty = ring_buf_empty(&ring);
+	uint32_t dropped = ring.dropped;
+	uint32_t seq = next_seq++;
+	uint8_t payload[TEST_RING_MAX];
+	for(uint32_t i = 0; i < len; i++) payload[i] = pattern(seq, i);
+
+	bool queued;
+	if(in_place){
+		uint8_t *dst = ring_buf_reserve(&ring, reserve);
+		queued = (dst != NULL);
+		if(queued){
+			SIM_CHECK((dst >= storage) && (dst + reserve <= storage + ring.size));
+			memcpy(dst, payload, len);
+			ring_buf_commit(&ring, len);
+		}
+	} else {
+		queued = ring_buf_push(&ring, payload, len);
+	}
+
+	// an empty ring always takes a frame that fits
+	if(was_empty) SIM_CHECK(queued);
+	if(ring.policy == RING_DROP_OLDEST){
+		// the oldest frames went, after the ones in flight were released
+		SIM_CHECK(queued);
+		uint32_t lost = ring.dropped - dropped;
+		SIM_CHECK(lost <= ref_count());
+		ref_head += lost;
+		ref_dropped += lost;
+	} else if(!queued){
+		SIM_CHECK(ring.policy == RING_DROP_NEWEST);
+		SIM_CHECK(ring.dropped == dropped + 1);
+		ref_dropped++;
+	}
+	if(queued){
+		ref[ref_tail++ % TEST_REF_MAX] = (TEST_FRAME){ seq, len };
+	}
+	SIM_CHECK(ref_count() < TEST_REF_MAX);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Takes frames out, one by pop or several by peek and release
+ *
+ ******************************************************************************/
+static void consume(void){
+	if(sim_test_random() & 1){
+		uint8_t frame[TEST_RING_MAX];
+		uint32_t len = ring_buf_pop(&ring, frame, sizeof(frame));
+		if(ref_count() == 0){
+			SIM_CHECK(len == 0);
+			return;
+		}
+		check_frame(frame, len, 0);
+		ref_head++;
+		return;
+	}
+	uint8_t *frames[TEST_PEEK_MAX];
+	uint32_t lens[TEST_PEEK_MAX];
+	uint32_t max = 1 + sim_test_random() % TEST_PEEK_MAX;
+	uint32_t count = ring_buf_peek_frames(&ring, frames, lens, max);
+	SIM_CHECK(count == ((ref_count() < max) ? ref_count() : max));
+	for(uint32_t i = 0; i < count; i++){
+		SIM_CHECK((frames[i] >= storage) && (frames[i] + lens[i] <= storage + ring.size));
+		check_frame(frames[i], lens[i], i);
+	}
+	if(!count) return;
+	out_count = count;
+
+	// the frames stay put while they are out, unless the producer had to wait for them
+	if(sim_test_random() & 1) produce(ring.size / 4);
+	if(!out_count) return;
+	uint32_t again = ring_buf_peek_frames(&ring, frames, lens, max);
+	SIM_CHECK(again == count);
+	for(uint32_t i = 0; i < again; i++) check_frame(frames[i], lens[i], i);
+	ring_buf_release(&ring);
+	ref_head += count;
+	out_count = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Runs the random operations on one size and policy
+ *
+ ******************************************************************************/
+static void stress(uint32_t size, RING_POLICY policy){
+	memset(storage, 0xA5, sizeof(storage));
+	ring_buf_init(&ring, storage, size, policy, (policy == RING_DROP_NEWEST) ? NULL : test_block_wait);
+	ref_head = ref_tail = 0;
+	ref_dropped = 0;
+
+	for(uint32_t op = 0; op < TEST_OPERATIONS; op++){
+		// lengths up to the whole ring on some laps, short frames on most
+		uint32_t max_len = (sim_test_random() % 16) ? size / 8 : size;
+		if(sim_test_random() % 3) produce(max_len);
+		else consume();
+		SIM_CHECK(ring_buf_empty(&ring) == (ref_count() == 0));
+		SIM_CHECK(ring_buf_space(&ring) <= ring.size);
+		SIM_CHECK(ring.dropped == ref_dropped);
+	}
+	while(ref_count()) consume();
+	SIM_CHECK(ring_buf_empty(&ring));
+	SIM_CHECK(ring_buf_space(&ring) == ring.size);
+	for(uint32_t i = size; i < sizeof(storage); i++){
+		if(!SIM_CHECK(storage[i] == 0xA5)) break;
+	}
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	static const uint32_t sizes[] = { 16, 64, TEST_RING_MAX };
+	static const RING_POLICY policies[] = { RING_DROP_NEWEST, RING_DROP_OLDEST, RING_BLOCK };
+	sim_test_start();
+	for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+		for(uint32_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++){
+			stress(sizes[s], policies[p]);
+		}
+	}
+	SIM_CHECK(block_waits > 0);
+	return sim_test_done("test_ring_buffer");
+}
@@ -0,0 +1,218 @@
+/**
+ * @file test_scheduler.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Dispatch order and overhead test of the scheduler
+ *
+ * Every event id is registered at a shuffled priority, across both pending
+ * words. Random sets of events are posted, some twice, and one dispatch must
+ * call each posted handler once, from the highest priority to the lowest.
+ * Handlers that post or remove events check that a post is left for the next
+ * dispatch and a removed event is not called.
+ *
+ * The overhead is timed on the host: a dispatch of one pending event among
+ * every registered one against one among a single registered event. The
+ * scheduler finds the next event with a count leading zeros, so the two
+ * must cost about the same.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <time.h>
+
+#include "sim_test.h"
+#include "scheduler.h"
+#include "trace.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_EVENTS			(SCHEDULER_MAX_EVENTS - 1)	// ids 1 to SCHEDULER_MAX_EVENTS - 1
+#ifdef TRACE_ENABLED
+#define TEST_ROUNDS			500			// every handler traps on the cycle counter
+#define TEST_TIMED_DISPATCHES	2000
+#else
+#define TEST_ROUNDS			20000
+#define TEST_TIMED_DISPATCHES	200000
+#endif
+#define TEST_TIMED_RUNS		5			// the fastest run is taken
+#define TEST_OVERHEAD_RATIO	2			// most a full scheduler may cost over an empty one
+
+// one handler per event id, each records its id, named by its two octal digits
+#define TEST_HANDLER(n)		static void handler_##n(void){ handled(0##n); }
+#define TEST_HANDLERS_8(n)	TEST_HANDLER(n##0) TEST_HANDLER(n##1) TEST_HANDLER(n##2) TEST_HANDLER(n##3) \
+							TEST_HANDLER(n##4) TEST_HANDLER(n##5) TEST_HANDLER(n##6) TEST_HANDLER(n##7)
+#define TEST_NAMES_8(n)		handler_##n##0, handler_##n##1, handler_##n##2, handler_##n##3, \
+							handler_##n##4, handler_##n##5, handler_##n##6, handler_##n##7
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t			priority[SCHEDULER_MAX_EVENTS];		// event id -> priority
+static uint32_t			order[SCHEDULER_MAX_EVENTS];		// ids in the order handled
+static uint32_t			handled_count;
+static uint32_t			calls[SCHEDULER_MAX_EVENTS];
+static uint32_t			post_from[SCHEDULER_MAX_EVENTS];	// id a handler posts, 0 for none
+static uint32_t			remove_from[SCHEDULER_MAX_EVENTS];	// id a handler removes, 0 for none
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void handled(uint32_t event){
+	if(handled_count < SCHEDULER_MAX_EVENTS) order[handled_count] = event;
+	handled_count++;
+	calls[event]++;
+	if(post_from[event]) add_scheduled_event(post_from[event]);
+	if(remove_from[event]) remove_scheduled_event(remove_from[event]);
+}
+
+TEST_HANDLERS_8(0) TEST_HANDLERS_8(1) TEST_HANDLERS_8(2) TEST_HANDLERS_8(3)
+TEST_HANDLERS_8(4) TEST_HANDLERS_8(5) TEST_HANDLERS_8(6) TEST_HANDLERS_8(7)
+
+static const SCHEDULER_HANDLER handlers[SCHEDULER_MAX_EVENTS] = {
+	TEST_NAMES_8(0), TEST_NAMES_8(1), TEST_NAMES_8(2), TEST_NAMES_8(3),
+	TEST_NAMES_8(4), TEST_NAMES_8(5), TEST_NAMES_8(6), TEST_NAMES_8(7)
+};
+
+/***************************************************************************//**
+ * @brief
+ *	Registers every event id at a shuffled priority
+ *
+ ******************************************************************************/
+static void register_shuffled(void){
+	uint32_t slots[SCHEDULER_MAX_EVENTS];
+	for(uint32_t i = 0; i < SCHEDULER_MAX_EVENTS; i++) slots[i] = i;
+	for(uint32_t i = SCHEDULER_MAX_EVENTS - 1; i > 0; i--){
+		uint32_t j = sim_test_random() % (i + 1);
+		uint32_t t = slots[i];
+		slots[i] = slots[j];
+		slots[j] = t;
+	}
+	scheduler_open();
+	for(uint32_t event = 1; event <= TEST_EVENTS; event++){
+		priority[event] = slots[event];
+		scheduler_register(event, handlers[event], priority[event]);
+	}
+}
+
+static void reset_calls(void){
+	handled_count = 0;
+	for(uint32_t i = 0; i < SCHEDULER_MAX_EVENTS; i++){
+		calls[i] = 0;
+		post_from[i] = 0;
+		remove_from[i] = 0;
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Posts a random set of events and checks one dispatch of it
+ *
+ ******************************************************************************/
+static void check_order(void){
+	bool posted[SCHEDULER_MAX_EVENTS] = { false };
+	bool removed[SCHEDULER_MAX_EVENTS] = { false };
+	reset_calls();
+	uint32_t density = 1 + sim_test_random() % 4;
+	for(uint32_t event = 1; event <= TEST_EVENTS; event++){
+		if(sim_test_random() % density) continue;
+		add_scheduled_event(event);
+		if(sim_test_random() & 1) add_scheduled_event(event);	// a second post is the same event
+		posted[event] = true;
+		SIM_CHECK(scheduled_event_pending(event));
+	}
+	// one handler posts an event that is not pending, another removes a lower priority one
+	uint32_t poster = 1 + sim_test_random() % TEST_EVENTS;
+	uint32_t post = 1 + sim_test_random() % TEST_EVENTS;
+	bool left = posted[poster] && !posted[post];
+	if(left) post_from[poster] = post;
+	uint32_t remover = 1 + sim_test_random() % TEST_EVENTS;
+	uint32_t remove = 1 + sim_test_random() % TEST_EVENTS;
+	if(posted[remover] && posted[remove] && (priority[remove] > priority[remover]) && (remove != poster)){
+		remove_from[remover] = remove;
+		removed[remove] = true;
+	}
+
+	scheduler_dispatch();
+	uint32_t expected = 0;
+	for(uint32_t event = 1; event <= TEST_EVENTS; event++){
+		uint32_t want = (posted[event] && !removed[event]) ? 1 : 0;
+		SIM_CHECK(calls[event] == want);
+		expected += want;
+	}
+	SIM_CHECK(handled_count == expected);
+	for(uint32_t i = 1; (i < handled_count) && (i < SCHEDULER_MAX_EVENTS); i++){
+		SIM_CHECK(priority[order[i - 1]] < priority[order[i]]);
+	}
+
+	// the post from a handler is left for the next dispatch, nothing else is
+	SIM_CHECK((get_scheduled_events() != 0) == left);
+	if(left) SIM_CHECK(scheduled_event_pending(post));
+	reset_calls();
+	scheduler_dispatch();
+	SIM_CHECK(handled_count == (left ? 1 : 0));
+	if(left) SIM_CHECK(calls[post] == 1);
+	SIM_CHECK(get_scheduled_events() == 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Host ns of a dispatch of one pending event, the fastest of several runs
+ *
+ ******************************************************************************/
+static double dispatch_ns(uint32_t event){
+	double best = 0;
+	for(uint32_t run = 0; run < TEST_TIMED_RUNS; run++){
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(uint32_t i = 0; i < TEST_TIMED_DISPATCHES; i++){
+			add_scheduled_event(event);
+			scheduler_dispatch();
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / TEST_TIMED_DISPATCHES;
+		if((run == 0) || (ns < best)) best = ns;
+	}
+	return best;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Checks that the dispatch cost does not grow with the registered events
+ *
+ ******************************************************************************/
+static void check_overhead(void){
+	reset_calls();
+	scheduler_open();
+	scheduler_register(1, handlers[1], SCHEDULER_MAX_EVENTS - 1);
+	double alone = dispatch_ns(1);
+
+	reset_calls();
+	scheduler_open();
+	for(uint32_t event = 1; event <= TEST_EVENTS; event++){
+		priority[event] = event;
+		scheduler_register(event, handlers[event], event);
+	}
+	double full = dispatch_ns(TEST_EVENTS);		// the lowest priority, the last word
+	SIM_CHECK(calls[TEST_EVENTS] == TEST_TIMED_RUNS * TEST_TIMED_DISPATCHES);
+	printf("dispatch of one event: %.1f ns with 1 registered, %.1f ns with %u\n", alone, full, TEST_EVENTS);
+	SIM_CHECK(full < alone * TEST_OVERHEAD_RATIO);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	sim_test_start();
+	trace_open();		// with TRACE_ENABLED the dispatch reads the cycle counter
+	for(uint32_t round = 0; round < TEST_ROUNDS; round++){
+		if((round % 100) == 0) register_shuffled();
+		check_order();
+	}
+	check_overhead();
+	return sim_test_done("test_scheduler");
+}
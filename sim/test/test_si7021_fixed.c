@@ -0,0 +1,159 @@
+/**
+ * @file test_si7021_fixed.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Fixed point against float conversion of every Si7021 code
+ *
+ * For all 65536 codes the hundredths of tempCentiC_si7021(),
+ * tempCentiF_si7021() and rhCenti_si7021() must be the datasheet formula
+ * rounded to the nearest hundredth.
+ *
+ * The text fmt_tenths() prints from the unrounded fractions of
+ * tempNumC_si7021(), tempNumF_si7021() and rhNum_si7021() must be the
+ * datasheet formula rounded once to tenths, a tie to even, worked out here
+ * in integers. It must also be the text of the float path it replaced: the
+ * float formula and "%.1f", with a ".0" tenth left out. That path is itself
+ * wrong at the two temperature F codes of misrounded_f[], where narrowing
+ * to float moves a value a hair from a tie across it. Only there may the
+ * two texts differ, and the test checks the float value did cross.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_test.h"
+#include "Si7021.h"
+#include "fmt.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_CODES			65536
+#define TEST_TEXT_MAX		24
+#define TEST_KINDS			3
+#define TEST_TIE_NEAR		1e-5		// distance to a tie the float path can cross
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const uint32_t	misrounded_f[] = { 6937, 26683 };
+static uint32_t			float_off[TEST_KINDS];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	The text of the float path: "%.1f" with a ".0" tenth and a "-0" left out
+ *
+ ******************************************************************************/
+static void float_text(char *dst, float value){
+	snprintf(dst, TEST_TEXT_MAX, "%.1f", value);
+	uint32_t len = strlen(dst);
+	if((len >= 2) && !strcmp(&dst[len - 2], ".0")) dst[len - 2] = '\0';
+	if(!strcmp(dst, "-0")) strcpy(dst, "0");
+}
+
+/***************************************************************************//**
+ * @brief
+ *	num / den rounded to tenths, a tie to even, as text
+ *
+ ******************************************************************************/
+static void exact_text(char *dst, int64_t num, int64_t den){
+	int64_t scaled = llabs(num) * 10;
+	int64_t deci = scaled / den;
+	int64_t rem = scaled % den;
+	if((2 * rem > den) || ((2 * rem == den) && (deci & 1))) deci++;
+	int n = snprintf(dst, TEST_TEXT_MAX, "%s%lld", ((num < 0) && deci) ? "-" : "", (long long)(deci / 10));
+	if(deci % 10) snprintf(&dst[n], TEST_TEXT_MAX - n, ".%d", (int)(deci % 10));
+}
+
+static bool is_misrounded(uint32_t kind, uint32_t code){
+	if(kind != 1) return false;
+	for(uint32_t i = 0; i < sizeof(misrounded_f) / sizeof(misrounded_f[0]); i++){
+		if(misrounded_f[i] == code) return true;
+	}
+	return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Checks the printed fixed point value against exact rounding and the
+ *	float path
+ *
+ ******************************************************************************/
+static void check_text(uint32_t kind, uint32_t code, int64_t num, uint32_t den,
+		int64_t exact_num, int64_t exact_den, float value){
+	char fixed[TEST_TEXT_MAX];
+	char exact[TEST_TEXT_MAX];
+	char reference[TEST_TEXT_MAX];
+	fixed[fmt_tenths(fixed, num, den)] = '\0';
+	SIM_CHECK(strlen(fixed) <= FMT_TENTHS_MAX_LEN);
+	exact_text(exact, exact_num, exact_den);
+	float_text(reference, value);
+	if(!SIM_CHECK(!strcmp(fixed, exact))){
+		fprintf(stderr, "  code %u kind %u: %s, exactly %s\n", code, kind, fixed, exact);
+	}
+	if(!strcmp(fixed, reference)){
+		SIM_CHECK(!is_misrounded(kind, code));
+		return;
+	}
+	float_off[kind]++;
+	if(!SIM_CHECK(is_misrounded(kind, code))){
+		fprintf(stderr, "  code %u kind %u: %s, the float path %s\n", code, kind, fixed, reference);
+	}
+	// a value within float error of a tie, on the other side of it in float
+	double tenths = 10.0 * exact_num / exact_den;
+	SIM_CHECK(fabs(fabs(tenths - trunc(tenths)) - 0.5) < 10 * TEST_TIE_NEAR);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	static const char *kind_name[TEST_KINDS] = { "temperature C", "temperature F", "RH" };
+	sim_test_start();
+
+	for(uint32_t code = 0; code < TEST_CODES; code++){
+		int32_t centi_c = tempCentiC_si7021(code);
+		int32_t centi_f = tempCentiF_si7021(code);
+		int32_t centi_rh = rhCenti_si7021(code);
+
+		// the datasheet formulas, rounded to the nearest hundredth
+		double exact_c = 17572.0 * code / 65536 - 4685;
+		double exact_f = exact_c * 9 / 5 + 3200;
+		double exact_rh = 12500.0 * code / 65536 - 600;
+		SIM_CHECK(fabs(centi_c - exact_c) <= 0.5 + 1e-9);
+		SIM_CHECK(fabs(centi_f - exact_f) <= 0.5 + 1e-9);
+		SIM_CHECK(fabs(centi_rh - exact_rh) <= 0.5 + 1e-9);
+
+		// the same formulas as exact fractions: C = (17572 code - 4685 * 65536) / 6553600
+		int64_t c_num = 17572ll * code - 4685ll * 65536;
+		int64_t c_den = 6553600;
+		int64_t f_num = 9 * c_num + 32 * 5 * c_den;
+		int64_t f_den = 5 * c_den;
+		int64_t rh_num = 12500ll * code - 600ll * 65536;
+		int64_t rh_den = 6553600;
+
+		// the float path the fixed point replaced
+		float temp_c = ((175.72 * (float)code) / 65536) - 46.85;
+		float temp_f = (temp_c * (9.0 / 5.0)) + 32;
+		float rh = ((125.0 * (float)code) / 65536) - 6;
+		check_text(0, code, tempNumC_si7021(code), SI7021_TEMP_C_DEN, c_num, c_den, temp_c);
+		check_text(1, code, tempNumF_si7021(code), SI7021_TEMP_F_DEN, f_num, f_den, temp_f);
+		check_text(2, code, rhNum_si7021(code), SI7021_RH_DEN, rh_num, rh_den, rh);
+	}
+
+	for(uint32_t kind = 0; kind < TEST_KINDS; kind++){
+		printf("%s: %u codes print differently from the float path\n", kind_name[kind], float_off[kind]);
+	}
+	SIM_CHECK(float_off[1] == sizeof(misrounded_f) / sizeof(misrounded_f[0]));
+	return sim_test_done("test_si7021_fixed");
+}
@@ -0,0 +1,250 @@
+/**
+ * @file test_sw_timer.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Deadline list test of the software timers on a fake counter
+ *
+ * The timers run on a SW_TIMER_PORT whose count the test sets, so no RTCC
+ * is involved. Random starts, restarts and stops of one-shot and periodic
+ * timers are mixed with steps of the counter to the armed compare, or past
+ * it as a late interrupt would. The counter starts just below the 32-bit
+ * wrap so every run crosses it.
+ *
+ * A reference list, nearest deadline first and the order started among
+ * equal ones, says which timer each callback must be. The test checks that
+ * no timer is due after an expiry, that the compare sits on the nearest
+ * deadline, or SW_TIMER_MIN_LEAD after it was armed when that deadline is
+ * closer, so every compare interrupt expires a timer, and that periodic
+ * deadlines step by their period from the previous deadline, skipping the
+ * ones missed by a late interrupt.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "sim_test.h"
+#include "sw_timer.h"
+#include "trace.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_HZ				32768
+#define TEST_TIMERS			16
+#define TEST_STEPS			400000
+#define TEST_START_COUNT	0xFFFF0000u		// wraps after 65536 ticks
+#define TEST_MAX_DELAY		5000
+#define TEST_MAX_PERIOD		3000
+#define TEST_EVENT			1				// scheduler event of timer 0
+
+typedef struct {
+	bool		active;
+	uint32_t	deadline;
+	uint32_t	period;
+	uint32_t	seq;				// start order among equal deadlines
+} TEST_MODEL;
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t			fake_count;
+static bool				armed;
+static uint32_t			armed_count;
+static uint32_t			armed_at;			// the count when the compare was armed
+static SW_TIMER_STRUCT	timers[TEST_TIMERS];
+static TEST_MODEL		model[TEST_TIMERS];
+static uint32_t			next_seq;
+static uint32_t			expiries;
+static uint32_t			restarts_in_callback;
+static uint32_t			event_calls;
+static uint32_t			events_expected;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static uint32_t fake_now(void){
+	return fake_count;
+}
+
+static void fake_arm(uint32_t count){
+	// programmed far enough ahead that the compare cannot be missed
+	SIM_CHECK((int32_t)(count - fake_count) >= SW_TIMER_MIN_LEAD);
+	armed = true;
+	armed_count = count;
+	armed_at = fake_count;
+}
+
+static void fake_disarm(void){
+	armed = false;
+}
+
+static const SW_TIMER_PORT fake_port = { TEST_HZ, fake_now, fake_arm, fake_disarm };
+
+static void model_start(uint32_t i, uint32_t delay, uint32_t period){
+	model[i].active = true;
+	model[i].deadline = fake_count + delay;
+	model[i].period = period;
+	model[i].seq = next_seq++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	The active timer of the reference that expires first, -1 if none
+ *
+ ******************************************************************************/
+static int32_t model_head(void){
+	int32_t head = -1;
+	for(uint32_t i = 0; i < TEST_TIMERS; i++){
+		if(!model[i].active) continue;
+		if(head < 0){
+			head = i;
+			continue;
+		}
+		int32_t diff = (int32_t)(model[i].deadline - model[head].deadline);
+		if((diff < 0) || ((diff == 0) && (model[i].seq < model[head].seq))) head = i;
+	}
+	return head;
+}
+
+static bool model_due(uint32_t i){
+	return model[i].active && ((int32_t)(model[i].deadline - fake_count) <= 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Timer callback, must be the due timer the reference expires first
+ *
+ ******************************************************************************/
+static void expired(void *ctx){
+	uint32_t i = (uint32_t)(uintptr_t)ctx;
+	int32_t head = model_head();
+	expiries++;
+	if(!SIM_CHECK((head == (int32_t)i) && model_due(i))) return;
+	if(model[i].period){
+		do {
+			model[i].deadline += model[i].period;
+		} while((int32_t)(model[i].deadline - fake_count) <= 0);
+		model[i].seq = next_seq++;
+	} else {
+		model[i].active = false;
+	}
+	SIM_CHECK(sw_timer_active(&timers[i]) == model[i].active);
+	if(i == 0) events_expected++;
+
+	// the callback may restart its own timer
+	if((sim_test_random() % 8) == 0){
+		uint32_t delay = 1 + sim_test_random() % TEST_MAX_DELAY;
+		sw_timer_start_ticks(&timers[i], delay, model[i].period);
+		model_start(i, delay, model[i].period);
+		restarts_in_callback++;
+	}
+}
+
+static void event_handler(void){
+	event_calls++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Checks the timers against the reference and the armed compare
+ *
+ ******************************************************************************/
+static void check_state(void){
+	for(uint32_t i = 0; i < TEST_TIMERS; i++){
+		SIM_CHECK(sw_timer_active(&timers[i]) == model[i].active);
+		if(model[i].active) SIM_CHECK(timers[i].deadline == model[i].deadline);
+	}
+	int32_t head = model_head();
+	if(head < 0){
+		SIM_CHECK(!armed);
+		return;
+	}
+	// an early compare costs a spurious interrupt, a late one a missed deadline
+	SIM_CHECK(armed);
+	uint32_t target = model[head].deadline;
+	if((int32_t)(target - armed_at) < SW_TIMER_MIN_LEAD) target = armed_at + SW_TIMER_MIN_LEAD;
+	if(!SIM_CHECK(armed_count == target)){
+		fprintf(stderr, "  compare %u, head %d due at %u\n", armed_count, head, model[head].deadline);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Moves the counter on, taking the compare interrupt when it is reached
+ *
+ ******************************************************************************/
+static void step_counter(void){
+	uint32_t late = (sim_test_random() % 4) ? 0 : sim_test_random() % (2 * TEST_MAX_PERIOD);
+	uint32_t to;
+	if(armed) to = armed_count + late;
+	else to = fake_count + 1 + sim_test_random() % TEST_MAX_DELAY;
+	if(armed && ((sim_test_random() % 4) == 0)){
+		// part of the way, no interrupt yet
+		uint32_t ahead = armed_count - fake_count;
+		if(ahead > 1) to = fake_count + sim_test_random() % ahead;
+	}
+	fake_count = to;
+	if(armed && ((int32_t)(fake_count - armed_count) >= 0)){
+		uint32_t before = expiries;
+		armed = false;			// the compare fired, RTCC_IRQHandler runs
+		sw_timer_expire();
+		SIM_CHECK(expiries > before);
+		for(uint32_t i = 0; i < TEST_TIMERS; i++) SIM_CHECK(!model_due(i));
+	}
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+	sim_test_start();
+	trace_open();		// with TRACE_ENABLED the dispatch reads the cycle counter
+	scheduler_open();
+	scheduler_register(TEST_EVENT, event_handler, 0);
+	fake_count = TEST_START_COUNT;
+	sw_timer_open(&fake_port);
+	SIM_CHECK(!armed);
+
+	// milliseconds round up to whole ticks
+	SIM_CHECK(sw_timer_ms_to_ticks(0) == 0);
+	SIM_CHECK(sw_timer_ms_to_ticks(1) == 33);
+	SIM_CHECK(sw_timer_ms_to_ticks(1000) == TEST_HZ);
+	SIM_CHECK(sw_timer_ms_to_ticks(60000) == 60 * TEST_HZ);
+
+	for(uint32_t i = 0; i < TEST_TIMERS; i++){
+		sw_timer_init(&timers[i], (i == 0) ? TEST_EVENT : SCHEDULER_NO_EVENT, expired, (void *)(uintptr_t)i);
+	}
+	uint32_t wraps = 0;
+	for(uint32_t step = 0; step < TEST_STEPS; step++){
+		uint32_t i = sim_test_random() % TEST_TIMERS;
+		uint32_t before = fake_count;
+		switch(sim_test_random() % 4){
+			case 0: {
+				uint32_t delay = sim_test_random() % TEST_MAX_DELAY;
+				uint32_t period = (sim_test_random() & 1) ? 1 + sim_test_random() % TEST_MAX_PERIOD : 0;
+				sw_timer_start_ticks(&timers[i], delay, period);
+				model_start(i, delay, period);
+				break;
+			}
+			case 1:
+				sw_timer_stop(&timers[i]);
+				model[i].active = false;
+				break;
+			default:
+				step_counter();
+				break;
+		}
+		if(fake_count < before) wraps++;
+		check_state();
+		if(get_scheduled_events()) scheduler_dispatch();
+	}
+	SIM_CHECK(wraps > 0);
+	SIM_CHECK(restarts_in_callback > 0);
+	SIM_CHECK(event_calls > 0);
+	SIM_CHECK(event_calls <= events_expected);
+	printf("%u expiries, %u counter wraps\n", expiries, wraps);
+	return sim_test_done("test_sw_timer");
+}
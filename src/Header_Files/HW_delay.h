@@ -8,9 +8,13 @@
 #ifndef SRC_HW_DELAY_H_
 #define SRC_HW_DELAY_H_
 
-#include "em_timer.h"
-#include "em_cmu.h"
+#include "em_core.h"
+#include "sleep_routines.h"
+#include "sw_timer.h"
+
+#define HW_DELAY_ASYNC_MAX	4	// asynchronous delays that can be pending at once
 
 void timer_delay(uint32_t ms_delay);
+void timer_delay_async(uint32_t ms_delay, uint32_t event, SW_TIMER_CALLBACK callback, void *ctx);
 
 #endif /* SRC_HW_DELAY_H_ */
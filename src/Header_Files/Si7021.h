@@ -15,6 +15,7 @@
 #include "i2c.h"
 #include "app.h"
 #include "brd_config.h"
+#include "event_queue.h"
 
 /* Silicon Labs include statements */
 
@@ -25,11 +26,32 @@
 #define		FREQ_I2C			I2C_FREQ_FAST_MAX //400kHz I2C Frequency
 #define		SLAVE_ADDR			0x40 //Si7021 default slave address
 #define		MEASURE_TEMP_NHOLD	0xF3 //Measure temperature with No Hold
+#define		MEASURE_TEMP_HOLD	0xE3 //Measure temperature with Hold Master (clock stretching)
+#define		MEASURE_RH_NHOLD	0xF5 //Measure relative humidity with No Hold
+#define		MEASURE_RH_HOLD		0xE5 //Measure relative humidity with Hold Master
+#define		READ_TEMP_PREV_RH	0xE0 //Read temperature measured during the last RH measurement
 
 #define     si7021_I2C          I2C0
 #define     READ_USER1_REG_CMD  0xE7
+#define     WRITE_USER1_REG_CMD 0xE6
 #define     USER1_RESET_REG     0b00111010 //expected user1 register upon reset of the si7021
 #define     RH10_TEMP13         0b10111010 //RH resolution 10-bit, temp resolution 13 bit 
+#define     USER1_RES(reg)      ((((reg) >> 6) & 0x2) | ((reg) & 0x1)) //RES1:RES0 resolution code
+
+// Acquisition strategies, see si7021_acquire_mode()
+#define     SI7021_NACK_POLL    0 //no hold, re-address the device until the conversion is done
+#define     SI7021_HOLD         1 //hold master, the device stretches SCL during the conversion
+#define     SI7021_TIMED        2 //no hold, sleep in EM2 for the conversion time then read once
+#define     SI7021_ACQUIRE      SI7021_TIMED
+
+// si7021_read_rh() sample payload
+#define     SI7021_RH_CODE(p)   ((p) >> 16)
+#define     SI7021_TEMP_CODE(p) ((p) & 0xFFFF)
+
+// Denominators of the unrounded conversions, tempNumC_si7021() / SI7021_TEMP_C_DEN is deg C
+#define     SI7021_TEMP_C_DEN   1638400
+#define     SI7021_TEMP_F_DEN   8192000
+#define     SI7021_RH_DEN       65536
 
 
 //***********************************************************************************
@@ -43,7 +65,16 @@
 
 void si7021_i2c_open();
 void si7021_read(uint32_t SI7021_READ_CB);
-float tempConvert_si7021();
-void si7021_TDD_config(void)
+void si7021_read_rh(uint32_t SI7021_READ_CB);
+bool si7021_get_event(EVENT_MSG_STRUCT *msg);
+int32_t tempCentiC_si7021(uint32_t reading);
+int32_t tempCentiF_si7021(uint32_t reading);
+int32_t rhCenti_si7021(uint32_t reading);
+int64_t tempNumC_si7021(uint32_t reading);
+int64_t tempNumF_si7021(uint32_t reading);
+int64_t rhNum_si7021(uint32_t reading);
+void si7021_TDD_config(void);
+void si7021_acquire_mode(uint32_t mode);
+uint32_t si7021_nack_retries(void);
 
 #endif /* SRC_HEADER_FILES_SI7021_H_ */
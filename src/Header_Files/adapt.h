@@ -0,0 +1,47 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	ADAPT_HG
+#define	ADAPT_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+	uint32_t	min_ms;			// shortest sample period, used while the value changes fast
+	uint32_t	max_ms;			// ceiling the period stretches to while the value is stable
+	int32_t		noise;			// a change of at most this much between samples is stable
+	int32_t		fast_rate;		// change per minute above which the period is halved
+	uint32_t	stable_count;	// stable samples in a row before the period is doubled
+} ADAPT_CONFIG_STRUCT;
+
+typedef struct {
+	ADAPT_CONFIG_STRUCT	config;
+	uint32_t			period_ms;		// current sample period
+	int32_t				last_value;		// previous sample
+	bool				have_last;		// last_value is valid
+	uint32_t			stable;			// stable samples in a row
+} ADAPT_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void adapt_init(ADAPT_STRUCT *adapt, const ADAPT_CONFIG_STRUCT *config);
+uint32_t adapt_update(ADAPT_STRUCT *adapt, int32_t value);
+
+#endif
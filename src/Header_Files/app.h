@@ -17,26 +17,94 @@
 #include "letimer.h"
 #include "brd_config.h"
 #include "scheduler.h"
+#include "rtcc.h"
 #include "Si7021.h"
 #include "ble.h"
-#include "HW_Delay.h"
-#include <stdio.h>
+#include "HW_delay.h"
+#include "fmt.h"
+#include "batch.h"
+#include "report.h"
+#include "adapt.h"
+#include "trace.h"
+#include "irq.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+// Settings inside #ifndef may be overridden by the build, see sim/bench
+#ifndef PWM_PER
 #define		PWM_PER				2.7		// PWM period in seconds
+#endif
 #define		PWM_ACT_PER			0.15	// PWM active period in seconds
-#define 	LETIMER0_COMP0_CB	0x1		// 0b1 - COMP0 callback
-#define 	LETIMER0_COMP1_CB	0x2		// 0b10 - COMP1 callback
-#define 	LETIMER0_UF_CB		0x4		// 0b100 - Underflow callback
-#define		I2C_7021_READ_CB	0x8		// 0b1000 - Callback upon completion of i2c read SM
-#define		BOOT_UP_CB			0x10	// 0b10000 - Bootup callback
-#define		BLE_TX_DONE_CB		0x20	// 0b100000 - BLE TX Done callback
-#define     I2C_7021_WRITE_CB   0x40    // 0b1000000 - Callback upong completion of i2c write SM
+// Scheduler event ids, 0 is SCHEDULER_NO_EVENT
+#define 	LETIMER0_COMP0_CB	1		// COMP0 callback
+#define 	LETIMER0_COMP1_CB	2		// COMP1 callback
+#define 	LETIMER0_UF_CB		3		// Underflow callback
+#define		I2C_7021_READ_CB	4		// Callback upon completion of i2c read SM
+#define		BOOT_UP_CB			5		// Bootup callback
+#define		BLE_TX_DONE_CB		6		// BLE TX Done callback
+#define     I2C_7021_WRITE_CB   7		// Callback upong completion of i2c write SM
+#define		BATCH_FLUSH_CB		8		// Sample batch latency expired
+#define		BLE_RX_CB			9		// Line received from the HM-10
+#define		BLE_CONFIG_CB		10		// HM-10 configuration applied or failed
+
+// Scheduler priorities, 0 is dispatched first
+#define		BLE_TX_DONE_PRI		0		// keep the LEUART busy while data is queued
+#define		I2C_7021_READ_PRI	1
+#define		LETIMER0_UF_PRI		2
+#define		LETIMER0_COMP0_PRI	3
+#define		LETIMER0_COMP1_PRI	4
+#define		BOOT_UP_PRI			5
+#define		BATCH_FLUSH_PRI		6
+#define		BLE_RX_PRI			7
+#define		BLE_CONFIG_PRI		8
 
 #define 	SYSTEM_BLOCK_EM 	EM3
+#define		SLEEP_STATS_PERIODS	10		// LETIMER0 periods between residency reports
+#define		TRACE_PERIODS		10		// LETIMER0 periods between trace dumps
+#define		TEMP_ALARM_CENTI_F	8000	// LED1 on above 80.00 F
+#define		TEMP_CLEAR_CENTI_F	7950	// and off again at 79.50 F
+#define		REPORT_TEMP_BAND	20		// centi F change worth reporting
+#define		REPORT_RH_BAND		100		// centi %RH change worth reporting
+#define		REPORT_MIN_MS		10000	// shortest time between reported changes
+#define		REPORT_MAX_MS		600000	// heartbeat, report unchanged readings this often
+#ifndef ADAPT_MAX_MS
+#define		ADAPT_MAX_MS		60000	// longest sample period, below LETIMER_MAX_CNT
+#endif
+#define		ADAPT_NOISE			10		// centi F change between samples that counts as stable
+#define		ADAPT_FAST_RATE		100		// centi F per minute that shortens the period
+#define		ADAPT_STABLE		5		// stable samples before the period is doubled
+#define		SENSOR_SI7021_RHT	1		// binary frame sensor id, values: centi F, centi %RH
+#ifndef BATCH_SAMPLES
+#define		BATCH_SAMPLES		8		// samples sent per BLE burst
+#endif
+#ifndef BATCH_LATENCY_MS
+#define		BATCH_LATENCY_MS	60000	// longest a sample waits for its burst
+#endif
+#define		BATCH_TEMP_STEP		100		// centi F change sent at once
+#define		BATCH_RH_STEP		300		// centi %RH change sent at once
+#define		BLE_NAME			"PESKIN_UART"	// advertised name, BLE_NAME_MAX characters
+#define		BLE_ADV_INTERVAL	5		// AT+ADVI code, 546.25 ms
+#define		BLE_TX_POWER		2		// AT+POWE code, 0 dBm
+#define		BLE_CONFIG_RETRIES	2		// runs of the HM-10 configuration after the first fails
+#define		SAMPLE_LINE_MAX		(7 + FMT_TENTHS_MAX_LEN + 8 + FMT_TENTHS_MAX_LEN + 3)	// "Temp = " t " F\nRH = " rh " %\n"
+// Bytes of a full sample batch and most batches an hour, see ble_baud_choose()
+// Report-on-change adds a sample to the batch once per REPORT_MIN_MS at most
+#define		BATCH_BURSTS_PER_HOUR	(3600000 / REPORT_MIN_MS / BATCH_SAMPLES)
+#if BLE_FRAMING == BLE_FRAME_BINARY
+#define		BATCH_BURST_BYTES	(BLE_FRAME_HDR + BATCH_SAMPLES * (3 + 2 * BATCH_MAX_VALUES) + BLE_FRAME_CRC)
+#else
+#define		BATCH_BURST_BYTES	(BATCH_SAMPLES * SAMPLE_LINE_MAX)
+#endif
+// Text samples formatted into one reservation, a frame must fit the BLE circular buffer
+#define		BATCH_TEXT_SAMPLES	((BLE_CIRC_SIZE - RING_HDR_SIZE) / SAMPLE_LINE_MAX)
+#if (BATCH_SAMPLES < 1) || (BATCH_SAMPLES > BATCH_MAX_SAMPLES)
+#error "BATCH_SAMPLES must be 1 to BATCH_MAX_SAMPLES"
+#endif
+#if BATCH_TEXT_SAMPLES < 1
+#error "BLE_CIRC_SIZE does not hold a text sample"
+#endif
 
 
 //***********************************************************************************
@@ -55,4 +123,7 @@ void scheduled_si7021_tempDone();
 void scheduled_boot_up_cb(void);
 void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route);
 void ble_tx_done_cb(void);
+void scheduled_batch_flush_cb(void);
+void scheduled_ble_rx_cb(void);
+void scheduled_ble_config_cb(void);
 #endif
@@ -0,0 +1,60 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	BATCH_HG
+#define	BATCH_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "sw_timer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BATCH_MAX_SAMPLES	16			// samples a batch can hold
+#define BATCH_MAX_VALUES	2			// fixed-point values per sample
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+	uint32_t		timestamp;					// RTCC count of the sample
+	int16_t			value[BATCH_MAX_VALUES];	// fixed-point values
+	uint32_t		raw;						// reading the values were converted from, for exact text
+} BATCH_SAMPLE_STRUCT;
+
+/* Sends count samples, oldest first, in one transmit */
+typedef void (*BATCH_FLUSH)(const BATCH_SAMPLE_STRUCT *samples, uint32_t count);
+
+typedef struct {
+	uint32_t		count;						// flush once this many samples are held
+	uint32_t		latency_ms;					// flush once the oldest sample is this old, 0 for no limit
+	int16_t			threshold[BATCH_MAX_VALUES];// flush at once when a value moves this far from the last one sent, 0 to ignore
+	uint32_t		flush_event;				// scheduler event of the latency timer, its handler calls batch_timeout()
+	BATCH_FLUSH		flush;
+} BATCH_CONFIG_STRUCT;
+
+typedef struct {
+	BATCH_CONFIG_STRUCT	config;
+	BATCH_SAMPLE_STRUCT	sample[BATCH_MAX_SAMPLES];
+	uint32_t			held;					// samples waiting to be sent
+	BATCH_SAMPLE_STRUCT	last_sent;				// reference of the change threshold
+	bool				sent_any;				// last_sent is valid
+	SW_TIMER_STRUCT		latency_timer;
+} BATCH_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void batch_open(BATCH_STRUCT *batch, const BATCH_CONFIG_STRUCT *config);
+void batch_add(BATCH_STRUCT *batch, uint32_t timestamp, const int16_t *values, uint32_t raw);
+void batch_timeout(BATCH_STRUCT *batch);
+void batch_flush(BATCH_STRUCT *batch);
+
+#endif
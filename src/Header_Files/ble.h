@@ -15,22 +15,32 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+// Silicon Labs include files
+#include "em_gpcrc.h"
+
 // Driver functions
 #include "leuart.h"
 #include "gpio.h"
+#include "ring_buffer.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
 
+// HM10_BAUDRATE, HM10_TX_DMA and BLE_FRAMING can be set by the build
 #define HM10_LEUART0		LEUART0
-#define HM10_BAUDRATE		9600
+#ifndef HM10_BAUDRATE
+#define HM10_BAUDRATE		9600	// at ble_open(), ble_config() can negotiate another
+#endif
 #define	HM10_DATABITS		leuartDatabits8
 #define HM10_ENABLE			leuartEnable
 #define HM10_PARITY			leuartNoParity
 #define HM10_REFFREQ		0  // use reference clock
 #define HM10_STOPBITS		leuartStopbits1
+#ifndef HM10_TX_DMA
+#define HM10_TX_DMA			true	// transmit through the LDMA, one wakeup per packet
+#endif
 
 #define LEUART0_TX_ROUTE	LEUART_ROUTELOC0_TXLOC_LOC18
 #define LEUART0_RX_ROUTE	LEUART_ROUTELOC0_RXLOC_LOC18
@@ -38,23 +48,84 @@
 // Lab 6:
 #define	CIRC_TEST			true
 #define	CIRC_OPER			false
+#define BLE_CIRC_SIZE		512				// circular buffer bytes, power of two, holds a text batch
+#define BLE_CIRC_POLICY		RING_BLOCK		// wait for the LEUART when full
+
+// Receive path, see ble_rx_byte()
+#define BLE_RX_LINE_MAX		32				// longest AT response or command line
+#define BLE_RX_RING_SIZE	128				// received lines waiting for the main loop, power of two
+#define BLE_RX_GAP_MS		10				// silence that ends an AT response, they have no line ending
+
+// AT command engine, see ble_at_run()
+#define BLE_AT_QUEUE_SIZE	8				// commands per run
+#define BLE_NAME_MAX		12				// longest name the HM-10 advertises
+#define BLE_AT_CMD_MAX		(7 + BLE_NAME_MAX)	// "AT+NAME<name>", also the longest expected response
+#define BLE_AT_GAP_MS		20				// silence before a command, the HM-10 ends commands on a gap
+#define BLE_AT_TIMEOUT_MS	300				// from the start of a command to its response
+#define BLE_AT_BOOT_MS		1000			// the HM-10 ignores the LEUART after AT+RESET
+#define BLE_CONFIG_KEEP		0xFF			// BLE_CONFIG_STRUCT setting left as it is
+
+// Baud rate negotiation, see ble_baud_choose()
+#define BLE_BAUD_ERROR_PCT	2				// LEUART rate error the HM-10 tolerates
+#define BLE_BAUD_PAYBACK_H	1				// hours a rate change must pay for itself in
+#define BLE_BAUD_SWITCH_NC	1400			// MCU charge of AT+BAUD, AT+RESET and the check, sim bench
+#define BLE_BAUD_LINE_NA	150				// LEUART current while a frame is on the line
+
+// Sample framing, see ble_frame_add()
+#define BLE_FRAME_ASCII		0				// one text line per sample
+#define BLE_FRAME_BINARY	1				// samples packed into CRC protected frames
+#ifndef BLE_FRAMING
+#define BLE_FRAMING			BLE_FRAME_ASCII
+#endif
+
+// Binary frame: SYNC SEQ LEN TIME[4] records[LEN] CRC[2], little endian
+// record: (sensor << 4 | count) DT[2] count x int16 value
+#define BLE_FRAME_SYNC		0xA5
+#define BLE_FRAME_HDR		7				// SYNC, SEQ, LEN, TIME
+#define BLE_FRAME_CRC		2				// CRC-16/MCRF4XX (poly 0x1021, reflected, init 0xFFFF) from the GPCRC
+#define BLE_FRAME_SIZE		96				// largest frame in bytes
+#define BLE_FRAME_DT_SHIFT	10				// record DT in RTCC ticks >> 10, 1/32 s
+#define BLE_FRAME_MAX_VALUES	15
+#define BLE_FRAME_MAX_SENSOR	15
 
 
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+typedef enum {
+	BLE_AT_IDLE,			// nothing run yet
+	BLE_AT_BUSY,
+	BLE_AT_DONE,			// every command was answered
+	BLE_AT_FAILED			// a command was not answered in time, the rest were dropped
+} BLE_AT_STATUS;
 
+typedef struct {
+	const char	*name;				// advertised name, NULL to keep it
+	uint8_t		adv_interval;		// AT+ADVI code, 0 (100 ms) to 15 (7 s)
+	uint8_t		tx_power;			// AT+POWE code, 0 (-23 dBm) to 3 (6 dBm)
+	uint32_t	baud;				// HM-10 and LEUART rate, 0 to keep it
+} BLE_CONFIG_STRUCT;
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
 void ble_open(uint32_t tx_event, uint32_t rx_event);
 void ble_write(char *string);
+uint32_t ble_rx_read(char *line, uint32_t max);
 
-bool ble_test(char *mod_name);
+bool ble_at_queue(const char *cmd, const char *arg, const char *reply);
+bool ble_at_run(uint32_t done_event);
+BLE_AT_STATUS ble_at_status(uint32_t *failed);
+bool ble_config(const BLE_CONFIG_STRUCT *config, uint32_t done_event);
+uint32_t ble_baud_choose(uint32_t burst_bytes, uint32_t bursts_per_hour);
 
 void circular_buff_test(void);
 bool ble_circ_pop(bool test);
+uint32_t ble_circ_space(void);
+char *ble_reserve(uint32_t length);
+void ble_commit(uint32_t length);
+void ble_frame_add(uint32_t sensor, uint32_t timestamp, const int16_t *values, uint32_t count);
+bool ble_frame_flush(void);
 
 #endif
@@ -0,0 +1,46 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	EVENT_QUEUE_HG
+#define	EVENT_QUEUE_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_core.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+#include "rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EVENT_QUEUE_SIZE	8		// records per queue, power of two
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+	uint32_t			event;		// scheduler event id raised by the post
+	uint32_t			timestamp;	// rtcc_get_count() when posted
+	uint32_t			payload;	// producer specific data
+} EVENT_MSG_STRUCT;
+
+typedef struct {
+	EVENT_MSG_STRUCT	msg[EVENT_QUEUE_SIZE];
+	volatile uint32_t	head;		// free running, only written by the producer
+	volatile uint32_t	tail;		// free running, only written by the consumer
+	uint32_t			overflow;	// records lost because the queue was full
+} EVENT_QUEUE_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void event_queue_init(EVENT_QUEUE_STRUCT *queue);
+bool event_queue_post(EVENT_QUEUE_STRUCT *queue, uint32_t event, uint32_t payload);
+bool event_queue_get(EVENT_QUEUE_STRUCT *queue, EVENT_MSG_STRUCT *msg);
+
+#endif
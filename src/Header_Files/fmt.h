@@ -0,0 +1,34 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	FMT_HG
+#define	FMT_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define FMT_UINT_MAX_LEN	10		// digits of 4294967295
+#define FMT_TENTHS_MAX_LEN	(1 + FMT_UINT_MAX_LEN + 2)	// sign, integer part, ".d"
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+uint32_t fmt_str(char *dst, const char *str);
+uint32_t fmt_uint(char *dst, uint32_t value);
+uint32_t fmt_tenths(char *dst, int64_t num, uint32_t den);
+
+#endif
@@ -22,6 +22,7 @@
 #include "app.h"
 
 /* The developer's include statements */
+#include "event_queue.h"
 
 
 
@@ -29,6 +30,18 @@
 // defined files
 //***********************************************************************************
 #define 	I2C_EM_BLOCK		EM2  //first mode it cannot enter while in i2c
+#define		I2C_BUS_COUNT		2	 //I2C0 and I2C1
+
+// I2C_XFER_STRUCT flags
+#define		I2C_XFER_RETRY_NACK	0x01 //re-address the read phase until the slave ACKs (Si7021 no hold)
+#define		I2C_XFER_NACK_MAX	1000 //default nack_max, 25 ms of retries at 400kHz, past the longest Si7021 conversion
+
+// I2C_XFER_STRUCT status
+#define		I2C_XFER_IDLE		0	 //never submitted
+#define		I2C_XFER_QUEUED		1	 //waiting for the bus
+#define		I2C_XFER_BUSY		2	 //on the bus
+#define		I2C_XFER_DONE		3	 //completed
+#define		I2C_XFER_NACK		4	 //slave did not acknowledge, bus released
 
 //***********************************************************************************
 // global variables
@@ -46,36 +59,49 @@ typedef struct {
 	bool					scl_pin_en;		//enable scl route
 } I2C_OPEN_STRUCT ;
 
-typedef struct {
-	I2C_TypeDef 	*i2c; 			//i2c peripheral being used
-	uint32_t		current_state; 	//current state of state machine
-	uint32_t		device_addr; 	//address of slave device being used
-	uint32_t		command;		//command to be sent to slave device
-	uint32_t		*i2c_reg;		//i2c register address being requested
-	bool			readWrite;		//true: read, false: write
-	uint32_t		*readData;		//pointer of where to store a read result or get write data
-	uint32_t		numBytes;		//number of bytes to transfer
-	uint32_t		bytesDone;		//number of bytes sent/receieved so far
-	bool			SMbusy;			//make sure the state machine doesn't restart when busy
-	uint32_t		callback;		//the callback event at completion
-} I2C_STATE_MACHINE_STRUCT;
+struct I2C_XFER_STRUCT;
+typedef void (*I2C_CALLBACK)(struct I2C_XFER_STRUCT *xfer, void *ctx);
+
+/*
+ * One transaction on the bus, owned by the caller until it completes.
+ * tx_len bytes are written, then rx_len bytes are read after a repeated
+ * START; either phase may be empty. The transaction ends with a STOP.
+ */
+typedef struct I2C_XFER_STRUCT {
+	struct I2C_XFER_STRUCT	*next;			//bus queue link
+	uint32_t				addr;			//7 bit slave address
+	const uint8_t			*tx;			//bytes written first
+	uint32_t				tx_len;			//0 for a read only transfer
+	uint8_t					*rx;			//bytes read after the write phase
+	uint32_t				rx_len;			//0 for a write only transfer
+	uint32_t				flags;			//I2C_XFER_x flags
+	uint32_t				event;			//posted to the bus event queue on completion, may be SCHEDULER_NO_EVENT
+	I2C_CALLBACK			callback;		//called from the MSTOP interrupt, may be NULL
+	void					*ctx;			//passed to the callback
+	uint32_t				nacks;			//read address NACKs retried
+	uint32_t				nack_max;		//retries before the transfer completes with I2C_XFER_NACK
+	volatile uint32_t		status;			//I2C_XFER_x status
+} I2C_XFER_STRUCT;
 
 //STATES FOR State Machine
 typedef enum {
-	INIT_SEND_ADDR_R,
-	SEND_CMD_R,
-	QUERY_READY,
-	READ_DATA,
-	STOP_END
-} READ_STATES;
+	I2C_IDLE,
+	I2C_ADDR_W,		//address + write sent
+	I2C_TX,			//write data byte sent
+	I2C_ADDR_R,		//(repeated) START, address + read sent
+	I2C_RX,			//receiving data
+	I2C_STOP		//STOP sent, waiting for MSTOP
+} I2C_STATES;
 
-typedef enum{
-	INIT_SEND_ADDR_W,
-	SEND_CMD_W,
-	SEND_DATA,
-	WAIT_COMPLETE,
-	STOP_END
-} WRITE_STATES;
+typedef struct {
+	I2C_TypeDef 		*i2c; 			//i2c peripheral being used
+	I2C_XFER_STRUCT		*head;			//transfer on the bus, NULL when idle
+	I2C_XFER_STRUCT		*tail;			//last queued transfer
+	I2C_STATES			current_state; 	//current state of state machine
+	uint32_t			bytesDone;		//bytes of the current phase sent/received so far
+	bool				nacked;			//the head transfer was NACKed, it completes at MSTOP
+	EVENT_QUEUE_STRUCT	events;			//completed transfers
+} I2C_STATE_MACHINE_STRUCT;
 
 
 
@@ -86,7 +112,12 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup);
 void i2c_bus_reset(I2C_TypeDef *i2c);
 void I2C0_IRQHandler(void);
 void I2C1_IRQHandler(void);
-void i2c_start(I2C_TypeDef *i2c, uint32_t slaveAddr, uint32_t *data, uint32_t numBytes, uint32_t command, bool readWrite, uint32_t	scheduled_SO7021_READ_CB);
+void i2c_xfer_init(I2C_XFER_STRUCT *xfer, uint32_t addr, const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len);
+void i2c_submit(I2C_TypeDef *i2c, I2C_XFER_STRUCT *xfer);
+bool i2c_xfer_pending(I2C_XFER_STRUCT *xfer);
+void i2c_wait(I2C_XFER_STRUCT *xfer);
+bool i2c_sm_busy(I2C_TypeDef *i2c);
+bool i2c_get_event(I2C_TypeDef *i2c, EVENT_MSG_STRUCT *msg);
 
 
 #endif /* SRC_HEADER_FILES_I2C_H_ */
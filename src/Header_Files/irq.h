@@ -0,0 +1,54 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	IRQ_HG
+#define	IRQ_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+// Priority plan, 2 preemption bits and 1 sub-priority bit of the 3 implemented.
+// A lower level preempts a higher one, the sub-priority only orders pending
+// interrupts of the same level.
+#define IRQ_GROUP_BITS		2
+#define IRQ_PRIGROUP		(7 - IRQ_GROUP_BITS)	// PRIGROUP of AIRCR, bits [5:0] are sub-priority
+#define IRQ_LEVELS			(1 << IRQ_GROUP_BITS)
+
+#define IRQ_LEVEL_LEUART	1		// RX bytes are lost on overrun, nothing may hold it off
+#define IRQ_LEVEL_I2C		2		// one interrupt per byte, a late one stretches SCL
+#define IRQ_LEVEL_LDMA		2
+#define IRQ_LEVEL_TICK		3		// LETIMER and RTCC, post scheduler events only
+
+#define IRQ_MASK_BASEPRI(level)	((uint32_t)(level) << (8 - IRQ_GROUP_BITS))
+
+// BASEPRI critical section, masks the interrupts of the level and below and
+// lets the higher levels run. Nests, an inner section never lowers the mask.
+#define IRQ_DECLARE_MASK_STATE	uint32_t irq_mask_state
+#define IRQ_MASK_ENTER(level)	irq_mask_state = irq_mask_enter(level)
+#define IRQ_MASK_EXIT()			irq_mask_exit(irq_mask_state)
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void irq_open(void);
+uint32_t irq_priority(IRQn_Type irq);
+void irq_priority_set(IRQn_Type irq);
+uint32_t irq_mask_enter(uint32_t level);
+void irq_mask_exit(uint32_t state);
+
+#endif
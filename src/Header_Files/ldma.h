@@ -0,0 +1,45 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	LDMA_HG
+#define	LDMA_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_ldma.h"
+#include "em_leuart.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LDMA_LEUART0_TX_CH		0		// LDMA channel reserved for LEUART0 TX
+#define LDMA_LEUART1_TX_CH		1		// and for LEUART1 TX, on parts that have one
+#define LDMA_MAX_XFER			2048	// Max number of units in a single descriptor
+#define LDMA_SPAN_MAX			4		// segments of one transfer, linked descriptors per channel
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+	const void	*src;					// first byte of the segment
+	uint32_t	len;					// bytes, 1 to LDMA_MAX_XFER
+} LDMA_SPAN_STRUCT;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void ldma_open(void);
+void ldma_leuart_tx_start(uint32_t ch, LEUART_TypeDef *leuart, const LDMA_SPAN_STRUCT *spans, uint32_t count);
+bool ldma_channel_done(uint32_t ch);
+void ldma_channel_stop(uint32_t ch);
+void LDMA_IRQHandler(void);
+
+#endif
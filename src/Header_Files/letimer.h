@@ -23,6 +23,7 @@
 //***********************************************************************************
 #define LETIMER_HZ		1000			// Utilizing ULFRCO oscillator for LETIMERs
 #define LETIMER_EM		EM4				// Using the ULFRCO, block from entering EM4
+#define LETIMER_MAX_CNT	0xFFFF			// 16 bit counter, longest period is 65.535 s
 
 //***********************************************************************************
 // global variables
@@ -44,12 +45,23 @@ typedef struct {
 	uint32_t		uf_cb;				// underflow interrupt callback
 } APP_LETIMER_PWM_TypeDef ;
 
+// Events the interrupts of one LETIMER instance post
+typedef struct {
+	uint32_t		comp0_cb;
+	uint32_t		comp1_cb;
+	uint32_t		uf_cb;
+} LETIMER_HANDLE_STRUCT;
+
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
 void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct);
 void letimer_start(LETIMER_TypeDef *letimer, bool enable);
+void letimer_set_period(LETIMER_TypeDef *letimer, float period, float active_period);
 void LETIMER0_IRQHandler(void);
+#if LETIMER_COUNT > 1
+void LETIMER1_IRQHandler(void);
+#endif
 
 #endif
@@ -6,6 +6,7 @@
 
 #include "em_leuart.h"
 #include "sleep_routines.h"
+#include "ldma.h"
 #include "ble.h"
 
 
@@ -15,12 +16,20 @@
 
 #define LEUART_TX_EM		EM3
 #define LEUART_RX_EM		EM3
+#define LEUART_SPAN_MAX		LDMA_SPAN_MAX	// segments of one transmission
 
 /***************************************************************************//**
  * @addtogroup leuart
  * @{
  ******************************************************************************/
 
+// A segment of a transmission, the LDMA and the TXBL interrupt walk the same ones
+typedef LDMA_SPAN_STRUCT LEUART_SPAN_STRUCT;
+
+// Called from the LEUART interrupt with every byte received, returns true
+// when the byte completed a frame and rx_done_evt is to be posted
+typedef bool (*LEUART_RX_CALLBACK)(uint8_t data, void *ctx);
+
 typedef struct {
 	uint32_t					baudrate;
 	LEUART_Databits_TypeDef		databits;
@@ -42,17 +51,37 @@ typedef struct {
 	uint32_t					rx_done_evt;
 	uint32_t					tx_done_evt;
 	uint32_t					refFreq;
+	bool						tx_dma_en;		// stream TX through the LDMA instead of TXBL interrupts
+	LEUART_RX_CALLBACK			rx_callback;	// NULL leaves RX to the polling functions
+	void						*rx_ctx;
 } LEUART_OPEN_STRUCT;
 
 typedef struct {
 	LEUART_TypeDef				*leuart; 		// leuart peripheral being usued
 	volatile bool				SMbusy; 		// asserted- SM is busy
-	uint32_t					length; 		// length of string to transfer
-	uint32_t					count;  		// current count of data being transferred
+	bool						dma;			// TX is moved by the LDMA, only TXC is serviced
+	uint32_t					ldma_ch;		// LDMA channel of the instance
+	uint32_t					tx_done_evt;
+	LEUART_SPAN_STRUCT			span[LEUART_SPAN_MAX];	// data being sent, owned by the caller until TX done
+	uint32_t					spans;			// segments in span[]
+	uint32_t					index;			// segment being transferred
+	uint32_t					count;  		// bytes of it transferred
 	uint32_t					current_state; 	// current state of SM
-	char					    output[30];		// local copy of string to be sent
 } LEUART_SM_STRUCT;
 
+typedef struct {
+	LEUART_RX_CALLBACK			callback;		// fed from the RXDATAV interrupt
+	void						*ctx;
+	uint32_t					rx_done_evt;
+	uint32_t					overruns;		// bytes lost to a full RX FIFO
+} LEUART_RX_STRUCT;
+
+// Everything the driver keeps for one LEUART instance
+typedef struct {
+	LEUART_SM_STRUCT			tx;
+	LEUART_RX_STRUCT			rx;
+} LEUART_HANDLE_STRUCT;
+
 typedef enum {
 	INIT_UART,
 	SEND_DATA,
@@ -71,8 +100,15 @@ typedef enum {
 //***********************************************************************************
 void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings);
 void LEUART0_IRQHandler(void);
+#if LEUART_COUNT > 1
+void LEUART1_IRQHandler(void);
+#endif
 void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
+void leuart_start_spans(LEUART_TypeDef *leuart, const LEUART_SPAN_STRUCT *spans, uint32_t count);
 bool leuart_tx_busy(LEUART_TypeDef *leuart);
+uint32_t leuart_rx_overruns(LEUART_TypeDef *leuart);
+void leuart_baud_set(LEUART_TypeDef *leuart, uint32_t baudrate);
+uint32_t leuart_baud_reachable(LEUART_TypeDef *leuart, uint32_t baudrate);
 
 uint32_t leuart_status(LEUART_TypeDef *leuart);
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update);
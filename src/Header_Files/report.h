@@ -0,0 +1,53 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	REPORT_HG
+#define	REPORT_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+// report_check() result
+#define REPORT_SEND			0x01		// the value should be reported
+#define REPORT_ALARM_EDGE	0x02		// the alarm state changed, see report_alarm()
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+/* Times are in the caller's timestamp units, RTCC ticks in the application */
+typedef struct {
+	int32_t		deadband;		// report once the value moves more than this from the last report
+	uint32_t	min_interval;	// no change is reported sooner than this after the last report
+	uint32_t	max_interval;	// heartbeat, report even if unchanged, 0 for none
+	bool		alarm_en;		// alarm_on/alarm_off are used
+	int32_t		alarm_on;		// the alarm asserts above this value
+	int32_t		alarm_off;		// and clears again at or below this one, alarm_off <= alarm_on
+} REPORT_CONFIG_STRUCT;
+
+typedef struct {
+	REPORT_CONFIG_STRUCT	config;
+	int32_t					last_value;		// last value reported
+	uint32_t				last_time;		// when it was reported
+	bool					reported;		// last_value and last_time are valid
+	bool					alarm;			// alarm state
+} REPORT_CHANNEL_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void report_init(REPORT_CHANNEL_STRUCT *channel, const REPORT_CONFIG_STRUCT *config);
+uint32_t report_check(REPORT_CHANNEL_STRUCT *channel, uint32_t now, int32_t value);
+void report_sent(REPORT_CHANNEL_STRUCT *channel, uint32_t now, int32_t value);
+bool report_alarm(REPORT_CHANNEL_STRUCT *channel);
+
+#endif
@@ -0,0 +1,74 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	RING_BUFFER_HG
+#define	RING_BUFFER_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+#include "em_core.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RING_HDR_SIZE		2			// 16-bit little endian frame length
+#define RING_ALIGN			2			// frames start on a header aligned index
+#define RING_WRAP_MARK		0xFFFF		// header value: skip to the start of the buffer
+#define RING_MAX_FRAME		0xFFFE		// largest length a header can describe
+
+/***************************************************************************//**
+ * @addtogroup ring_buffer
+ * @{
+ ******************************************************************************/
+
+typedef enum {
+	RING_DROP_NEWEST,		// refuse the new frame when full
+	RING_DROP_OLDEST,		// discard queued frames to make room
+	RING_BLOCK				// call block_wait() until the consumer makes room
+} RING_POLICY;
+
+typedef struct {
+	uint8_t				*buf;			// storage, size bytes
+	uint32_t			size;			// capacity, must be a power of two
+	uint32_t			size_mask;		// size - 1
+	volatile uint32_t	write_idx;		// free running, only advanced by the producer
+	volatile uint32_t	read_idx;		// free running, only advanced by the consumer
+	uint32_t			reserve_idx;	// header index of the outstanding reservation
+	uint32_t			reserve_len;	// payload bytes reserved
+	volatile bool		peeked;			// oldest frames handed out and not yet released
+	uint32_t			peek_end;		// index past the last frame handed out
+	RING_POLICY			policy;			// full buffer policy
+	void				(*block_wait)(void);	// makes progress on the consumer side
+	uint32_t			dropped;		// frames lost to the full buffer policy
+} RING_BUF_STRUCT;
+
+/** @} (end addtogroup ring_buffer) */
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void ring_buf_init(RING_BUF_STRUCT *ring, uint8_t *storage, uint32_t size, RING_POLICY policy, void (*block_wait)(void));
+uint8_t *ring_buf_reserve(RING_BUF_STRUCT *ring, uint32_t len);
+void ring_buf_commit(RING_BUF_STRUCT *ring, uint32_t len);
+bool ring_buf_push(RING_BUF_STRUCT *ring, const void *data, uint32_t len);
+uint8_t *ring_buf_peek(RING_BUF_STRUCT *ring, uint32_t *len);
+uint32_t ring_buf_peek_frames(RING_BUF_STRUCT *ring, uint8_t **frames, uint32_t *lens, uint32_t max);
+void ring_buf_release(RING_BUF_STRUCT *ring);
+uint32_t ring_buf_pop(RING_BUF_STRUCT *ring, void *dst, uint32_t max_len);
+uint32_t ring_buf_space(RING_BUF_STRUCT *ring);
+uint32_t ring_buf_frame_size(uint32_t len);
+bool ring_buf_empty(RING_BUF_STRUCT *ring);
+
+#endif
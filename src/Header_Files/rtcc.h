@@ -0,0 +1,43 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	RTCC_HG
+#define	RTCC_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_rtcc.h"
+#include "em_cmu.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "sleep_routines.h"
+#include "sw_timer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RTCC_HZ				32768			// RTCC clocked from the LFXO on LFE, no prescaler
+#define RTCC_EM				EM3				// the LFXO stops in EM3
+#define RTCC_TIMER_CH		1				// compare channel used by the software timers
+#define RTCC_MS_TO_TICKS(ms)	((uint32_t)(((uint64_t)(ms) * RTCC_HZ) / 1000))
+#define RTCC_TICKS_TO_MS(t)		((uint32_t)(((uint64_t)(t) * 1000) / RTCC_HZ))
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+extern const SW_TIMER_PORT rtcc_timer_port;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void rtcc_open(void);
+uint32_t rtcc_get_count(void);
+void rtcc_compare_set(uint32_t count);
+void rtcc_compare_stop(void);
+void RTCC_IRQHandler(void);
+
+#endif
@@ -6,6 +6,7 @@
 
 /* System include statements */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Silicon Labs include statements */
 #include "em_assert.h"
@@ -17,20 +18,25 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-
+#define SCHEDULER_MAX_EVENTS	64		// event ids and priority levels, multiple of 32
+#define SCHEDULER_WORDS			(SCHEDULER_MAX_EVENTS / 32)
+#define SCHEDULER_NO_EVENT		0		// event id that is never scheduled
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
-
+typedef void (*SCHEDULER_HANDLER)(void);
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
 void scheduler_open(void);
+void scheduler_register(uint32_t event, SCHEDULER_HANDLER handler, uint32_t priority);
 void add_scheduled_event(uint32_t event);
 void remove_scheduled_event(uint32_t event);
 uint32_t get_scheduled_events(void);
+bool scheduled_event_pending(uint32_t event);
+void scheduler_dispatch(void);
 
 
 #endif
@@ -43,6 +43,7 @@
 #include "em_int.h"
 #include "em_assert.h"
 #include "em_core.h"
+#include "em_rtcc.h"
 
 /* The developer's include statements */
 
@@ -57,6 +58,19 @@
 #define EM4					4
 #define MAX_ENERGY_MODES	5
 
+// Owners of sleep_block_mode() blocks, for the residency profiler
+#define SLEEP_TAG_APP		0
+#define SLEEP_TAG_RTCC		1
+#define SLEEP_TAG_LETIMER	2
+#define SLEEP_TAG_I2C		3
+#define SLEEP_TAG_LEUART_TX	4
+#define SLEEP_TAG_LEUART_RX	5
+#define MAX_SLEEP_TAGS		6
+
+//#define SLEEP_STATS_ENABLED
+#define SLEEP_STATS_HZ		32768			// RTCC ticks, the timestamp counter
+#define SLEEP_STATS_NOW()	RTCC_CounterGet()
+
 //***********************************************************************************
 // global variables
 //***********************************************************************************
@@ -66,9 +80,16 @@
 // function prototypes
 //***********************************************************************************
 void sleep_open(void);
-void sleep_block_mode(uint32_t EM);
-void sleep_unblock_mode(uint32_t EM);
+void sleep_block_mode(uint32_t EM, uint32_t tag);
+void sleep_unblock_mode(uint32_t EM, uint32_t tag);
 void enter_sleep(void);
 uint32_t current_block_energy_mode(void);
+#ifdef SLEEP_STATS_ENABLED
+void sleep_stats_reset(void);
+void sleep_stats_dump(void);
+#else
+#define sleep_stats_reset()
+#define sleep_stats_dump()
+#endif
 
 #endif /* SRC_HEADER_FILES_SLEEP_ROUTINES_H_ */
@@ -0,0 +1,60 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	SW_TIMER_HG
+#define	SW_TIMER_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+#include "em_core.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SW_TIMER_MIN_LEAD	2				// ticks, nearest compare that cannot be missed
+#define SW_TIMER_MAX_TICKS	0x7FFFFFFFu		// deadlines are compared as signed differences
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef void (*SW_TIMER_CALLBACK)(void *ctx);
+
+/* Free running counter the deadline list runs on, see rtcc_timer_port */
+typedef struct {
+	uint32_t	hz;							// counter frequency
+	uint32_t	(*now)(void);				// current count
+	void		(*arm)(uint32_t count);		// raise the compare interrupt at count
+	void		(*disarm)(void);			// no deadline pending
+} SW_TIMER_PORT;
+
+typedef struct SW_TIMER_STRUCT {
+	struct SW_TIMER_STRUCT	*next;			// deadline list link
+	uint32_t				deadline;		// counter value of the next expiry
+	uint32_t				period;			// ticks, 0 for a one-shot
+	uint32_t				event;			// scheduler event posted on expiry
+	SW_TIMER_CALLBACK		callback;		// called from the compare interrupt, may be NULL
+	void					*ctx;			// passed to the callback
+	volatile bool			active;			// on the deadline list
+} SW_TIMER_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void sw_timer_open(const SW_TIMER_PORT *port);
+void sw_timer_init(SW_TIMER_STRUCT *timer, uint32_t event, SW_TIMER_CALLBACK callback, void *ctx);
+void sw_timer_start(SW_TIMER_STRUCT *timer, uint32_t delay_ms, uint32_t period_ms);
+void sw_timer_start_ticks(SW_TIMER_STRUCT *timer, uint32_t delay, uint32_t period);
+void sw_timer_stop(SW_TIMER_STRUCT *timer);
+bool sw_timer_active(SW_TIMER_STRUCT *timer);
+uint32_t sw_timer_ms_to_ticks(uint32_t ms);
+void sw_timer_expire(void);
+
+#endif
@@ -0,0 +1,78 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef	TRACE_HG
+#define	TRACE_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+//#define TRACE_ENABLED
+#define TRACE_NOW()			(DWT->CYCCNT)	// core clock cycles, stops in EM2 and below
+
+// Trace points, the interrupt handlers then one per scheduler priority slot
+#define TRACE_ISR_LETIMER0	0
+#define TRACE_ISR_I2C0		1
+#define TRACE_ISR_I2C1		2
+#define TRACE_ISR_LEUART0	3
+#define TRACE_ISR_LDMA		4
+#define TRACE_ISR_RTCC		5
+#define TRACE_ISR_LETIMER1	6				// second instances, on parts that have them
+#define TRACE_ISR_LEUART1	7
+#define TRACE_ISR_COUNT		8
+#define TRACE_EVENT(slot)	(TRACE_ISR_COUNT + (slot))
+#define TRACE_POINTS		(TRACE_ISR_COUNT + SCHEDULER_MAX_EVENTS)
+
+#define TRACE_RING_SIZE		64				// last handler runs kept for a debugger, power of two
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+	uint32_t	count;
+	uint32_t	min;						// cycles
+	uint32_t	max;
+	uint64_t	sum;
+} TRACE_STAT_STRUCT;
+
+typedef struct {
+	uint32_t	start;						// CYCCNT at entry
+	uint32_t	cycles;
+	uint32_t	point;
+} TRACE_RECORD_STRUCT;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+#ifdef TRACE_ENABLED
+void trace_open(void);
+void trace_reset(void);
+void trace_exit(uint32_t point, uint32_t start);
+void trace_posted(uint32_t slot);
+void trace_dispatched(uint32_t slot);
+void trace_dump(void);
+
+#define TRACE_ENTER()		uint32_t trace_start = TRACE_NOW()
+#define TRACE_EXIT(point)	trace_exit((point), trace_start)
+#else
+#define trace_open()
+#define trace_reset()
+#define trace_posted(slot)		((void)(slot))
+#define trace_dispatched(slot)	((void)(slot))
+#define trace_dump()
+
+#define TRACE_ENTER()
+#define TRACE_EXIT(point)
+#endif
+
+#endif
@@ -2,7 +2,8 @@
  * @file HW_delay.c
  * @author NOT CONNOR PESKIN
  * @date
- * @brief Implements a hardware delay that functions properly in O2 optimization.
+ * @brief Implements millisecond delays on the software timers. The CPU sleeps
+ * for the whole delay instead of spinning on a high frequency timer.
  */
 
 //***********************************************************************************
@@ -13,6 +14,7 @@
 
 //** User Include Files
 #include "HW_delay.h"
+#include "irq.h"
 
 //***********************************************************************************
 // defined files
@@ -22,37 +24,100 @@
 //***********************************************************************************
 // private variables
 //***********************************************************************************
-
+static SW_TIMER_STRUCT	delay_async[HW_DELAY_ASYNC_MAX];
 
 //***********************************************************************************
 // Private functions Prototypes
 //***********************************************************************************
-
+static void delay_expired(void *ctx);
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ *	Software timer callback of the blocking delay
+ *
+ ******************************************************************************/
+static void delay_expired(void *ctx){
+	*(volatile bool *)ctx = true;
+}
 
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ *	Blocking delay
+ *
+ * @details
+ *	Arms a one-shot software timer and sleeps until it expires. The sleep mode
+ *	is chosen by enter_sleep(), so with nothing else blocking, the delay is
+ *	spent in EM2 with the RTCC running.
+ *
+ * @note
+ *	sw_timer_open() must have been called. Interrupts are serviced while
+ *	waiting but scheduled events are not dispatched until this returns, use
+ *	timer_delay_async() where that matters.
+ *
+ * @param[in] ms_delay
+ *	The delay in milliseconds.
+ *
+ ******************************************************************************/
 void timer_delay(uint32_t ms_delay){
-	uint32_t timer_clk_freq = CMU_ClockFreqGet(cmuClock_HFPER);
-	uint32_t delay_count = ms_delay *(timer_clk_freq/1000) / 1024;
-	CMU_ClockEnable(cmuClock_TIMER0, true);
-	TIMER_Init_TypeDef delay_counter_init = TIMER_INIT_DEFAULT;
-		delay_counter_init.oneShot = true;
-		delay_counter_init.enable = false;
-		delay_counter_init.mode = timerModeDown;
-		delay_counter_init.prescale = timerPrescale1024;
-		delay_counter_init.debugRun = false;
-	TIMER_Init(TIMER0, &delay_counter_init);
-	TIMER0->CNT = delay_count;
-	TIMER_Enable(TIMER0, true);
-	while (TIMER0->CNT != 00);
-	TIMER_Enable(TIMER0, false);
-	CMU_ClockEnable(cmuClock_TIMER0, false);
+	volatile bool done = false;
+	SW_TIMER_STRUCT delay;
+	sw_timer_init(&delay, SCHEDULER_NO_EVENT, delay_expired, (void *)&done);
+	sw_timer_start(&delay, ms_delay, 0);
+
+	CORE_DECLARE_IRQ_STATE;
+	while(!done){
+		CORE_ENTER_CRITICAL();
+		if(!done) enter_sleep(); // the expiry wakes the core even with interrupts masked
+		CORE_EXIT_CRITICAL();
+	}
 }
 
+/***************************************************************************//**
+ * @brief
+ *	Asynchronous delay
+ *
+ * @details
+ *	Returns at once. When the delay expires the callback, if any, is called
+ *	from interrupt context and the scheduler event, if any, is posted. The
+ *	main loop sleeps in between like for any other event.
+ *
+ * @note
+ *	Up to HW_DELAY_ASYNC_MAX delays can be pending, use a dedicated
+ *	SW_TIMER_STRUCT for anything periodic or long lived.
+ *
+ * @param[in] ms_delay
+ *	The delay in milliseconds.
+ *
+ * @param[in] event
+ *	Scheduler event posted on expiry, SCHEDULER_NO_EVENT for none.
+ *
+ * @param[in] callback
+ *	Function called on expiry, NULL for none.
+ *
+ * @param[in] *ctx
+ *	Argument passed to the callback.
+ *
+ ******************************************************************************/
+void timer_delay_async(uint32_t ms_delay, uint32_t event, SW_TIMER_CALLBACK callback, void *ctx){
+	SW_TIMER_STRUCT *delay = NULL;
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(IRQ_LEVEL_I2C);		// the slots are freed from the RTCC interrupt
+	for(int i = 0; i < HW_DELAY_ASYNC_MAX; i++){
+		if(!sw_timer_active(&delay_async[i])){
+			delay = &delay_async[i];
+			sw_timer_init(delay, event, callback, ctx);
+			sw_timer_start(delay, ms_delay, 0);
+			break;
+		}
+	}
+	IRQ_MASK_EXIT();
+	EFM_ASSERT(delay != NULL);
+}
@@ -3,7 +3,8 @@
  * @author Connor Peskin
  * @date October 16, 2020
  * @brief Functions to interact with the si7021 temperature/humidity sensor.
- * Currently only implements Temperature read.
+ * Implements Temperature and combined RH + Temperature reads, queued on the
+ * I2C driver with a selectable acquisition strategy.
  *
  */
 
@@ -21,12 +22,116 @@
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
-static uint32_t reading;
+// Datasheet maximum conversion times in ms, rounded up, by USER1_RES()
+static const uint8_t	temp_conv_ms[4] = { 11, 4, 7, 3 };	// 14, 12, 13, 11 bit
+static const uint8_t	rh_conv_ms[4] = { 12, 4, 5, 7 };	// 12, 8, 10, 11 bit, temperature not included
+
+static uint32_t			acquire_mode = SI7021_ACQUIRE;
+static uint32_t			resolution = USER1_RES(USER1_RESET_REG);
+static uint32_t			nack_retries;	// of the last completed sample
+static uint32_t			conv_ms;		// SI7021_TIMED wait of the measurement in progress
+static bool				measure_rh;		// measurement in progress is RH + temperature
+static uint32_t			read_event;		// posted when a sample is complete
+static uint8_t			measure_cmd;
+static uint8_t			prev_temp_cmd = READ_TEMP_PREV_RH;
+static uint8_t			reading[2];		// MS byte first
+static uint8_t			temp_reading[2];// temperature of an RH measurement, MS byte first
+static I2C_XFER_STRUCT	cmd_xfer;		// SI7021_TIMED measure command
+static I2C_XFER_STRUCT	read_xfer;		// measurement result
+static I2C_XFER_STRUCT	temp_xfer;		// temperature measured with the RH
+static SW_TIMER_STRUCT	conv_timer;		// SI7021_TIMED conversion time
+static EVENT_QUEUE_STRUCT si7021_queue;	// completed samples
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ *	I2C callback of the SI7021_TIMED measure command
+ *
+ * @details
+ *	The bus is released during the conversion, so the core can sleep in EM2
+ *	until the conversion timer expires.
+ *
+ ******************************************************************************/
+static void si7021_cmd_sent(I2C_XFER_STRUCT *xfer, void *ctx){
+	sw_timer_start(&conv_timer, conv_ms, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Conversion timer callback, reads the result
+ *
+ * @details
+ *	For an RH measurement the temperature read is queued behind the RH read,
+ *	the I2C driver starts it from the MSTOP of the first.
+ *
+ ******************************************************************************/
+static void si7021_conv_done(void *ctx){
+	i2c_submit(si7021_I2C, &read_xfer);
+	if(measure_rh) i2c_submit(si7021_I2C, &temp_xfer);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	I2C callback of the last read of a sample
+ *
+ * @details
+ *	Records the NACK retries of the result read and posts the sample, see
+ *	si7021_get_event().
+ *
+ ******************************************************************************/
+static void si7021_read_done(I2C_XFER_STRUCT *xfer, void *ctx){
+	uint32_t payload = (reading[0] << 8) | reading[1];
+	if(xfer == &temp_xfer) payload = (payload << 16) | (temp_reading[0] << 8) | temp_reading[1];
+	nack_retries = read_xfer.nacks;
+	event_queue_post(&si7021_queue, read_event, payload);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Queues one measurement with the selected acquisition strategy
+ *
+ * @details
+ *	An RH measurement is followed by READ_TEMP_PREV_RH, which returns the
+ *	temperature the device measured for its RH compensation without a
+ *	second conversion.
+ *
+ ******************************************************************************/
+static void si7021_measure(uint32_t read_cb, bool with_rh){
+	read_event = read_cb;
+	measure_rh = with_rh;
+	if(with_rh){
+		measure_cmd = (acquire_mode == SI7021_HOLD) ? MEASURE_RH_HOLD : MEASURE_RH_NHOLD;
+		conv_ms = rh_conv_ms[resolution] + temp_conv_ms[resolution];
+	} else {
+		measure_cmd = (acquire_mode == SI7021_HOLD) ? MEASURE_TEMP_HOLD : MEASURE_TEMP_NHOLD;
+		conv_ms = temp_conv_ms[resolution];
+	}
+
+	if(acquire_mode == SI7021_TIMED){
+		i2c_xfer_init(&cmd_xfer, SLAVE_ADDR, &measure_cmd, 1, NULL, 0);
+		cmd_xfer.callback = si7021_cmd_sent;
+		i2c_xfer_init(&read_xfer, SLAVE_ADDR, NULL, 0, reading, sizeof(reading));
+	} else {
+		i2c_xfer_init(&read_xfer, SLAVE_ADDR, &measure_cmd, 1, reading, sizeof(reading));
+	}
+	read_xfer.flags = I2C_XFER_RETRY_NACK; // only expected to retry in SI7021_NACK_POLL
+	if(with_rh){
+		i2c_xfer_init(&temp_xfer, SLAVE_ADDR, &prev_temp_cmd, 1, temp_reading, sizeof(temp_reading));
+		temp_xfer.callback = si7021_read_done;
+	} else {
+		read_xfer.callback = si7021_read_done;
+	}
+
+	if(acquire_mode == SI7021_TIMED){
+		i2c_submit(si7021_I2C, &cmd_xfer);
+	} else {
+		i2c_submit(si7021_I2C, &read_xfer);
+		if(with_rh) i2c_submit(si7021_I2C, &temp_xfer);
+	}
+}
 
 
 //***********************************************************************************
@@ -40,13 +145,15 @@ static uint32_t reading;
  * @details
  *	Creates an I2C_OPEN_STRUCT for I2C operation with the SI7021 module
  *	onboard the PG12 Starter Kit. Opens this Device for I2C operation.
+ *	Also sets up the conversion timer of SI7021_TIMED and the sample queue.
  *
  * @note
- *	Will use the I2C0 peripheral.
+ *	Will use the I2C0 peripheral. sw_timer_open() must have been called.
  *
  ******************************************************************************/
 void si7021_i2c_open(){
 	I2C_OPEN_STRUCT i2c_setup;
+	sw_timer_init(&conv_timer, SCHEDULER_NO_EVENT, si7021_conv_done, NULL);
 	i2c_setup.enable = true; //enable i2c operation
 	i2c_setup.master = true; //we are operating as master
 	i2c_setup.refFreq = 0; //current configured reference clock will be used
@@ -58,6 +165,7 @@ void si7021_i2c_open(){
 	i2c_setup.scl_pin_en = true;
 
 	i2c_open(I2C0, &i2c_setup);
+	event_queue_init(&si7021_queue);
 }
 
 /***************************************************************************//**
@@ -65,70 +173,249 @@ void si7021_i2c_open(){
  *	Read Temperature from SI7021
  *
  * @details
- *	Calls for I2C to start a Temperature Read from the SI7021 temperature
- *	sensor.
+ *	Queues a Temperature Read from the SI7021 temperature sensor using the
+ *	acquisition strategy set by si7021_acquire_mode():
+ *	SI7021_NACK_POLL writes the no hold measure command and re-addresses the
+ *	device after a repeated START while it NACKs during the conversion.
+ *	SI7021_HOLD writes the hold master command; the device ACKs the read and
+ *	stretches SCL until the result is ready, the core waits in EM1.
+ *	SI7021_TIMED writes the no hold command and releases the bus, sleeps in
+ *	EM2 for the datasheet conversion time of the configured resolution, then
+ *	reads the result once.
  *
  * @note
- *	Stores the device transmission data in the private 'reading' variable.
+ *	The sample event carries the 16 bit reading as its payload, see
+ *	si7021_get_event(). The previous read must have completed.
+ *
+ * @param[in] read_cb
+ *	Scheduler event posted when the reading is available.
  *
  ******************************************************************************/
 void si7021_read(uint32_t read_cb){
-	uint32_t numBytes = 2; // 2 bytes, 13 bit 
-	bool readWrite = true;  // we will be reading temp 
-	i2c_start(I2C0, SLAVE_ADDR, &reading, numBytes, MEASURE_TEMP_NHOLD, readWrite, read_cb);
+	si7021_measure(read_cb, false);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Read Relative Humidity and Temperature from SI7021
+ *
+ * @details
+ *	Measures RH with the strategy set by si7021_acquire_mode(), then reads the
+ *	temperature from the RH measurement with READ_TEMP_PREV_RH in the same
+ *	chain of I2C transfers. Both values cost one conversion.
+ *
+ * @note
+ *	The sample event carries the RH code in the upper and the temperature
+ *	code in the lower 16 bits of its payload, see SI7021_RH_CODE() and
+ *	SI7021_TEMP_CODE(). The previous read must have completed.
+ *
+ * @param[in] read_cb
+ *	Scheduler event posted when both readings are available.
+ *
+ ******************************************************************************/
+void si7021_read_rh(uint32_t read_cb){
+	si7021_measure(read_cb, true);
 }
 
 /***************************************************************************//**
  * @brief
- *	Converts Temperature Reading to deg F
+ *	Take the oldest completed sample
  *
  * @details
- *	Uses the private variable 'reading' to calculate deg C then convert it into
- *	deg F to get a decimal temperature reading.
+ *	Every si7021_read() or si7021_read_rh() posts one record when its last
+ *	I2C transfer completes; the timestamp is the RTCC count at that STOP.
  *
  * @note
- *	This should only be called from the scheduler callback function- after a read
- *	transmission has completed.
+ *	Should be called from the read event handler until it returns false.
+ *
+ * @param[out] *msg
+ *	Where to copy the record.
+ *
+ * @return
+ *	Returns false once no record is left.
  *
  ******************************************************************************/
-float tempConvert_si7021(){
-	float temp = ((175.72 * (float)reading) / 65536) - 46.85; // conversion to C
-	temp = (temp * (9.0/5.0)) + 32; //conversion
- 	return temp;
+bool si7021_get_event(EVENT_MSG_STRUCT *msg){
+	return event_queue_get(&si7021_queue, msg);
 }
 
+/***************************************************************************//**
+ * @brief
+ *	Selects how si7021_read() waits for the conversion
+ *
+ * @param[in] mode
+ *	SI7021_NACK_POLL, SI7021_HOLD or SI7021_TIMED
+ *
+ ******************************************************************************/
+void si7021_acquire_mode(uint32_t mode){
+	EFM_ASSERT(mode <= SI7021_TIMED);
+	acquire_mode = mode;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the number of NACKed read addresses of the last sample
+ *
+ * @details
+ *	Each one is an extra START and interrupt, so this is 0 with SI7021_HOLD
+ *	and SI7021_TIMED and tracks the conversion time with SI7021_NACK_POLL.
+ *
+ ******************************************************************************/
+uint32_t si7021_nack_retries(void){
+	return nack_retries;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Converts Temperature Reading to hundredths of deg C
+ *
+ * @details
+ *	Fixed-point form of the datasheet formula 175.72 * code / 65536 - 46.85,
+ *	rounded to the nearest hundredth.
+ *
+ * @param[in] reading
+ *	The 16 bit temperature code read from the Si7021.
+ *
+ ******************************************************************************/
+int32_t tempCentiC_si7021(uint32_t reading){
+	return (int32_t)((17572u * reading + 32768u) >> 16) - 4685;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Converts Temperature Reading to hundredths of deg F
+ *
+ * @details
+ *	Folds the deg C formula and C * 9 / 5 + 32 into one scale and offset:
+ *	316.296 / 65536 = 39537 / 81920 per code, -52.33 deg F at code 0.
+ *
+ * @note
+ *	The reading is the payload of the sample event, so every sample
+ *	is converted even when several complete before the handler runs.
+ *
+ * @param[in] reading
+ *	The 16 bit temperature code read from the Si7021.
+ *
+ ******************************************************************************/
+int32_t tempCentiF_si7021(uint32_t reading){
+	return (int32_t)((39537u * reading + 40960u) / 81920u) - 5233;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Converts Relative Humidity Reading to hundredths of %RH
+ *
+ * @details
+ *	Fixed-point form of 125 * code / 65536 - 6, rounded to the nearest
+ *	hundredth.
+ *
+ * @param[in] reading
+ *	The 16 bit RH code read from the Si7021.
+ *
+ ******************************************************************************/
+int32_t rhCenti_si7021(uint32_t reading){
+	return (int32_t)((12500u * reading + 32768u) >> 16) - 600;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Temperature Reading in deg C as an unrounded fraction
+ *
+ * @details
+ *	175.72 * code / 65536 - 46.85 = (4393 * code - 76759040) / 1638400, the
+ *	numerator is returned and SI7021_TEMP_C_DEN is the denominator. Text is
+ *	rounded from this once, see fmt_tenths(), a centi value is already
+ *	rounded.
+ *
+ * @param[in] reading
+ *	The 16 bit temperature code read from the Si7021.
+ *
+ ******************************************************************************/
+int64_t tempNumC_si7021(uint32_t reading){
+	return (int64_t)4393 * reading - 76759040;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Temperature Reading in deg F as an unrounded fraction
+ *
+ * @details
+ *	(39537 * code - 428687360) / 8192000, over SI7021_TEMP_F_DEN. The
+ *	numerator passes 2^31 at the top codes.
+ *
+ * @param[in] reading
+ *	The 16 bit temperature code read from the Si7021.
+ *
+ ******************************************************************************/
+int64_t tempNumF_si7021(uint32_t reading){
+	return (int64_t)39537 * reading - 428687360;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Relative Humidity Reading in %RH as an unrounded fraction
+ *
+ * @details
+ *	125 * code / 65536 - 6 = (125 * code - 393216) / 65536, over
+ *	SI7021_RH_DEN.
+ *
+ * @param[in] reading
+ *	The 16 bit RH code read from the Si7021.
+ *
+ ******************************************************************************/
+int64_t rhNum_si7021(uint32_t reading){
+	return (int64_t)125 * reading - 393216;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Configures and checks the SI7021
+ *
+ * @details
+ *	Verifies the User 1 register reset value, sets the RH10_TEMP13 resolution
+ *	and reads it back, then takes one temperature reading and checks it is in
+ *	a sensible range. Each transfer is waited for in EM1.
+ *
+ ******************************************************************************/
 void si7021_TDD_config(void){
+	I2C_XFER_STRUCT xfer;
+	uint8_t cmd[2];
+	uint8_t data = 0x0;
+
 	timer_delay(80u); // make sure that the device is booted up off reset
 	/* Perform a single-byte read of the User 1 register on the SI 7021.*/
-	uint32_t data = 0x0;
-	bool readWrite = true;
-	i2c_start(si7021_I2C, SLAVE_ADDR, &data,  1, READ_USER1_REG_CMD, readWrite, 0); // perform single byte read
-	while(i2c_sm_busy(si7021_I2C)); //wait for TX oper
+	cmd[0] = READ_USER1_REG_CMD;
+	i2c_xfer_init(&xfer, SLAVE_ADDR, cmd, 1, &data, 1);
+	i2c_submit(si7021_I2C, &xfer);
+	i2c_wait(&xfer);
 	EFM_ASSERT(data == USER1_RESET_REG); // Validate that the register is the expected reset value
 
 	/* configure the si7021 user 1 register by performing a single-byte write) */
-	data = RH10_TEMP13;
-	readWrite = false; // will be a write
-	i2c_start(si7021_I2C, SLAVE_ADDR, &data, 1, WRITE_USER1_REG_CMD, readWrite, 0);
-	while(i2c_sm_busy(si7021_I2C));
+	cmd[0] = WRITE_USER1_REG_CMD;
+	cmd[1] = RH10_TEMP13;
+	i2c_xfer_init(&xfer, SLAVE_ADDR, cmd, 2, NULL, 0);
+	i2c_submit(si7021_I2C, &xfer);
+	i2c_wait(&xfer);
 	timer_delay(80u);
 
 	/* now we want to verify that we successfully changed to a 13-bit temp read resolution*/
-	data= 0x0;
-	readWrite = true; //will be reading
-	i2c_start(si7021_I2C, SLAVE_ADDR, &data,  1, READ_USER1_REG_CMD, readWrite, 0); // perform single byte read
-	while(i2c_sm_busy(si7021_I2C)); //wait for TX oper
+	data = 0x0;
+	cmd[0] = READ_USER1_REG_CMD;
+	i2c_xfer_init(&xfer, SLAVE_ADDR, cmd, 1, &data, 1);
+	i2c_submit(si7021_I2C, &xfer);
+	i2c_wait(&xfer);
 	EFM_ASSERT(data == RH10_TEMP13); // Validate that the register is the expected modified value
+	resolution = USER1_RES(data); // conversion time of SI7021_TIMED
 
 	//now perform a read and ensure that it's an accurate 
-	reading = 0x0;
-	readWrite = true;
-	i2c_start(si7021_I2C, SLAVE_ADDR, &reading, 2, MEASURE_TEMP_NHOLD, readWrite);
-	while(i2c_sm_busy(si7021_I2C));
-	float temp = tempConvert_si7021();
-	if((temp > 90) || (temp < 60)) EFM_ASSERT(false); // asserts if out of general expected range
+	uint8_t raw[2];
+	cmd[0] = MEASURE_TEMP_HOLD;
+	i2c_xfer_init(&xfer, SLAVE_ADDR, cmd, 1, raw, sizeof(raw));
+	i2c_submit(si7021_I2C, &xfer);
+	i2c_wait(&xfer);
+	int32_t temp = tempCentiF_si7021((raw[0] << 8) | raw[1]);
+	if((temp > 9000) || (temp < 6000)) EFM_ASSERT(false); // asserts if out of general expected range
 
 	// PASSED TDD Configuration Test
 	ble_write("\nPassed SI7021 TDD Test\n");
 }
-
@@ -0,0 +1,98 @@
+/**
+ * @file adapt.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Adaptive sample period. The period is halved, down to a floor, while
+ * the sampled value changes fast, and doubled, up to a ceiling, after a run of
+ * stable samples, so a quiet sensor is read far less often. Free of hardware;
+ * the caller applies the period, see letimer_set_period().
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "adapt.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Initializes the controller at its shortest period
+ *
+ * @param[in] *adapt
+ *	Controller owned by the caller.
+ *
+ * @param[in] *config
+ *	Period limits and thresholds, copied.
+ *
+ ******************************************************************************/
+void adapt_init(ADAPT_STRUCT *adapt, const ADAPT_CONFIG_STRUCT *config){
+	adapt->config = *config;
+	adapt->period_ms = config->min_ms;
+	adapt->last_value = 0;
+	adapt->have_last = false;
+	adapt->stable = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Feeds a sample to the controller
+ *
+ * @details
+ *	The change from the previous sample is scaled to a rate per minute of the
+ *	current period. Above fast_rate the period is halved at once. A change
+ *	within the noise band counts as stable, and stable_count stable samples
+ *	in a row double the period. Anything in between keeps the period.
+ *
+ * @param[in] *adapt
+ *	Controller set up by adapt_init().
+ *
+ * @param[in] value
+ *	The sample, taken one current period after the previous one.
+ *
+ * @return
+ *	The period in ms until the next sample.
+ *
+ ******************************************************************************/
+uint32_t adapt_update(ADAPT_STRUCT *adapt, int32_t value){
+	ADAPT_CONFIG_STRUCT *config = &adapt->config;
+	int32_t delta = value - adapt->last_value;
+	bool first = !adapt->have_last;
+
+	adapt->last_value = value;
+	adapt->have_last = true;
+	if(first) return adapt->period_ms;
+
+	if(delta < 0) delta = -delta;
+	if(delta <= config->noise){
+		if(++adapt->stable >= config->stable_count){
+			adapt->stable = 0;
+			adapt->period_ms = (adapt->period_ms > config->max_ms / 2) ? config->max_ms : adapt->period_ms * 2;
+		}
+		return adapt->period_ms;
+	}
+
+	adapt->stable = 0;
+	if((uint64_t)delta * 60000 > (uint64_t)config->fast_rate * adapt->period_ms){
+		adapt->period_ms = (adapt->period_ms < config->min_ms * 2) ? config->min_ms : adapt->period_ms / 2;
+	}
+	return adapt->period_ms;
+}
@@ -24,8 +24,33 @@
 //***********************************************************************************
 // Static / Private Variables
 //***********************************************************************************
-
-//#define BLE_TEST_ENABLED
+typedef struct {
+	uint32_t			event;		// scheduler event id
+	SCHEDULER_HANDLER	handler;	// function called by the scheduler
+	uint32_t			priority;	// 0 is dispatched first
+} APP_EVENT_STRUCT;
+
+static const APP_EVENT_STRUCT app_events[] = {
+	{ BLE_TX_DONE_CB,		ble_tx_done_cb,					BLE_TX_DONE_PRI },
+	{ I2C_7021_READ_CB,		scheduled_si7021_tempDone,		I2C_7021_READ_PRI },
+	{ LETIMER0_UF_CB,		scheduled_letimer0_uf_evt,		LETIMER0_UF_PRI },
+	{ LETIMER0_COMP0_CB,	scheduled_letimer0_comp0_evt,	LETIMER0_COMP0_PRI },
+	{ LETIMER0_COMP1_CB,	scheduled_letimer0_comp1_evt,	LETIMER0_COMP1_PRI },
+	{ BOOT_UP_CB,			scheduled_boot_up_cb,			BOOT_UP_PRI },
+	{ BATCH_FLUSH_CB,		scheduled_batch_flush_cb,		BATCH_FLUSH_PRI },
+	{ BLE_RX_CB,			scheduled_ble_rx_cb,			BLE_RX_PRI },
+	{ BLE_CONFIG_CB,		scheduled_ble_config_cb,		BLE_CONFIG_PRI },
+};
+
+static BATCH_STRUCT sample_batch;
+static REPORT_CHANNEL_STRUCT temp_report;
+static REPORT_CHANNEL_STRUCT rh_report;
+static ADAPT_STRUCT sample_period;
+static char ble_name[BLE_NAME_MAX + 1] = BLE_NAME;
+static uint32_t ble_config_runs;		// since the last successful configuration
+
+//#define BLE_CONFIG_ENABLED		// configure the HM-10 at boot
+//#define BLE_BAUD_ENABLED		// and negotiate a faster baud rate for the sample batches
 
 //***********************************************************************************
 // Private functions
@@ -33,6 +58,64 @@
 
 //static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route);
 
+/***************************************************************************//**
+ * @brief
+ *	Starts the HM-10 configuration with ble_name, BLE_ADV_INTERVAL and
+ *	BLE_TX_POWER, and with BLE_BAUD_ENABLED the baud rate ble_baud_choose()
+ *	picks for full sample batches at their highest rate
+ *
+ * @details
+ *	Runs in the background, scheduled_ble_config_cb() is called when done.
+ *
+ ******************************************************************************/
+static void app_ble_config(void){
+	BLE_CONFIG_STRUCT config = {
+		.name = ble_name,
+		.adv_interval = BLE_ADV_INTERVAL,
+		.tx_power = BLE_TX_POWER,
+#ifdef BLE_BAUD_ENABLED
+		.baud = ble_baud_choose(BATCH_BURST_BYTES, BATCH_BURSTS_PER_HOUR),
+#endif
+	};
+	ble_config_runs++;
+	ble_config(&config, BLE_CONFIG_CB);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sends a batch of Si7021 samples in one BLE transmit
+ *
+ * @details
+ *	With BLE_FRAME_BINARY the samples share one binary frame, otherwise the
+ *	samples' text lines are formatted directly into the BLE circular buffer,
+ *	BATCH_TEXT_SAMPLES per reservation so a frame always fits the buffer.
+ *
+ ******************************************************************************/
+static void app_batch_send(const BATCH_SAMPLE_STRUCT *samples, uint32_t count){
+#if BLE_FRAMING == BLE_FRAME_BINARY
+	for(uint32_t i = 0; i < count; i++){
+		ble_frame_add(SENSOR_SI7021_RHT, samples[i].timestamp, samples[i].value, BATCH_MAX_VALUES);
+	}
+	ble_frame_flush();
+#else
+	for(uint32_t first = 0; first < count; first += BATCH_TEXT_SAMPLES){
+		uint32_t last = first + BATCH_TEXT_SAMPLES;
+		if(last > count) last = count;
+		char *line = ble_reserve((last - first) * SAMPLE_LINE_MAX);
+		if(!line) return;
+		uint32_t n = 0;
+		for(uint32_t i = first; i < last; i++){
+			n += fmt_str(&line[n], "Temp = ");
+			n += fmt_tenths(&line[n], tempNumF_si7021(SI7021_TEMP_CODE(samples[i].raw)), SI7021_TEMP_F_DEN);
+			n += fmt_str(&line[n], " F\nRH = ");
+			n += fmt_tenths(&line[n], rhNum_si7021(SI7021_RH_CODE(samples[i].raw)), SI7021_RH_DEN);
+			n += fmt_str(&line[n], " %\n");
+		}
+		ble_commit(n);
+	}
+#endif
+}
+
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
@@ -42,9 +125,14 @@
  * Function to setup the peripheral drivers for PWM use and Interrupts of LETIMER
  *
  * @details
- * This function calls the CMU initialization driver, GPIO init driver, and LETIMER PWM init driver
- * prior to starting the LETIMER.
- * The BLE module is also opened using LEUART and a circular buffer.
+ * The NVIC priority plan of irq.c is set up first, the drivers apply it as they
+ * are opened. This function calls the CMU initialization driver, GPIO init driver, and LETIMER PWM init driver
+ * prior to starting the LETIMER. The RTCC is started early as it timestamps the
+ * event queue records. Every application event handler in app_events[] is
+ * registered with the scheduler. The sample batch and the report-on-change
+ * channels are opened with the Si7021.
+ * The LDMA is opened before the BLE module, which uses it to feed the LEUART,
+ * and the BLE module is opened using LEUART and a circular buffer.
  *
  * @note
  * This function should be called to initialize all peripherals.
@@ -52,13 +140,49 @@
  ******************************************************************************/
 
 void app_peripheral_setup(void){
+	irq_open();
 	cmu_open();
+	trace_open();
 	gpio_open();
 	sleep_open();
+	rtcc_open();
+	sw_timer_open(&rtcc_timer_port);
 	scheduler_open();
+	for(int i = 0; i < sizeof(app_events) / sizeof(app_events[0]); i++){
+		scheduler_register(app_events[i].event, app_events[i].handler, app_events[i].priority);
+	}
 	si7021_i2c_open();
-	sleep_block_mode(SYSTEM_BLOCK_EM);
-	ble_open(BLE_TX_DONE_CB,0);
+	BATCH_CONFIG_STRUCT batch_config = {
+		.count = BATCH_SAMPLES,
+		.latency_ms = BATCH_LATENCY_MS,
+		.threshold = { BATCH_TEMP_STEP, BATCH_RH_STEP },
+		.flush_event = BATCH_FLUSH_CB,
+		.flush = app_batch_send,
+	};
+	batch_open(&sample_batch, &batch_config);
+	REPORT_CONFIG_STRUCT report_config = {
+		.deadband = REPORT_TEMP_BAND,
+		.min_interval = RTCC_MS_TO_TICKS(REPORT_MIN_MS),
+		.max_interval = RTCC_MS_TO_TICKS(REPORT_MAX_MS),
+		.alarm_en = true,
+		.alarm_on = TEMP_ALARM_CENTI_F,
+		.alarm_off = TEMP_CLEAR_CENTI_F,
+	};
+	report_init(&temp_report, &report_config);
+	report_config.deadband = REPORT_RH_BAND;
+	report_config.alarm_en = false;
+	report_init(&rh_report, &report_config);
+	ADAPT_CONFIG_STRUCT adapt_config = {
+		.min_ms = PWM_PER * 1000,
+		.max_ms = ADAPT_MAX_MS,
+		.noise = ADAPT_NOISE,
+		.fast_rate = ADAPT_FAST_RATE,
+		.stable_count = ADAPT_STABLE,
+	};
+	adapt_init(&sample_period, &adapt_config);
+	sleep_block_mode(SYSTEM_BLOCK_EM, SLEEP_TAG_APP);
+	ldma_open();
+	ble_open(BLE_TX_DONE_CB, BLE_RX_CB);
 	app_letimer_pwm_open(PWM_PER, PWM_ACT_PER, PWM_ROUTE_0, PWM_ROUTE_1);
 
 	add_scheduled_event(BOOT_UP_CB); //TDD - Lab 5
@@ -130,7 +254,6 @@ void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, u
  *
  ******************************************************************************/
 void scheduled_letimer0_comp0_evt(void){
-	remove_scheduled_event(LETIMER0_COMP0_CB);
 	EFM_ASSERT(false);
 }
 
@@ -148,7 +271,6 @@ void scheduled_letimer0_comp0_evt(void){
  *
  ******************************************************************************/
 void scheduled_letimer0_comp1_evt(void){
-	remove_scheduled_event(LETIMER0_COMP1_CB);
 	EFM_ASSERT(false);
 }
 
@@ -162,13 +284,27 @@ void scheduled_letimer0_comp1_evt(void){
  *
  * @note
  * This will not cycle into the EM4 energy mode, as we need the low frequency
- * clocks for the LETIMER interrupts.
+ * clocks for the LETIMER interrupts. With SLEEP_STATS_ENABLED the energy mode
+ * residency is reported every SLEEP_STATS_PERIODS underflows, with
+ * TRACE_ENABLED the handler timings every TRACE_PERIODS.
  *
  ******************************************************************************/
 void scheduled_letimer0_uf_evt(void){
-	remove_scheduled_event(LETIMER0_UF_CB);
-
-	si7021_read(I2C_7021_READ_CB);
+	si7021_read_rh(I2C_7021_READ_CB);
+#ifdef SLEEP_STATS_ENABLED
+	static uint32_t periods;
+	if(++periods >= SLEEP_STATS_PERIODS){
+		periods = 0;
+		sleep_stats_dump();
+	}
+#endif
+#ifdef TRACE_ENABLED
+	static uint32_t trace_periods;
+	if(++trace_periods >= TRACE_PERIODS){
+		trace_periods = 0;
+		trace_dump();
+	}
+#endif
 }
 
 /***************************************************************************//**
@@ -176,28 +312,108 @@ void scheduled_letimer0_uf_evt(void){
  * SI7021 Temperature Reading Complete Handler
  *
  * @details
- * Will get the temperature (F) reading from the private variable in SI7021.c
- * using the tempConvert command.  If the temperature is above 80 (F), LED1
- * will be asserted. If the temperature is below 80 (F), LED1 will be deasserted.
- * The result temperature data will be transmitted to the HM18 peripheral via
- * LEUART.
+ * Drains every completed Si7021 RH + temperature sample in order. Each
+ * reading is converted to hundredths of a degree (F); if it rises above 80 (F),
+ * LED1 will be asserted. LED1 is deasserted once the temperature falls to
+ * 79.5 (F), so noise around the threshold does not toggle it. The sample is
+ * only kept when the temperature or humidity report channel asks for it, see
+ * report_check(); it is then added to the sample batch, which is transmitted
+ * to the HM18 peripheral via LEUART in one burst, see app_batch_send().
+ * Every temperature also feeds the adaptive sample period, which LETIMER0
+ * is switched to once all samples are drained.
  *
  * @note
  *	Corresponds with scheduled event 'I2C_7021_READ_CB'
  *
  ******************************************************************************/
 void scheduled_si7021_tempDone(void){
-	EFM_ASSERT(get_scheduled_events() & I2C_7021_READ_CB);
-	remove_scheduled_event(I2C_7021_READ_CB);
+	EVENT_MSG_STRUCT sample;
+	uint32_t period_ms = sample_period.period_ms;
+	while(si7021_get_event(&sample)){
+		int16_t values[BATCH_MAX_VALUES];
+		values[0] = tempCentiF_si7021(SI7021_TEMP_CODE(sample.payload));
+		values[1] = rhCenti_si7021(SI7021_RH_CODE(sample.payload));
+		adapt_update(&sample_period, values[0]);
+		uint32_t report = report_check(&temp_report, sample.timestamp, values[0]);
+		report |= report_check(&rh_report, sample.timestamp, values[1]);
+		if(report & REPORT_ALARM_EDGE){
+			if(report_alarm(&temp_report)) GPIO_PinOutSet(LED1_PORT, LED1_PIN);
+			else GPIO_PinOutClear(LED1_PORT, LED1_PIN);
+		}
+		if(!(report & REPORT_SEND)) continue;
+
+		report_sent(&temp_report, sample.timestamp, values[0]);
+		report_sent(&rh_report, sample.timestamp, values[1]);
+		batch_add(&sample_batch, sample.timestamp, values, sample.payload);
+	}
+	if(sample_period.period_ms != period_ms){
+		letimer_set_period(LETIMER0, sample_period.period_ms / 1000.0f, PWM_ACT_PER);
+	}
+}
 
-	float tempReading = tempConvert_si7021();
-	if(tempReading > 80) GPIO_PinOutSet(LED1_PORT, LED1_PIN);
-	else GPIO_PinOutClear(LED1_PORT, LED1_PIN);
+/***************************************************************************//**
+ * @brief
+ *	Sample batch latency expired
+ *
+ * @note
+ *	Corresponds with scheduled event 'BATCH_FLUSH_CB'
+ *
+ ******************************************************************************/
+void scheduled_batch_flush_cb(void){
+	batch_timeout(&sample_batch);
+}
 
-	char string[15];
-	sprintf(string, "Temp = %.1f F\n", tempReading);
-	if(string[10] == '0') sprintf(string, "Temp = %.0f F\n", tempReading);
-	ble_write(string);
+/***************************************************************************//**
+ * @brief
+ *	Lines received from the HM-10
+ *
+ * @details
+ *	Command lines from the phone: "FLUSH" sends the samples waiting in the
+ *	batch now, "STATS" and "TRACE" the energy mode residency and handler
+ *	timings when built with them, "NAME <name>" configures the HM-10 with a
+ *	new advertised name, which ends the connection. AT responses and unknown
+ *	lines are ignored.
+ *
+ * @note
+ *	Corresponds with scheduled event 'BLE_RX_CB'
+ *
+ ******************************************************************************/
+void scheduled_ble_rx_cb(void){
+	char line[BLE_RX_LINE_MAX + 1];
+	while(ble_rx_read(line, sizeof(line))){
+		if(!strcmp(line, "FLUSH")) batch_flush(&sample_batch);
+		else if(!strncmp(line, "NAME ", 5) && line[5] && (strlen(&line[5]) <= BLE_NAME_MAX)){
+			strcpy(ble_name, &line[5]);
+			ble_config_runs = 0;
+			app_ble_config();
+		}
+#ifdef SLEEP_STATS_ENABLED
+		else if(!strcmp(line, "STATS")) sleep_stats_dump();
+#endif
+#ifdef TRACE_ENABLED
+		else if(!strcmp(line, "TRACE")) trace_dump();
+#endif
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	HM-10 configuration applied or failed
+ *
+ * @details
+ *	A failed configuration is run again up to BLE_CONFIG_RETRIES times, the
+ *	module keeps its previous settings otherwise.
+ *
+ * @note
+ *	Corresponds with scheduled event 'BLE_CONFIG_CB'
+ *
+ ******************************************************************************/
+void scheduled_ble_config_cb(void){
+	if(ble_at_status(NULL) != BLE_AT_FAILED){
+		ble_config_runs = 0;
+		return;
+	}
+	if(ble_config_runs <= BLE_CONFIG_RETRIES) app_ble_config();
 }
 
 /***************************************************************************//**
@@ -206,25 +422,20 @@ void scheduled_si7021_tempDone(void){
  *
  * @details
  *	This function will be called upon booting up the device and will print
- *	"Hello World" to the LEUART peripheral. If BLE_TEST_ENABLED is defined,
- *	this function will test the LEUART communication with the peripheral.
+ *	"Hello World" to the LEUART peripheral. If BLE_CONFIG_ENABLED or
+ *	BLE_BAUD_ENABLED is defined, the HM-10 is configured first, the text waits in the circular buffer
+ *	until the configuration is done.
  *
  * @note
  * Corresponds with scheduled event 'BOOT_UP_CB'
  *
  ******************************************************************************/
 void scheduled_boot_up_cb(void){
-	EFM_ASSERT(get_scheduled_events() & BOOT_UP_CB);
-	remove_scheduled_event(BOOT_UP_CB);
-
-#ifdef BLE_TEST_ENABLED
-	bool success = ble_test("PESKIN_UART");
-	EFM_ASSERT(success);
-	timer_delay(2000u);
-#endif
-
 	circular_buff_test();
 	si7021_TDD_config();
+#if defined(BLE_CONFIG_ENABLED) || defined(BLE_BAUD_ENABLED)
+	app_ble_config();
+#endif
 
 	ble_write("\nHello World\n");
 	ble_write("Course Project I2C\n");
@@ -245,9 +456,6 @@ void scheduled_boot_up_cb(void){
  *
  ******************************************************************************/
 void ble_tx_done_cb(void){
-	EFM_ASSERT(get_scheduled_events() & BLE_TX_DONE_CB);
-	remove_scheduled_event(BLE_TX_DONE_CB);
-
 	ble_circ_pop(false);
 }
 
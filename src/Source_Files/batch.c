@@ -0,0 +1,146 @@
+/**
+ * @file batch.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Holds sensor samples in RAM and hands them to the radio in bursts,
+ * so the LEUART and the BLE module wake once per batch instead of once per
+ * sample. A batch is sent when it is full, when its oldest sample reaches
+ * the latency limit, or at once when a value changes past its threshold.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "batch.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true if a value moved past its threshold since the last flush
+ *
+ ******************************************************************************/
+static bool batch_changed(BATCH_STRUCT *batch, const int16_t *values){
+	if(!batch->sent_any) return false;
+	for(int i = 0; i < BATCH_MAX_VALUES; i++){
+		int32_t threshold = batch->config.threshold[i];
+		int32_t delta = (int32_t)values[i] - batch->last_sent.value[i];
+		if(threshold && ((delta >= threshold) || (delta <= -threshold))) return true;
+	}
+	return false;
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Opens an empty batch
+ *
+ * @note
+ *	sw_timer_open() must have been called if config->latency_ms is set.
+ *
+ * @param[in] *batch
+ *	Batch owned by the caller.
+ *
+ * @param[in] *config
+ *	Flush conditions and function, copied.
+ *
+ ******************************************************************************/
+void batch_open(BATCH_STRUCT *batch, const BATCH_CONFIG_STRUCT *config){
+	EFM_ASSERT((config->count > 0) && (config->count <= BATCH_MAX_SAMPLES));
+	EFM_ASSERT(config->flush != NULL);
+	batch->config = *config;
+	batch->held = 0;
+	batch->sent_any = false;
+	sw_timer_init(&batch->latency_timer, config->flush_event, NULL, NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Adds a sample to a batch
+ *
+ * @details
+ *	The first sample of a batch starts the latency timer. The batch is flushed
+ *	right away, this sample included, once it holds config.count samples or
+ *	a value moved at least its threshold from the last sample sent.
+ *
+ * @note
+ *	Main loop only.
+ *
+ * @param[in] *batch
+ *	Batch opened by batch_open().
+ *
+ * @param[in] timestamp
+ *	RTCC count of the sample.
+ *
+ * @param[in] *values
+ *	BATCH_MAX_VALUES fixed-point values.
+ *
+ * @param[in] raw
+ *	The reading they were converted from, handed back to the flush.
+ *
+ ******************************************************************************/
+void batch_add(BATCH_STRUCT *batch, uint32_t timestamp, const int16_t *values, uint32_t raw){
+	BATCH_SAMPLE_STRUCT *sample = &batch->sample[batch->held++];
+	sample->timestamp = timestamp;
+	sample->raw = raw;
+	for(int i = 0; i < BATCH_MAX_VALUES; i++) sample->value[i] = values[i];
+
+	if(batch->held == 1 && batch->config.latency_ms){
+		sw_timer_start(&batch->latency_timer, batch->config.latency_ms, 0);
+	}
+	if((batch->held >= batch->config.count) || batch_changed(batch, values)){
+		batch_flush(batch);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Handles config.flush_event
+ *
+ * @details
+ *	Flushes the batch unless the expiry is stale: a batch flushed for another
+ *	reason after the timer fired, and since restarted, keeps its own timer.
+ *
+ * @param[in] *batch
+ *	Batch opened by batch_open().
+ *
+ ******************************************************************************/
+void batch_timeout(BATCH_STRUCT *batch){
+	if(!sw_timer_active(&batch->latency_timer)) batch_flush(batch);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sends every held sample in one call of the flush function
+ *
+ * @details
+ *	Does nothing if the batch is empty.
+ *
+ * @param[in] *batch
+ *	Batch opened by batch_open().
+ *
+ ******************************************************************************/
+void batch_flush(BATCH_STRUCT *batch){
+	sw_timer_stop(&batch->latency_timer);
+	if(!batch->held) return;
+	batch->config.flush(batch->sample, batch->held);
+	batch->last_sent = batch->sample[batch->held - 1];
+	batch->sent_any = true;
+	batch->held = 0;
+}
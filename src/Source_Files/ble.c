@@ -4,7 +4,8 @@
  * @date
  * @brief Contains all the functions to interface the application with the HM-18
  *   BLE module and the LEUART driver. Uses a circular buffer to store data going
- *   out.
+ *   out. Samples can be sent as text or packed into binary frames. AT commands
+ *   configure the module without blocking, see ble_at_run().
  *
  */
 
@@ -13,6 +14,8 @@
 // Include files
 //***********************************************************************************
 #include "ble.h"
+#include "sw_timer.h"
+#include "irq.h"
 #include <string.h>
 
 //***********************************************************************************
@@ -24,23 +27,78 @@
 // private variables
 //***********************************************************************************
 
-#define CSIZE 64
+#define CIRC_TEST_SIZE		3
+#define CIRC_TEST_LEN		64
+#define CIRC_STRESS_LOOPS	2000
+#define CIRC_STRESS_SIZE	32
+#define CIRC_STRESS_WRAPS	50		// minimum number of times the stress ring wraps
 typedef struct {
-	char cbuf[CSIZE];
-	uint8_t size_mask;
-	uint32_t size;
-	uint32_t read_ptr;
-	uint32_t write_ptr;
-} BLE_CIRCULAR_BUF;
-
-#define CIRC_TEST_SIZE 3
-typedef struct {
-	char test_str[CIRC_TEST_SIZE][CSIZE];
-	char result_str[CSIZE];
+	char test_str[CIRC_TEST_SIZE][CIRC_TEST_LEN];
+	char result_str[CIRC_TEST_LEN];
 }CIRC_TEST_STRUCT;
 
 static CIRC_TEST_STRUCT		test_struct;
-static BLE_CIRCULAR_BUF		ble_cbuf;
+static uint8_t				ble_cbuf_storage[BLE_CIRC_SIZE];
+static RING_BUF_STRUCT		ble_cbuf;
+
+typedef struct {
+	uint8_t		buf[BLE_FRAME_SIZE];
+	uint32_t	len;			// bytes used, 0 when no frame is open
+	uint32_t	time;			// RTCC count of the frame's TIME field
+	uint8_t		seq;			// sequence number of the next frame
+} BLE_FRAME_STRUCT;
+
+static BLE_FRAME_STRUCT		ble_frame;
+
+typedef struct {
+	char			line[BLE_RX_LINE_MAX];	// line being received
+	uint32_t		len;
+	bool			overflow;		// longer than BLE_RX_LINE_MAX, dropped
+	uint32_t		event;			// rx_event of ble_open()
+	SW_TIMER_STRUCT	gap;			// BLE_RX_GAP_MS of silence ends the line
+} BLE_RX_STRUCT;
+
+static BLE_RX_STRUCT		ble_rx;
+static uint8_t				ble_rx_storage[BLE_RX_RING_SIZE];
+static RING_BUF_STRUCT		ble_rx_ring;
+
+// AT responses that are complete without waiting for the gap
+static const char * const ble_rx_replies[] = { "OK+CONN", "OK+LOST", "OK+RESET" };
+
+typedef enum {
+	BLE_AT_STOPPED,			// the circular buffer owns the LEUART
+	BLE_AT_DRAIN,			// waiting for the packet being sent
+	BLE_AT_GAP,				// silence before the first command
+	BLE_AT_SEND,			// command ready for ble_circ_pop()
+	BLE_AT_WAIT,			// command sent, waiting for its response
+	BLE_AT_BOOT,			// the module restarts after AT+RESET
+	BLE_AT_FALLBACK			// failed, the LEUART goes back to the rate of before the run
+} BLE_AT_STATE;
+
+typedef struct {
+	char		cmd[BLE_AT_CMD_MAX + 1];
+	char		reply[BLE_AT_CMD_MAX + 1];	// the response starts with it
+	bool		reset;			// the module restarts after the response
+	uint32_t	baud;			// LEUART rate switched to before the command, 0 to keep it
+} BLE_AT_CMD_STRUCT;
+
+typedef struct {
+	BLE_AT_CMD_STRUCT		cmd[BLE_AT_QUEUE_SIZE];
+	uint32_t				count;			// commands queued
+	uint32_t				index;			// command being run
+	volatile BLE_AT_STATE	state;
+	volatile BLE_AT_STATUS	status;
+	uint32_t				done_event;		// done_event of ble_at_run()
+	uint32_t				tx_event;		// tx_event of ble_open(), runs ble_circ_pop()
+	uint32_t				baud;			// LEUART rate
+	uint32_t				run_baud;		// LEUART rate at the start of the run
+	SW_TIMER_STRUCT			timer;			// gap, response timeout and module boot
+} BLE_AT_STRUCT;
+
+static BLE_AT_STRUCT		ble_at;
+
+// HM-10 rates by AT+BAUD code
+static const uint32_t		ble_baud_codes[] = { 9600, 19200, 38400, 57600, 115200, 4800, 2400, 1200, 230400 };
 /***************************************************************************//**
  * @brief BLE module
  * @details
@@ -56,81 +114,273 @@ static BLE_CIRCULAR_BUF		ble_cbuf;
 // Private functions
 //***********************************************************************************
 static void ble_circ_init(void);
-static void ble_circ_push(char *string);
-
-static uint8_t ble_circ_space(void);
-static void update_circ_wrtindex(BLE_CIRCULAR_BUF *index_struct, uint32_t update_by);
-static void update_circ_readindex(BLE_CIRCULAR_BUF *index_struct, uint32_t update_by);
+static bool ble_circ_push(char *string);
+static void ble_circ_wait(void);
+static bool ble_rx_byte(uint8_t data, void *ctx);
+static void ble_rx_gap(void *ctx);
+static bool ble_at_reply(void);
 
-//***********************************************************************************
-// Global functions
-//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ *	Ends a run of AT commands and hands the LEUART back to the circular buffer
+ *
+ * @details
+ *	A run that failed after switching the LEUART rate first has ble_at_step()
+ *	switch it back, the done_event is posted then.
+ *
+ * @note
+ *	Called from interrupt context with the LEUART interrupt masked.
+ *
+ ******************************************************************************/
+static void ble_at_finish(BLE_AT_STATUS status){
+	ble_at.status = status;
+	ble_at.count = 0;
+	if((status == BLE_AT_FAILED) && (ble_at.baud != ble_at.run_baud)){
+		ble_at.state = BLE_AT_FALLBACK;
+	} else {
+		ble_at.state = BLE_AT_STOPPED;
+		add_scheduled_event(ble_at.done_event);
+	}
+	add_scheduled_event(ble_at.tx_event);
+}
 
 /***************************************************************************//**
  * @brief
- *	Update Circular Buffer Write Index
+ *	The command being run is answered, moves on to the next one
  *
  * @details
- *	Updates the circular buffer write index. The write index will update by the amount
- *	given in 'update_by' and will circle around if neccesary.
+ *	The HM-10 only answers after the gap that ends the command, so the next
+ *	one can be sent at once.
+ *
+ ******************************************************************************/
+static void ble_at_next(void){
+	if(++ble_at.index >= ble_at.count){
+		ble_at_finish(BLE_AT_DONE);
+		return;
+	}
+	ble_at.state = BLE_AT_SEND;
+	add_scheduled_event(ble_at.tx_event);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Matches a received line against the response of the command being run
+ *
+ * @note
+ *	Called from ble_rx_close(). A line that does not match is left for
+ *	ble_rx_read(), the command then times out.
+ *
+ * @return
+ *	Returns true if the line was the response, it is not queued then.
+ *
+ ******************************************************************************/
+static bool ble_at_reply(void){
+	if(ble_at.state != BLE_AT_WAIT) return false;
+	BLE_AT_CMD_STRUCT *cmd = &ble_at.cmd[ble_at.index];
+	uint32_t len = strlen(cmd->reply);
+	if((ble_rx.len < len) || memcmp(ble_rx.line, cmd->reply, len)) return false;
+	if(cmd->reset){
+		ble_at.state = BLE_AT_BOOT;
+		sw_timer_start(&ble_at.timer, BLE_AT_BOOT_MS, 0);
+	} else {
+		sw_timer_stop(&ble_at.timer);
+		ble_at_next();
+	}
+	return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	The gap, the response timeout or the module boot time has elapsed
  *
  * @note
- *	Index implementation is being used rather than pointer implementation
+ *	Called from the RTCC interrupt, sw_timer_expire() masks the LEUART
+ *	interrupt around it.
+ *
+ ******************************************************************************/
+static void ble_at_timer(void *ctx){
+	switch(ble_at.state){
+		case BLE_AT_GAP:
+			ble_at.state = BLE_AT_SEND;
+			add_scheduled_event(ble_at.tx_event);
+			break;
+		case BLE_AT_WAIT:
+			ble_at_finish(BLE_AT_FAILED);
+			break;
+		case BLE_AT_BOOT:
+			ble_at_next();
+			break;
+		default:
+			break;
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true while the AT command engine waits on a timer or the HM-10
  *
- * @param[in] *index_struct
- * A pointer to the CLE_CIRCULAR_BUF struct to update
+ ******************************************************************************/
+static bool ble_at_waiting(void){
+	BLE_AT_STATE state = ble_at.state;
+	return (state == BLE_AT_GAP) || (state == BLE_AT_WAIT) || (state == BLE_AT_BOOT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Runs the part of the AT command engine that needs the idle LEUART
  *
- * @param[in] update_by
- * The integer amount to update the BLE write index by.
+ * @note
+ *	Called from ble_circ_pop() when the LEUART is not transmitting.
+ *
+ * @return
+ *	Returns true while the engine holds the LEUART, the circular buffer must
+ *	not start a packet then.
  *
  ******************************************************************************/
-void update_circ_wrtindex(BLE_CIRCULAR_BUF *index_struct, uint32_t update_by){
-	index_struct->write_ptr += update_by;
-	index_struct->write_ptr &= index_struct->size_mask;
+static bool ble_at_step(void){
+	BLE_AT_CMD_STRUCT *cmd;
+	switch(ble_at.state){
+		case BLE_AT_STOPPED:
+			return false;
+		case BLE_AT_DRAIN:
+			ble_at.state = BLE_AT_GAP;
+			sw_timer_start(&ble_at.timer, BLE_AT_GAP_MS, 0);
+			break;
+		case BLE_AT_SEND:
+			cmd = &ble_at.cmd[ble_at.index];
+			if(cmd->baud && (cmd->baud != ble_at.baud)){
+				leuart_baud_set(HM10_LEUART0, cmd->baud);		// the module has just restarted, nothing is on the line
+				ble_at.baud = cmd->baud;
+			}
+			ble_at.state = BLE_AT_WAIT;
+			sw_timer_start(&ble_at.timer, BLE_AT_TIMEOUT_MS, 0);
+			leuart_start(HM10_LEUART0, cmd->cmd, strlen(cmd->cmd));
+			break;
+		case BLE_AT_FALLBACK:
+			leuart_baud_set(HM10_LEUART0, ble_at.run_baud);
+			ble_at.baud = ble_at.run_baud;
+			ble_at.state = BLE_AT_STOPPED;
+			add_scheduled_event(ble_at.done_event);
+			return false;
+		default:
+			break;
+	}
+	return true;
 }
 
 /***************************************************************************//**
  * @brief
- *	Update Circular Buffer Read Index
+ *	Ends the line being received
  *
  * @details
- *	Updates the circular buffer read index. The read index will be updated by
- *	the amount given in 'update_by' and will circle around if neccesary.
+ *	The response of a running AT command is taken by the engine, other lines
+ *	are queued for ble_rx_read().
  *
  * @note
- *	Index implementation is used rather than pointer implementation.
+ *	Called from the LEUART interrupt, or with it masked.
+ *
+ * @return
+ *	Returns true if a line was queued for ble_rx_read().
+ *
+ ******************************************************************************/
+static bool ble_rx_close(void){
+	bool queued = ble_rx.len && !ble_rx.overflow && !ble_at_reply() && ring_buf_push(&ble_rx_ring, ble_rx.line, ble_rx.len);
+	ble_rx.len = 0;
+	ble_rx.overflow = false;
+	return queued;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Incremental parser of the bytes from the HM-10, the LEUART rx_callback
  *
- * @param[in] *index_struct
- * A pointer to the CLE_CIRCULAR_BUF struct to update
+ * @details
+ *	Not connected, the HM-10 answers AT commands without a line ending, so a
+ *	response ends with BLE_RX_GAP_MS of silence, or at its last byte for the
+ *	fixed ones in ble_rx_replies[]. Connected, the phone's command lines end
+ *	with CR or LF. Every byte restarts the gap timer, a line is only handed
+ *	to the main loop, and the core only leaves EM2 for longer than the
+ *	interrupt, once it is complete.
  *
- * @param[in] update_by
- * The integer amount to update the BLE read index by.
+ * @return
+ *	Returns true if the byte completed a line, the LEUART driver then posts
+ *	the rx_event.
  *
+ ******************************************************************************/
+static bool ble_rx_byte(uint8_t data, void *ctx){
+	if((data == '\r') || (data == '\n')){
+		sw_timer_stop(&ble_rx.gap);
+		return ble_rx_close();
+	}
+	if(ble_rx.len < BLE_RX_LINE_MAX) ble_rx.line[ble_rx.len++] = data;
+	else ble_rx.overflow = true;
+	for(uint32_t i = 0; i < sizeof(ble_rx_replies) / sizeof(ble_rx_replies[0]); i++){
+		if((ble_rx.len == strlen(ble_rx_replies[i])) && !memcmp(ble_rx.line, ble_rx_replies[i], ble_rx.len)){
+			sw_timer_stop(&ble_rx.gap);
+			return ble_rx_close();
+		}
+	}
+	sw_timer_start(&ble_rx.gap, BLE_RX_GAP_MS, 0);
+	return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	No byte for BLE_RX_GAP_MS, the line received is complete
+ *
+ * @note
+ *	Called from the RTCC interrupt, below the LEUART one.
  *
  ******************************************************************************/
-void update_circ_readindex(BLE_CIRCULAR_BUF *index_struct, uint32_t update_by){
-	index_struct->read_ptr += update_by;
-	index_struct->read_ptr &= index_struct->size_mask;
+static void ble_rx_gap(void *ctx){
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(IRQ_LEVEL_LEUART);
+	bool queued = ble_rx_close();
+	IRQ_MASK_EXIT();
+	if(queued) add_scheduled_event(ble_rx.event);
 }
 
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
 /***************************************************************************//**
  * @brief
  *	Initialize Circular Buffer
  *
  * @details
- *	Initializes all values of the private circular buffer being used for LEUART
- *	operation.
+ *	Initializes the ring buffer that holds the frames waiting to go out over
+ *	the LEUART.
  *
  * @note
- *	CSIZE variable defines the size of the buffer.
- *
+ *	BLE_CIRC_SIZE defines the size of the buffer and BLE_CIRC_POLICY what
+ *	happens when it is full.
  *
  ******************************************************************************/
 static void ble_circ_init(void){
-	ble_cbuf.read_ptr = 0;
-	ble_cbuf.write_ptr = 0;
-	ble_cbuf.size = CSIZE;
-	ble_cbuf.size_mask = CSIZE - 1;
+	ring_buf_init(&ble_cbuf, ble_cbuf_storage, BLE_CIRC_SIZE, BLE_CIRC_POLICY, ble_circ_wait);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Circular Buffer Full Wait
+ *
+ * @details
+ *	Called by the ring buffer when the BLE_CIRC_POLICY needs the consumer to
+ *	make room. Sleeps until the current LEUART transmission is done, or the
+ *	AT command engine has moved on, and then releases it and starts the next
+ *	frame.
+ *
+ * @note
+ *	Must not be reached from interrupt context.
+ *
+ ******************************************************************************/
+static void ble_circ_wait(void){
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	if(leuart_tx_busy(HM10_LEUART0) || ble_at_waiting()) enter_sleep();
+	CORE_EXIT_CRITICAL();
+	ble_circ_pop(CIRC_OPER);
 }
 
 /***************************************************************************//**
@@ -138,29 +388,27 @@ static void ble_circ_init(void){
  *	Push a packet onto the circular buffer
  *
  * @details
- *	Will push the given string onto the circular buffer and update the write
- *	index accordingly. The packet header will be the string length.
- *	Will not allow circular buffer to overflow.
+ *	Copies the given string into a reserved span of the circular buffer. The
+ *	16-bit packet header written by the ring buffer is the string length.
  *
  * @note
- * Will assert false if the circular buffer does not have enough space
+ *	When the buffer is full, BLE_CIRC_POLICY decides whether this packet or
+ *	older ones are dropped, or whether to wait for the LEUART.
  *
  * @param[in] string
  * The string to be pushed onto the circular buffer.
  *
+ * @return
+ *	Returns true if the string was queued.
+ *
  ******************************************************************************/
-static void ble_circ_push(char *string){
-	uint8_t space = ble_circ_space();
+static bool ble_circ_push(char *string){
 	uint32_t length = strlen(string);
-	if((space - length - 1) < 0) EFM_ASSERT(false);
-	uint8_t n = 0;
-	ble_cbuf.cbuf[ble_cbuf.write_ptr] = length + 1;
-	update_circ_wrtindex(&ble_cbuf, 1);
-	while(n < length){
-		ble_cbuf.cbuf[ble_cbuf.write_ptr] = string[n];
-		update_circ_wrtindex(&ble_cbuf, 1);
-		n++;
-	}
+	char *dst = ble_reserve(length);
+	if(dst == NULL) return false;
+	memcpy(dst, string, length);
+	ring_buf_commit(&ble_cbuf, length);
+	return true;
 }
 
 /***************************************************************************//**
@@ -168,14 +416,18 @@ static void ble_circ_push(char *string){
  *	Pop a packet from the circular buffer.
  *
  * @details
- *	Will get the packet length from the first read index then pull the full packet
- *	from the circular buffer. Depending on the passed variable test, the data from
- *	the circular buffer will be:
- *	-test=true -> stored in test_struce.result_str[] var
- *	-test=false -> sent to the HM18 peripheral using leuart_start
+ *	Releases the packets that the LEUART has finished sending, then takes the
+ *	next packet from the circular buffer. Depending on the passed variable test,
+ *	the data from the circular buffer will be:
+ *	-test=true -> copied into the test_struct.result_str[] var and released
+ *	-test=false -> sent to the HM18 peripheral straight from the circular
+ *	 buffer, together with the packets queued behind it up to
+ *	 LEUART_SPAN_MAX, as the segments of one leuart_start_spans()
  *
  * @note
- *	Will return true and exit if the TX SM is busy.
+ *	Will return true and exit if the TX SM is busy. The packets stay in the
+ *	circular buffer until the next pop after the LEUART is done with them.
+ *	Packets are held while the AT command engine runs.
  *
  * @param[in] test
  *	Defines what will happen with the data pulled from the circular buffer. If false,
@@ -186,31 +438,28 @@ static void ble_circ_push(char *string){
  *
  ******************************************************************************/
 bool ble_circ_pop(bool test){
-	if(leuart_tx_busy(LEUART0)) return true;
-	if(ble_circ_space() == CSIZE) return true;
-	uint8_t length = ble_cbuf.cbuf[ble_cbuf.read_ptr];
-	update_circ_readindex(&ble_cbuf, 1);
-	uint8_t n = 0;
-	char str[length + 1];
+	uint32_t length[LEUART_SPAN_MAX];
+	uint8_t *frame[LEUART_SPAN_MAX];
+	LEUART_SPAN_STRUCT span[LEUART_SPAN_MAX];
+	uint32_t count;
+	if(leuart_tx_busy(HM10_LEUART0)) return true;
+	if(ble_cbuf.peeked) ring_buf_release(&ble_cbuf); // done transmitting
+	if(!test && ble_at_step()) return true;
 	if(test == true){
-		memset(test_struct.result_str, 0 , CSIZE);
-		while( n < (length-1)){
-			test_struct.result_str[n] = ble_cbuf.cbuf[ble_cbuf.read_ptr];
-			update_circ_readindex(&ble_cbuf, 1);
-			n++;
-		}
+		if(!ring_buf_peek_frames(&ble_cbuf, frame, length, 1)) return true;
+		memset(test_struct.result_str, 0 , CIRC_TEST_LEN);
+		memcpy(test_struct.result_str, frame[0], length[0]);
+		ring_buf_release(&ble_cbuf);
 		return false;
 	}
-	else{
-		while( n < (length-1) ){
-			str[n] = ble_cbuf.cbuf[ble_cbuf.read_ptr];
-			update_circ_readindex(&ble_cbuf, 1);
-			n++;
-		}
-		str[n] = 0;
-		leuart_start(LEUART0, str, length);
-		return false;
+	count = ring_buf_peek_frames(&ble_cbuf, frame, length, LEUART_SPAN_MAX);
+	if(count == 0) return true;
+	for(uint32_t i = 0; i < count; i++){
+		span[i].src = frame[i];
+		span[i].len = length[i];
 	}
+	leuart_start_spans(HM10_LEUART0, span, count);
+	return false;
 }
 
 /***************************************************************************//**
@@ -218,8 +467,7 @@ bool ble_circ_pop(bool test){
  *	Space available on circular buffer.
  *
  * @details
- *	Will return an 8-bit unsigned integer with the amount of space remaining on
- *	the circular buffer.
+ *	Will return the amount of space in bytes remaining on the circular buffer.
  *
  * @note
  *	Uses the private circular buffer implemented. Must be initialized prior to calling
@@ -229,12 +477,42 @@ bool ble_circ_pop(bool test){
  * The amount of space available on the circular buffer.
  *
  ******************************************************************************/
-uint8_t ble_circ_space(void){
-	return (ble_cbuf.size - ((ble_cbuf.write_ptr - ble_cbuf.read_ptr) & ble_cbuf.size_mask));
+uint32_t ble_circ_space(void){
+	return ring_buf_space(&ble_cbuf);
 }
 
+/***************************************************************************//**
+ * @brief
+ *	Reserve space for a packet in the circular buffer
+ *
+ * @details
+ *	Lets a producer format a packet directly into the circular buffer instead
+ *	of building it on the stack first. The packet is sent once ble_commit() is
+ *	called.
+ *
+ * @param[in] length
+ *	The largest number of bytes the producer will write.
+ *
+ * @return
+ *	Pointer to length contiguous bytes, NULL if the packet was dropped.
+ *
+ ******************************************************************************/
+char *ble_reserve(uint32_t length){
+	return (char *)ring_buf_reserve(&ble_cbuf, length);
+}
 
-
+/***************************************************************************//**
+ * @brief
+ *	Send a packet written with ble_reserve()
+ *
+ * @param[in] length
+ *	The number of bytes written, no more than reserved.
+ *
+ ******************************************************************************/
+void ble_commit(uint32_t length){
+	ring_buf_commit(&ble_cbuf, length);
+	ble_circ_pop(CIRC_OPER);
+}
 
 /***************************************************************************//**
  * @brief
@@ -245,7 +523,9 @@ uint8_t ble_circ_space(void){
  * for proper communication witht the HM18.
  *
  * @note
- * The passed events will be called at the end of the RX/TX state machine.
+ * The passed events will be called at the end of the RX/TX state machine,
+ * rx_event once for every line ble_rx_read() can return. sw_timer_open()
+ * must have been called.
  *
  * @param[in] tx_event
  * The callback to be added at the end of TX transfer.
@@ -269,8 +549,37 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
 	leuart_settings.rx_done_evt = rx_event;
 	leuart_settings.tx_done_evt = tx_event;
 	leuart_settings.refFreq = HM10_REFFREQ;
+	leuart_settings.tx_dma_en = HM10_TX_DMA;
+	leuart_settings.rxblocken = false;
+	leuart_settings.sfubrx = false;
+	leuart_settings.startframe_en = false;		// HM-10 responses have no fixed start or end byte
+	leuart_settings.sigframe_en = false;
+	leuart_settings.rx_callback = ble_rx_byte;
+	leuart_settings.rx_ctx = NULL;
 
 	ble_circ_init();
+	ring_buf_init(&ble_rx_ring, ble_rx_storage, BLE_RX_RING_SIZE, RING_DROP_NEWEST, NULL);
+	ble_rx.len = 0;
+	ble_rx.overflow = false;
+	ble_rx.event = rx_event;
+	sw_timer_init(&ble_rx.gap, SCHEDULER_NO_EVENT, ble_rx_gap, NULL);
+	ble_at.state = BLE_AT_STOPPED;
+	ble_at.status = BLE_AT_IDLE;
+	ble_at.count = 0;
+	ble_at.tx_event = tx_event;
+	ble_at.baud = HM10_BAUDRATE;
+	sw_timer_init(&ble_at.timer, SCHEDULER_NO_EVENT, ble_at_timer, NULL);
+	ble_frame.len = 0;
+	ble_frame.seq = 0;
+
+#if BLE_FRAMING == BLE_FRAME_BINARY
+	GPCRC_Init_TypeDef crc_init = GPCRC_INIT_DEFAULT;
+	crc_init.crcPoly = 0x1021;
+	crc_init.initValue = 0xFFFF;
+	crc_init.enableByteMode = true;
+	CMU_ClockEnable(cmuClock_GPCRC, true);
+	GPCRC_Init(GPCRC, &crc_init);
+#endif
 
 	leuart_open(HM10_LEUART0, &leuart_settings);
 }
@@ -292,214 +601,343 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
  *
  ******************************************************************************/
 void ble_write(char* string){
-	ble_circ_push(string);
-	ble_circ_pop(CIRC_OPER);
+	if(ble_circ_push(string)) ble_circ_pop(CIRC_OPER);
 }
 
 /***************************************************************************//**
  * @brief
- *   BLE Test performs two functions.  First, it is a Test Driven Development
- *   routine to verify that the LEUART is correctly configured to communicate
- *   with the BLE HM-18 module.  Second, the input argument passed to this
- *   function will be written into the BLE module and become the new name
- *   advertised by the module while it is looking to pair.
+ *	Takes the oldest line received from the HM-10
  *
  * @details
- * 	 This global function will use polling functions provided by the LEUART
- * 	 driver for both transmit and receive to validate communications with
- * 	 the HM-18 BLE module.  For the assignment, the communication with the
- * 	 BLE module must use low energy design principles of being an interrupt
- * 	 driven state machine.
+ *	An AT response or a command line from the phone, without its line
+ *	ending. Lines are queued from interrupt context until they are read,
+ *	when the queue is full new ones are dropped.
  *
  * @note
- *   For this test to run to completion, the phone most not be paired with
- *   the BLE module.  In addition for the name to be stored into the module
- *   a breakpoint must be placed at the end of the test routine and stopped
- *   at this breakpoint while in the debugger for a minimum of 5 seconds.
+ *	Main loop only.
  *
- * @param[in] *mod_name
- *   The name that will be written to the HM-18 BLE module to identify it
- *   while it is advertising over Bluetooth Low Energy.
+ * @param[out] *line
+ *	Receives the line NUL terminated, a longer one is truncated.
+ *
+ * @param[in] max
+ *	Size of line, at least 1.
  *
  * @return
- *   Returns bool true if successfully passed through the tests in this
- *   function.
+ *	The length of the line, 0 if none was waiting.
+ *
  ******************************************************************************/
-bool ble_test(char *mod_name){
-	uint32_t	str_len;
+uint32_t ble_rx_read(char *line, uint32_t max){
+	uint32_t len = ring_buf_pop(&ble_rx_ring, line, max - 1);
+	if(len > max - 1) len = max - 1;
+	line[len] = 0;
+	return len;
+}
 
-	CORE_DECLARE_IRQ_STATE;
-	CORE_ENTER_CRITICAL();
+/***************************************************************************//**
+ * @brief
+ *	Adds a sample record to the open binary frame
+ *
+ * @details
+ *	The first record opens a frame stamped with its timestamp; later records
+ *	store their offset from it in 1/32 s. The frame is sent by
+ *	ble_frame_flush(), or first when the record does not fit or its offset
+ *	is out of range.
+ *
+ * @note
+ *	Main loop only. Text written with ble_write() may be interleaved between
+ *	frames; the decoder finds frames by their sync byte and CRC.
+ *
+ * @param[in] sensor
+ *	Sensor id, 0 to BLE_FRAME_MAX_SENSOR.
+ *
+ * @param[in] timestamp
+ *	RTCC count of the sample.
+ *
+ * @param[in] *values
+ *	Fixed-point values of the sample.
+ *
+ * @param[in] count
+ *	Number of values, 1 to BLE_FRAME_MAX_VALUES.
+ *
+ ******************************************************************************/
+void ble_frame_add(uint32_t sensor, uint32_t timestamp, const int16_t *values, uint32_t count){
+	EFM_ASSERT((sensor <= BLE_FRAME_MAX_SENSOR) && count && (count <= BLE_FRAME_MAX_VALUES));
+	uint32_t rec_len = 3 + 2 * count;
+	uint32_t dt = (timestamp - ble_frame.time) >> BLE_FRAME_DT_SHIFT;
 
-	// This test will limit the test to the proper setup of the LEUART
-	// peripheral, routing of the signals to the proper pins, pin
-	// configuration, and transmit/reception verification.  The test
-	// will communicate with the BLE module using polling routines
-	// instead of interrupts.
-	// How is polling different than using interrupts?
-	// ANSWER: Polling constantly checks the state of the RXDATAV register
-	//		   to see if data is available. This uses lots of energy. Interrupts
-	//		   only pull the data when it's available, so not constantly checking.
-	// How does interrupts benefit the system for low energy operation?
-	// ANSWER: As said above, interrupts make it so the system is only on and pulling
-	// 		   data from the RXDATA register when there is data available. Otherwise,
-	//		   the module is in the lowest non-blocked energy mode.
-	// How does interrupts benefit the system that has multiple tasks?
-	// ANSWER: Interrupts benefit in a system with multiple tasks because processes
-	//		   will only be ran when the tasks are ready to be dealt with. This causes the
-	//		   energy consumption and overall processsing overhead to go down.
-
-	// First, you will need to review the DSD HM10 datasheet to determine
-	// what the default strings to write data to the BLE module and the
-	// expected return statement from the BLE module to test / verify the
-	// correct response
-
-	// The test_str is used to tell the BLE module to end a Bluetooth connection
-	// such as with your phone.  The ok_str is the result sent from the BLE module
-	// to the micro-controller if there was not active BLE connection at the time
-	// the break command was sent to the BLE module.
-	// Replace the test_str "" with the command to break or end a BLE connection
-	// Replace the ok_str "" with the result that will be returned from the BLE
-	//   module if there was no BLE connection
-	char		test_str[80] = "AT";
-	char		ok_str[80] = "OK";
-
-
-	// output_str will be the string that will program a name to the BLE module.
-	// From the DSD HM10 datasheet, what is the command to program a name into
-	// the BLE module?
-	// ANSWER: "AT+NAME<nameString>"
-	// The  output_str will be a string concatenation of the DSD HM10 command
-	// and the input argument sent to the ble_test() function
-	// Replace the output_str "" with the command to change the program name
-	// Replace the result_str "" with the first part of the expected result
-	//  the backend of the expected response will be concatenated with the
-	//  input argument
-	char		output_str[80] = "AT+NAME";
-	char		result_str[80] = "OK+Set:";
-
-
-	// To program the name into your module, you must reset the module after you
-	// have sent the command to update the modules name.  What is the DSD HM10
-	// name to reset the module?
-	// ANSWER: "AT+RESET"
-	// Replace the reset_str "" with the command to reset the module
-	// Replace the reset_result_str "" with the expected BLE module response to
-	//  to the reset command
-	char		reset_str[80] = "AT+RESET";
-	char		reset_result_str[80] = "OK+RESET";
-	char		return_str[80];
-
-	bool		success;
-	bool		rx_disabled, rx_en, tx_en;
-	uint32_t	status;
-
-	// These are the routines that will build up the entire command and response
-	// of programming the name into the BLE module.  Concatenating the command or
-	// response with the input argument name
-	strcat(output_str, mod_name);
-	strcat(result_str, mod_name);
-
-	// The test routine must not alter the function of the configuration of the
-	// LEUART driver, but requires certain functionality to insure the logical test
-	// of writing and reading to the DSD HM10 module.  The following c-lines of code
-	// save the current state of the LEUART driver that will be used later to
-	// re-instate the LEUART configuration
-
-	status = leuart_status(HM10_LEUART0);
-	if (status & LEUART_STATUS_RXBLOCK) {
-		rx_disabled = true;
-		// Enabling, unblocking, the receiving of data from the LEUART RX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKDIS);
+	if(ble_frame.len && ((ble_frame.len + rec_len + BLE_FRAME_CRC > BLE_FRAME_SIZE) || (dt > UINT16_MAX))){
+		ble_frame_flush();
 	}
-	else rx_disabled = false;
-	if (status & LEUART_STATUS_RXENS) {
-		rx_en = true;
-	} else {
-		rx_en = false;
-		// Enabling the receiving of data from the RX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXEN);
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_RXENS));
+	if(!ble_frame.len){
+		ble_frame.time = timestamp;
+		ble_frame.len = BLE_FRAME_HDR;
+		dt = 0;
 	}
 
-	if (status & LEUART_STATUS_TXENS){
-		tx_en = true;
-	} else {
-		// Enabling the transmission of data to the TX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXEN);
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_TXENS));
-		tx_en = false;
-	}
-//	leuart_cmd_write(HM10_LEUART0, (LEUART_CMD_CLEARRX | LEUART_CMD_CLEARTX));
-
-	// This sequence of instructions is sending the break ble connection
-	// to the DSD HM10 module.
-	// Why is this command required if you want to change the name of the
-	// DSD HM10 module?
-	// ANSWER: Changing the name of the module will cause issues with the communciation
-	// 		   between the HM18 and the device connected. The other device will be expecting
-	//		   the legacy name and will not be able to connect.
-	str_len = strlen(test_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, test_str[i]);
+	uint8_t *rec = &ble_frame.buf[ble_frame.len];
+	*rec++ = (sensor << 4) | count;
+	*rec++ = dt & 0xFF;
+	*rec++ = dt >> 8;
+	for(uint32_t i = 0; i < count; i++){
+		*rec++ = (uint16_t)values[i] & 0xFF;
+		*rec++ = (uint16_t)values[i] >> 8;
 	}
+	ble_frame.len += rec_len;
+}
 
-	// What will the ble module response back to this command if there is
-	// a current ble connection?
-	// ANSWER: "OK+LOST"
-	str_len = strlen(ok_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (ok_str[i] != return_str[i]) {
-				EFM_ASSERT(false);;
-		}
+/***************************************************************************//**
+ * @brief
+ *	Sends the open binary frame
+ *
+ * @details
+ *	Fills in the header, appends the GPCRC checksum of header and records and
+ *	queues the frame as one packet of the circular buffer, so it goes out in
+ *	a single LEUART transmit.
+ *
+ * @return
+ *	Returns false if the frame was dropped by the full circular buffer.
+ *
+ ******************************************************************************/
+bool ble_frame_flush(void){
+	if(!ble_frame.len) return true;
+	uint8_t *buf = ble_frame.buf;
+	uint32_t len = ble_frame.len;
+	buf[0] = BLE_FRAME_SYNC;
+	buf[1] = ble_frame.seq++;
+	buf[2] = len - BLE_FRAME_HDR;
+	buf[3] = ble_frame.time & 0xFF;
+	buf[4] = (ble_frame.time >> 8) & 0xFF;
+	buf[5] = (ble_frame.time >> 16) & 0xFF;
+	buf[6] = ble_frame.time >> 24;
+
+	GPCRC_Start(GPCRC);
+	for(uint32_t i = 0; i < len; i++) GPCRC_InputU8(GPCRC, buf[i]);
+	uint32_t crc = GPCRC_DataRead(GPCRC);
+	buf[len++] = crc & 0xFF;
+	buf[len++] = (crc >> 8) & 0xFF;
+
+	char *pkt = ble_reserve(len);
+	if(pkt){
+		memcpy(pkt, buf, len);
+		ble_commit(len);
 	}
+	ble_frame.len = 0;
+	return pkt != NULL;
+}
 
-	// This sequence of code will be writing or programming the name of
-	// the module to the DSD HM10
-	str_len = strlen(output_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, output_str[i]);
-	}
+/***************************************************************************//**
+ * @brief
+ *	Adds an AT command to the next run of the engine
+ *
+ * @details
+ *	The command is cmd followed by arg, its response must start with reply
+ *	followed by arg. AT+RESET is followed by BLE_AT_BOOT_MS in which nothing
+ *	is sent to the module.
+ *
+ * @note
+ *	Main loop only, not while a run is in progress.
+ *
+ * @param[in] *cmd
+ *	The command, "AT..."
+ *
+ * @param[in] *arg
+ *	Appended to both the command and the response, may be NULL.
+ *
+ * @param[in] *reply
+ *	The start of the expected response.
+ *
+ * @return
+ *	Returns false if the command was not queued: a run is in progress, the
+ *	queue is full or the command is longer than BLE_AT_CMD_MAX.
+ *
+ ******************************************************************************/
+bool ble_at_queue(const char *cmd, const char *arg, const char *reply){
+	if(arg == NULL) arg = "";
+	if((ble_at.state != BLE_AT_STOPPED) || (ble_at.count >= BLE_AT_QUEUE_SIZE)) return false;
+	if((strlen(cmd) + strlen(arg) > BLE_AT_CMD_MAX) || (strlen(reply) + strlen(arg) > BLE_AT_CMD_MAX)) return false;
+	BLE_AT_CMD_STRUCT *entry = &ble_at.cmd[ble_at.count++];
+	strcpy(entry->cmd, cmd);
+	strcat(entry->cmd, arg);
+	strcpy(entry->reply, reply);
+	strcat(entry->reply, arg);
+	entry->reset = !strcmp(cmd, "AT+RESET");
+	entry->baud = 0;
+	return true;
+}
 
-	// Here will be the check on the response back from the DSD HM10 on the
-	// programming of its name
-	str_len = strlen(result_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (result_str[i] != return_str[i]) {
-				EFM_ASSERT(false);;
-		}
-	}
+/***************************************************************************//**
+ * @brief
+ *	Sends the queued AT commands to the HM-10, one at a time
+ *
+ * @details
+ *	The engine takes the LEUART once the packet being sent is done and leaves
+ *	BLE_AT_GAP_MS of silence, as the module ends a command on a gap. Each
+ *	command is then sent through leuart_start() and its response matched by
+ *	the receive parser, with BLE_AT_TIMEOUT_MS to arrive. Packets written in
+ *	the meantime wait in the circular buffer. Nothing blocks, the core sleeps
+ *	between the LEUART, RTCC and scheduler events that move the engine on.
+ *
+ * @note
+ *	Main loop only. A connection is ended by the module when it receives an
+ *	AT command, queue "AT" first to end it on purpose.
+ *
+ * @param[in] done_event
+ *	Posted when the last command is answered or one times out, see
+ *	ble_at_status().
+ *
+ * @return
+ *	Returns false if nothing was queued or a run is in progress.
+ *
+ ******************************************************************************/
+bool ble_at_run(uint32_t done_event){
+	if((ble_at.state != BLE_AT_STOPPED) || !ble_at.count) return false;
+	ble_at.index = 0;
+	ble_at.run_baud = ble_at.baud;
+	ble_at.done_event = done_event;
+	ble_at.status = BLE_AT_BUSY;
+	ble_at.state = BLE_AT_DRAIN;
+	ble_circ_pop(CIRC_OPER);
+	return true;
+}
 
-	// It is now time to send the command to RESET the DSD HM10 module
-	str_len = strlen(reset_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, reset_str[i]);
-	}
+/***************************************************************************//**
+ * @brief
+ *	Result of the last run of the AT command engine
+ *
+ * @param[out] *failed
+ *	Receives the index, in queue order, of the command that timed out when
+ *	the result is BLE_AT_FAILED. May be NULL.
+ *
+ ******************************************************************************/
+BLE_AT_STATUS ble_at_status(uint32_t *failed){
+	BLE_AT_STATUS status = ble_at.status;
+	if(failed != NULL) *failed = ble_at.index;
+	return status;
+}
 
-	// After sending the command to RESET, the DSD HM10 will send a response
-	// back to the micro-controller
-	str_len = strlen(reset_result_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (reset_result_str[i] != return_str[i]) {
-				EFM_ASSERT(false);
-		}
+/***************************************************************************//**
+ * @brief
+ *	Configures the HM-10 through the AT command engine
+ *
+ * @details
+ *	"AT" first, which ends a connection, then the name, advertising interval,
+ *	TX power and baud rate that are set, then AT+RESET as the module only
+ *	applies them after a restart. A new baud rate is then verified with "AT"
+ *	after switching the LEUART while the module restarts, if it is not
+ *	answered the LEUART falls back to its previous rate. Can be called at boot
+ *	or at runtime.
+ *
+ * @param[in] *config
+ *	Settings, BLE_CONFIG_KEEP or a NULL name leaves one as it is.
+ *
+ * @param[in] done_event
+ *	Posted when the configuration has been applied or has failed, see
+ *	ble_at_status().
+ *
+ * @return
+ *	Returns false if the engine is busy, the name is too long or the HM-10
+ *	has no such baud rate.
+ *
+ ******************************************************************************/
+bool ble_config(const BLE_CONFIG_STRUCT *config, uint32_t done_event){
+	static const char hex[] = "0123456789ABCDEF";
+	char arg[2] = { 0, 0 };
+	EFM_ASSERT((config->adv_interval < 16) || (config->adv_interval == BLE_CONFIG_KEEP));
+	EFM_ASSERT((config->tx_power < 4) || (config->tx_power == BLE_CONFIG_KEEP));
+	if(ble_at.state != BLE_AT_STOPPED) return false;
+	ble_at.count = 0;
+
+	bool queued = ble_at_queue("AT", NULL, "OK");		// OK+LOST when connected
+	if(config->name != NULL){
+		queued = queued && ble_at_queue("AT+NAME", config->name, "OK+Set:");
 	}
+	if(config->adv_interval != BLE_CONFIG_KEEP){
+		arg[0] = hex[config->adv_interval];
+		queued = queued && ble_at_queue("AT+ADVI", arg, "OK+Set:");
+	}
+	if(config->tx_power != BLE_CONFIG_KEEP){
+		arg[0] = hex[config->tx_power];
+		queued = queued && ble_at_queue("AT+POWE", arg, "OK+Set:");
+	}
+	bool new_baud = config->baud && (config->baud != ble_at.baud);
+	if(new_baud){
+		uint32_t codes = sizeof(ble_baud_codes) / sizeof(ble_baud_codes[0]);
+		uint32_t code = 0;
+		while((code < codes) && (ble_baud_codes[code] != config->baud)) code++;
+		arg[0] = hex[code];
+		queued = queued && (code < codes) && ble_at_queue("AT+BAUD", arg, "OK+Set:");
+	}
+	queued = queued && ble_at_queue("AT+RESET", NULL, "OK+RESET");
+	if(queued && new_baud){
+		queued = ble_at_queue("AT", NULL, "OK");
+		ble_at.cmd[ble_at.count - 1].baud = config->baud;		// verified at the new rate
+	}
+	if(!queued){
+		ble_at.count = 0;
+		return false;
+	}
+	return ble_at_run(done_event);
+}
 
-	// After the test and programming have been completed, the original
-	// state of the LEUART must be restored
-	if (!rx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXDIS);
-	if (rx_disabled) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKEN);
-	if (!tx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXDIS);
-	leuart_if_reset(HM10_LEUART0);
-
-	success = true;
-
+/***************************************************************************//**
+ * @brief
+ *	Charge, in nC, of BLE_BAUD_PAYBACK_H hours of bursts at a rate
+ *
+ * @param[in] bits
+ *	Bits sent an hour.
+ *
+ * @param[in] baud
+ *	The rate.
+ *
+ ******************************************************************************/
+static uint64_t ble_baud_charge(uint64_t bits, uint32_t baud){
+	return BLE_BAUD_PAYBACK_H * bits * BLE_BAUD_LINE_NA / baud;
+}
 
-	CORE_EXIT_CRITICAL();
-	return success;
+/***************************************************************************//**
+ * @brief
+ *	Picks the HM-10 baud rate for bursts of a size and rate
+ *
+ * @details
+ *	Every rate the LEUART reaches within BLE_BAUD_ERROR_PCT is costed over
+ *	BLE_BAUD_PAYBACK_H hours of the bursts: the LEUART current for the time
+ *	the bursts are on the line, and for a rate change the BLE_BAUD_SWITCH_NC
+ *	of the AT run and module reset. The cheapest rate is returned, the
+ *	current one on a tie.
+ *
+ * @note
+ *	Must be called after ble_open(). Only the rates the LEUART reaches from
+ *	its LFXO clock are offered, so that it keeps running in EM2. HFCLKLE
+ *	would reach the fast rates, but holds the core in EM1 for as long as the
+ *	receive path listens: about 1 mA over EM2, thousands of times the charge
+ *	of a line kept busy all hour, so it never pays.
+ *
+ * @param[in] burst_bytes
+ *	Bytes sent per burst, a full sample batch.
+ *
+ * @param[in] bursts_per_hour
+ *	Most bursts sent in an hour.
+ *
+ * @return
+ *	The rate for ble_config(), the current one if no other is worth it.
+ *
+ ******************************************************************************/
+uint32_t ble_baud_choose(uint32_t burst_bytes, uint32_t bursts_per_hour){
+	uint64_t bits = 10ull * burst_bytes * bursts_per_hour;	// 10 bit frames
+	uint32_t best = ble_at.baud;
+	uint64_t best_nc = ble_baud_charge(bits, ble_at.baud);
+	for(uint32_t i = 0; i < sizeof(ble_baud_codes) / sizeof(ble_baud_codes[0]); i++){
+		uint64_t baud = ble_baud_codes[i];
+		uint64_t actual = leuart_baud_reachable(HM10_LEUART0, baud);
+		if(!actual || (baud == ble_at.baud)) continue;
+		if((actual * 100 > baud * (100 + BLE_BAUD_ERROR_PCT)) || (actual * 100 < baud * (100 - BLE_BAUD_ERROR_PCT))) continue;
+		uint64_t nc = BLE_BAUD_SWITCH_NC + ble_baud_charge(bits, baud);
+		if(nc < best_nc){
+			best = baud;
+			best_nc = nc;
+		}
+	}
+	return best;
 }
 
 /***************************************************************************//**
@@ -512,7 +950,9 @@ bool ble_test(char *mod_name){
  * 	 to validate that the routines can successfully identify whether there
  * 	 is space available in the circular buffer, the write and index pointers
  * 	 wrap around, and that one or more packets can be pushed and popped from
- * 	 the circular buffer.
+ * 	 the circular buffer. A second, small ring buffer is then pushed and popped
+ * 	 with varying packet lengths until its indices have wrapped many times, and
+ * 	 the drop newest / drop oldest full buffer policies are checked.
  *
  * @note
  *   If anyone of these test will fail, an EFM_ASSERT will occur.  If the
@@ -532,16 +972,16 @@ bool ble_test(char *mod_name){
 	 int test1_len = 50;
 	 int test2_len = 25;
 	 int test3_len = 5;
+	 uint32_t start;
 
-	 // Why this 0 initialize of read and write pointer?
-	 // Student Response:
-	 //	The first index of the array being used as a circular buffer is index 0;
-	 ble_cbuf.read_ptr = 0;
-	 ble_cbuf.write_ptr = 0;
+	 static uint8_t stress_storage[CIRC_STRESS_SIZE];
+	 RING_BUF_STRUCT stress;
+	 uint8_t frame[CIRC_STRESS_SIZE];
+	 uint32_t push_seq = 0, pop_seq = 0, length;
 
-	 // Why do none of these test strings contain a 0?
-	 // Student Response:
-	 //	0, or '\0' in ASCII, indicates the end of a string. This would cause the test to stop.
+	 ble_circ_init();
+
+	 // None of the test strings contain a 0 so strlen() gives the packet length
 	 for (int i = 0;i < test1_len; i++){
 		 test_struct.test_str[0][i] = i+1;
 	 }
@@ -557,108 +997,102 @@ bool ble_test(char *mod_name){
 	 }
 	 test_struct.test_str[2][test3_len] = 0;
 
-	 // What is this test validating?
-	 // Student response:
-	 // Validating that the buffer is empty (space available == total space)
-
-	 EFM_ASSERT(ble_circ_space() == CSIZE);
+	 // The buffer is empty (space available == total space)
+	 EFM_ASSERT(ble_circ_space() == BLE_CIRC_SIZE);
 
-	 // Why is there only one push to the circular buffer at this stage of the test
-	 // Student Response:
-	 // Pushing a single byte to the buffer to test that the space function works properly.
+	 // A single packet uses its header plus its aligned length
 	 ble_circ_push(&test_struct.test_str[0][0]);
+	 EFM_ASSERT(ble_circ_space() == (BLE_CIRC_SIZE - ring_buf_frame_size(test1_len)));
 
-	 // What is this test validating?
-	 // Student response:
-	 // Verifies that the space function is working properly per the last call to push a single byte.
-	 EFM_ASSERT(ble_circ_space() == (CSIZE - test1_len - 1));
-
-	 // Why is the expected buff_empty test = false?
-	 // Student Response:
-	 // There should be content in the buffer to be popped. The function returns false if popped data.
 	 buff_empty = ble_circ_pop(CIRC_TEST);
 	 EFM_ASSERT(buff_empty == false);
 	 for (int i = 0; i < test1_len; i++){
 		 EFM_ASSERT(test_struct.test_str[0][i] == test_struct.result_str[i]);
 	 }
-
-	 // What is this test validating?
-	 // Student response:
-	 // Testing that the popped string length is the same as the test string.
 	 EFM_ASSERT(strlen(test_struct.result_str) == test1_len);
+	 EFM_ASSERT(ble_circ_space() == BLE_CIRC_SIZE);
 
-	 // What is this test validating?
-	 // Student response: Validating that everything was popped and the buffer is empty.
-	 EFM_ASSERT(ble_circ_space() == CSIZE);
+	 // Move the indices close to the end of the buffer so that the second
+	 // packet cannot fit before the end and must wrap to index 0
+	 start = BLE_CIRC_SIZE - 2 * ring_buf_frame_size(test3_len);
+	 ble_cbuf.read_idx = start;
+	 ble_cbuf.write_idx = start;
 
-
-	 // What does this next push on the circular buffer test?
-	 // Student Response:
-	 // This push should cause the circular buffer to wrap around.
-	 ble_circ_push(&test_struct.test_str[1][0]);
-
-
-	 EFM_ASSERT(ble_circ_space() == (CSIZE - test2_len - 1));
-
-	 // What does this next push on the circular buffer test?
-	 // Student Response: Tests whether multiple strings can be pushed properly onto the buffer.
 	 ble_circ_push(&test_struct.test_str[2][0]);
+	 EFM_ASSERT(ble_circ_space() == (BLE_CIRC_SIZE - ring_buf_frame_size(test3_len)));
 
+	 // This push leaves a wrap marker and starts over at index 0
+	 ble_circ_push(&test_struct.test_str[1][0]);
+	 EFM_ASSERT(ble_circ_space() == (BLE_CIRC_SIZE - 2 * ring_buf_frame_size(test3_len) - ring_buf_frame_size(test2_len)));
+	 EFM_ASSERT((ble_cbuf.write_idx & ble_cbuf.size_mask) == ring_buf_frame_size(test2_len));
 
-	 EFM_ASSERT(ble_circ_space() == (CSIZE - test2_len - 1 - test3_len - 1));
-
-	 // What does this next push on the circular buffer test?
-	 // Student Response:
-	 // This isn't a push... but we're testing that the buffer is correctly wrapping.
-	 EFM_ASSERT(abs(ble_cbuf.write_ptr - ble_cbuf.read_ptr) < CSIZE);
-
-	 // Why is the expected buff_empty test = false?
-	 // Student Response:
-	 // There should be content in the buffer to be popped. The function returns false if data is popped off.
-	 buff_empty = ble_circ_pop(CIRC_TEST);
-	 EFM_ASSERT(buff_empty == false);
-	 for (int i = 0; i < test2_len; i++){
-		 EFM_ASSERT(test_struct.test_str[1][i] == test_struct.result_str[i]);
-	 }
-
-	 // What is this test validating?
-	 // Student response: making sure the length of the popped string is the same as the test string.
-	 EFM_ASSERT(strlen(test_struct.result_str) == test2_len);
-
-	 EFM_ASSERT(ble_circ_space() == (CSIZE - test3_len - 1));
-
-	 // Why is the expected buff_empty test = false?
-	 // Student Response:
-	 // We expect that there is still data on the buffer, so it should return false,
-	 // indicating that data was popped of.
+	 // Packets come back in the order they were pushed
 	 buff_empty = ble_circ_pop(CIRC_TEST);
 	 EFM_ASSERT(buff_empty == false);
 	 for (int i = 0; i < test3_len; i++){
 		 EFM_ASSERT(test_struct.test_str[2][i] == test_struct.result_str[i]);
 	 }
-
-	 // What is this test validating?
-	 // Student response: Making sure the length of the next popped string is the same as the third test.
-	 // Then making sure that the cirular buffer is empty.
 	 EFM_ASSERT(strlen(test_struct.result_str) == test3_len);
 
-	 EFM_ASSERT(ble_circ_space() == CSIZE);
-
-	 // Using these three writes and pops to the circular buffer, what other test
-	 // could we develop to better test out the circular buffer?
-	 // Student Response: We can ensure that the buffer doesn't throw any errors
-	 // when overfilling. It should just not add that data.
-
+	 buff_empty = ble_circ_pop(CIRC_TEST);
+	 EFM_ASSERT(buff_empty == false);
+	 for (int i = 0; i < test2_len; i++){
+		 EFM_ASSERT(test_struct.test_str[1][i] == test_struct.result_str[i]);
+	 }
+	 EFM_ASSERT(strlen(test_struct.result_str) == test2_len);
+	 EFM_ASSERT(ble_circ_space() == BLE_CIRC_SIZE);
 
-	 // Why is the expected buff_empty test = true?
-	 // Student Response:
-	 // We expect that the buffer is empty so nothing should have been popped off.
+	 // The buffer is empty so nothing should be popped off
 	 buff_empty = ble_circ_pop(CIRC_TEST);
 	 EFM_ASSERT(buff_empty == true);
+
+	 // Stress: varying packet lengths through a small ring until the indices
+	 // have wrapped many times, every packet must come back intact and in order
+	 ring_buf_init(&stress, stress_storage, CIRC_STRESS_SIZE, RING_DROP_NEWEST, NULL);
+	 for (int loop = 0; loop < CIRC_STRESS_LOOPS; loop++){
+		 length = (loop * 7) % (CIRC_STRESS_SIZE / 2 - RING_HDR_SIZE);
+		 for (int i = 0; i < length; i++) frame[i] = push_seq + i;
+		 if (ring_buf_push(&stress, frame, length)) push_seq++;
+		 if (loop & 1){
+			 uint8_t *data = ring_buf_peek(&stress, &length);
+			 EFM_ASSERT(data != NULL);
+			 for (int i = 0; i < length; i++){
+				 EFM_ASSERT(data[i] == (uint8_t)(pop_seq + i));
+			 }
+			 ring_buf_release(&stress);
+			 pop_seq++;
+		 }
+	 }
+	 while (!ring_buf_empty(&stress)){
+		 ring_buf_pop(&stress, frame, sizeof(frame));
+		 pop_seq++;
+	 }
+	 EFM_ASSERT(pop_seq == push_seq);
+	 EFM_ASSERT(stress.write_idx > CIRC_STRESS_WRAPS * CIRC_STRESS_SIZE);
+	 EFM_ASSERT(ring_buf_space(&stress) == CIRC_STRESS_SIZE);
+
+	 // Drop newest: the packet that does not fit is refused, the queued one survives
+	 ring_buf_init(&stress, stress_storage, CIRC_STRESS_SIZE, RING_DROP_NEWEST, NULL);
+	 frame[0] = 1;
+	 EFM_ASSERT(ring_buf_push(&stress, frame, CIRC_STRESS_SIZE / 2));
+	 frame[0] = 2;
+	 EFM_ASSERT(!ring_buf_push(&stress, frame, CIRC_STRESS_SIZE / 2));
+	 EFM_ASSERT(stress.dropped == 1);
+	 EFM_ASSERT(ring_buf_pop(&stress, frame, sizeof(frame)) == CIRC_STRESS_SIZE / 2);
+	 EFM_ASSERT(frame[0] == 1);
+
+	 // Drop oldest: the queued packet is discarded to make room for the new one
+	 ring_buf_init(&stress, stress_storage, CIRC_STRESS_SIZE, RING_DROP_OLDEST, NULL);
+	 frame[0] = 1;
+	 EFM_ASSERT(ring_buf_push(&stress, frame, CIRC_STRESS_SIZE / 2));
+	 frame[0] = 2;
+	 EFM_ASSERT(ring_buf_push(&stress, frame, CIRC_STRESS_SIZE / 2));
+	 EFM_ASSERT(stress.dropped == 1);
+	 EFM_ASSERT(ring_buf_pop(&stress, frame, sizeof(frame)) == CIRC_STRESS_SIZE / 2);
+	 EFM_ASSERT(frame[0] == 2);
+	 EFM_ASSERT(ring_buf_empty(&stress));
+
+	 ble_circ_init();
 	 ble_write("\nPassed Circular Buffer Test\n");
 
  }
-
-
-
-
@@ -66,5 +66,6 @@ void cmu_open(void){
 		/* UART Lab 5 */
 		CMU_OscillatorEnable(cmuOsc_LFXO, true, true); //enable the LFXO oscillator
 		CMU_ClockSelectSet(cmuClock_LFB, cmuSelect_LFXO); // route LFXO oscillator to LFB clock (used for LEUART0)
+		CMU_ClockSelectSet(cmuClock_LFE, cmuSelect_LFXO); // route LFXO oscillator to LFE clock (used for RTCC)
 }
 
@@ -0,0 +1,125 @@
+/**
+ * @file event_queue.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Lock free single producer, single consumer queue of fixed size event
+ * records. Lets an interrupt handler hand data to the main loop alongside the
+ * scheduler event bit, without coalescing back to back events.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "event_queue.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EVENT_QUEUE_MASK	(EVENT_QUEUE_SIZE - 1)
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Initialize an event queue
+ *
+ * @note
+ *	Must not be called while the producer can post.
+ *
+ * @param[in] *queue
+ *	The queue to initialize.
+ *
+ ******************************************************************************/
+void event_queue_init(EVENT_QUEUE_STRUCT *queue){
+	EFM_ASSERT((EVENT_QUEUE_SIZE & EVENT_QUEUE_MASK) == 0);
+	queue->head = 0;
+	queue->tail = 0;
+	queue->overflow = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Post a record and schedule its event
+ *
+ * @details
+ *	Copies the record into the next free slot, stamps it with the RTCC count
+ *	and then publishes it by advancing the head. The scheduler event is always
+ *	raised, so the consumer still runs if the record had to be dropped.
+ *
+ * @note
+ *	Only one context may post to a queue. No critical section is needed, the
+ *	producer only writes head and the consumer only writes tail.
+ *	SCHEDULER_NO_EVENT posts nothing, it is used by polled transfers.
+ *
+ * @param[in] *queue
+ *	The queue to post to.
+ *
+ * @param[in] event
+ *	The scheduler event id of the consumer.
+ *
+ * @param[in] payload
+ *	Data handed to the consumer.
+ *
+ * @return
+ *	Returns false if the queue was full and the record was dropped.
+ *
+ ******************************************************************************/
+bool event_queue_post(EVENT_QUEUE_STRUCT *queue, uint32_t event, uint32_t payload){
+	if(event == SCHEDULER_NO_EVENT) return true;
+	bool posted = false;
+	uint32_t head = queue->head;
+	if((head - queue->tail) < EVENT_QUEUE_SIZE){
+		EVENT_MSG_STRUCT *msg = &queue->msg[head & EVENT_QUEUE_MASK];
+		msg->event = event;
+		msg->timestamp = rtcc_get_count();
+		msg->payload = payload;
+		__DMB(); // record must land before the head moves
+		queue->head = head + 1;
+		posted = true;
+	} else {
+		queue->overflow++;
+	}
+	add_scheduled_event(event);
+	return posted;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Take the oldest record
+ *
+ * @details
+ *	Records are returned in the order they were posted. Call until it returns
+ *	false to drain everything posted before the scheduler event ran.
+ *
+ * @param[in] *queue
+ *	The queue to read from.
+ *
+ * @param[out] *msg
+ *	Where to copy the record.
+ *
+ * @return
+ *	Returns false if the queue was empty.
+ *
+ ******************************************************************************/
+bool event_queue_get(EVENT_QUEUE_STRUCT *queue, EVENT_MSG_STRUCT *msg){
+	uint32_t tail = queue->tail;
+	if(tail == queue->head) return false;
+	__DMB(); // read the record only after seeing the head that published it
+	*msg = queue->msg[tail & EVENT_QUEUE_MASK];
+	__DMB(); // copy must complete before the slot is handed back
+	queue->tail = tail + 1;
+	return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file fmt.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Small integer formatters that write text in place, for building BLE
+ * lines directly in the transmit buffer without the libc printf family.
+ * None of them write a terminating NUL; each returns the number of
+ * characters written.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "fmt.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Copies a string without its NUL
+ *
+ ******************************************************************************/
+uint32_t fmt_str(char *dst, const char *str){
+	uint32_t n = 0;
+	while(str[n]){
+		dst[n] = str[n];
+		n++;
+	}
+	return n;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Writes an unsigned integer in decimal
+ *
+ * @note
+ *	At most FMT_UINT_MAX_LEN characters.
+ *
+ ******************************************************************************/
+uint32_t fmt_uint(char *dst, uint32_t value){
+	char digits[FMT_UINT_MAX_LEN];
+	uint32_t n = 0;
+	do {
+		digits[n++] = '0' + (value % 10);
+		value /= 10;
+	} while(value);
+
+	for(uint32_t i = 0; i < n; i++) dst[i] = digits[n - 1 - i];
+	return n;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Writes the fraction num / den with one decimal
+ *
+ * @details
+ *	The exact fraction is rounded once to the nearest tenth, a tie to the
+ *	even tenth as printf("%.1f") does. Rounding a value already rounded to
+ *	hundredths would move 75.249 to 75.25 and then to "75.3". A zero tenth
+ *	is left out, 75 is written as "75" and 75.46 as "75.5".
+ *
+ * @note
+ *	At most FMT_TENTHS_MAX_LEN characters. The magnitude of the value must
+ *	be below 2^32 / 10 and num below 2^59.
+ *
+ * @param[in] num
+ *	Numerator of the value, unrounded.
+ *
+ * @param[in] den
+ *	Denominator of the value, not 0.
+ *
+ ******************************************************************************/
+uint32_t fmt_tenths(char *dst, int64_t num, uint32_t den){
+	uint32_t n = 0;
+	uint64_t scaled = ((num < 0) ? (uint64_t)-num : (uint64_t)num) * 10;
+	uint32_t deci = scaled / den;
+	uint32_t rem = scaled % den;
+	if((rem > den - rem) || ((rem == den - rem) && (deci & 1))) deci++;
+	if((num < 0) && deci) dst[n++] = '-';
+
+	n += fmt_uint(&dst[n], deci / 10);
+	if(deci % 10){
+		dst[n++] = '.';
+		dst[n++] = '0' + (deci % 10);
+	}
+	return n;
+}
@@ -3,7 +3,8 @@
  * @author Connor Peskin
  * @date October 16, 2020
  * @brief Driver for I2c operation. Implements interrupt-driven I2C
- * communication.
+ * communication. Every bus keeps a queue of transfer descriptors; the next
+ * transfer is started from the MSTOP interrupt of the previous one.
  *
  */
 
@@ -11,174 +12,194 @@
 // Include files
 //***********************************************************************************
 #include "i2c.h"
+#include "trace.h"
+#include "irq.h"
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-static I2C_STATE_MACHINE_STRUCT i2c_sm;
-static uint32_t	scheduled_Si7021_READ_CB;
-static uint32_t scheduled_Si7021_WRITE_CB;
+#define I2C_READ		1
+#define I2C_WRITE		0
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
+static I2C_STATE_MACHINE_STRUCT i2c_sm[I2C_BUS_COUNT];	// I2C0 and I2C1
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * 	Returns the state machine of an I2C peripheral
+ *
+ ******************************************************************************/
+static I2C_STATE_MACHINE_STRUCT *i2c_bus(I2C_TypeDef *i2c){
+	EFM_ASSERT((i2c == I2C0) || (i2c == I2C1));
+	return &i2c_sm[i2c == I2C1];
+}
 
 /***************************************************************************//**
  * @brief
- * 	ACK interrupt Handler for I2C state machine read sequence
+ * 	Puts the head transfer of a bus on the wire
  *
  * @details
- * 	Contains processes for data Read transmission for SM states INIT_SEND_ADDR,
- * 	SEND_MEASURE_TEMP_NHOLD, and SEND_RPT_START_ADDR.
- * 	This will transmit device_addr and command from private I2C_STATE_MACHINE_STRUCT
- * 	struct.
+ * 	Sends START with the slave address. The address goes out with the write
+ * 	bit unless the transfer has no write phase.
  *
  * @note
- *	If this interrupt handler is entered from states READ_MS_BYTE, READ_LS, or
- *	STOP_END, a false assert will be called
+ * 	Called with the bus idle, from i2c_submit() or the MSTOP interrupt.
  *
  ******************************************************************************/
-static void ack_int(){
-	if(i2c_sm->readWrite == true){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR_R:
-				i2c_sm.i2c->TXDATA = i2c_sm.command;
-				i2c_sm.current_state = SEND_MEASURE_TEMP_NHOLD;
-				break;
-			case SEND_CMD_R:
-				i2c_sm.i2c->CMD = I2C_CMD_START;
-				i2c_sm.readWrite = true;
-				i2c_sm.i2c->TXDATA = (i2c_sm.command << 1) | i2c_sm.readWrite;
-				i2c_sm.current_state = SEND_RPT_START_ADDR;
-				break;
-			case QUERY_READY:
-				i2c_sm.current_state = READ_MS_BYTE;
-				i2c_sm.i2c->IEN |= I2C_IEN_RXDATAV;//rxdatav interrupt
-				break;
-			case READ_DATA:
-				EFM_ASSERT(false); // shouldn't be here
-				break;
-			case STOP_END:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			default:
-				EFM_ASSERT(false);
-		}	
-	}
-	if(i2c_sm->readWrite == false){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR_W:
-				break;
-			case SEND_CMD_W:
-				break;
-			case SEND_DATA:
-				break;
-			case WAIT_COMPLETE:
-				break;
-			case STOP_END:
-				break;
-			default:
-				EFM_ASSERT(false);
-		}
+static void i2c_xfer_begin(I2C_STATE_MACHINE_STRUCT *sm){
+	I2C_XFER_STRUCT *xfer = sm->head;
+	xfer->status = I2C_XFER_BUSY;
+	sm->bytesDone = 0;
+	sm->nacked = false;
+	if(xfer->tx_len){
+		sm->current_state = I2C_ADDR_W;
+		sm->i2c->TXDATA = (xfer->addr << 1) | I2C_WRITE;
+	} else {
+		sm->current_state = I2C_ADDR_R;
+		sm->i2c->TXDATA = (xfer->addr << 1) | I2C_READ;
 	}
-	
+	sm->i2c->CMD = I2C_CMD_START; // send start command, will also transmit address
 }
 
 /***************************************************************************//**
  * @brief
- * 	NACK interrupt Handler for I2C state machine read sequence
+ * 	Ends the transfer on the bus with a STOP
+ *
+ ******************************************************************************/
+static void i2c_xfer_stop(I2C_STATE_MACHINE_STRUCT *sm){
+	sm->i2c->CMD = I2C_CMD_STOP;
+	sm->current_state = I2C_STOP;
+}
+
+/***************************************************************************//**
+ * @brief
+ * 	ACK interrupt Handler for I2C state machine
  *
  * @details
- * 	Contains processes for data Read transmission for only the SM state called
- * 	SEND_RPT_START_ADDR.
- * 	Will transmit device_addr from private I2C_STATE_MACHINE_STRUCT struct.
+ * 	After the write address or a data byte the next write byte is sent. Once
+ * 	the write phase is done the read phase is started with a repeated START,
+ * 	or the transfer is stopped if there is nothing to read. An ACK of the read
+ * 	address starts the reception.
  *
  * @note
- *	If this interrupt handler is entered from any state other than
- *	SEND_RPT_START_ADDR, a false assert statement will be called.
+ *	If this interrupt handler is entered from states I2C_IDLE, I2C_RX, or
+ *	I2C_STOP, a false assert will be called
  *
  ******************************************************************************/
-static void nack_int() {
-	if(i2c_sm->readWrite == true){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case SEND_CMD_R:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case QUERY_READY:  //only state the SM should be in when receive NACK
-				i2c_sm.i2c->CMD = I2C_CMD_START;
-				i2c_sm.readWrite = true;
-				i2c_sm.i2c->TXDATA = (i2c_sm.device_addr << 1) | i2c_sm.readWrite;
-				break;
-			case READ_DATA:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case STOP_END:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			default:
-				EFM_ASSERT(false);
-		}	
-	}
-	if(i2c_sm->readWrite == false){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR_W:
-				break;
-			case SEND_CMD_W:
-				break;
-			case SEND_DATA:
-				break;
-			case WAIT_COMPLETE:
-				break;
-			case STOP_END:
-				break;
-			default:
-				EFM_ASSERT(false);
-		}
+static void ack_int(I2C_STATE_MACHINE_STRUCT *sm){
+	I2C_XFER_STRUCT *xfer = sm->head;
+	switch(sm->current_state){
+		case I2C_ADDR_W:
+		case I2C_TX:
+			if(sm->bytesDone < xfer->tx_len){
+				sm->i2c->TXDATA = xfer->tx[sm->bytesDone++];
+				sm->current_state = I2C_TX;
+			} else if(xfer->rx_len){
+				sm->bytesDone = 0;
+				sm->i2c->CMD = I2C_CMD_START;
+				sm->i2c->TXDATA = (xfer->addr << 1) | I2C_READ;
+				sm->current_state = I2C_ADDR_R;
+			} else {
+				i2c_xfer_stop(sm);
+			}
+			break;
+		case I2C_ADDR_R:
+			sm->current_state = I2C_RX;
+			sm->i2c->IEN |= I2C_IEN_RXDATAV;//rxdatav interrupt
+			break;
+		case I2C_IDLE:
+		case I2C_RX:
+		case I2C_STOP:
+			EFM_ASSERT(false); //shouldn't be here
+			break;
+		default:
+			EFM_ASSERT(false);
 	}
 }
 
 /***************************************************************************//**
  * @brief
- * 	RXDATAV interrupt Handler for I2C state machine read sequence
+ * 	NACK interrupt Handler for I2C state machine
  *
  * @details
- * 	Contains processes for data Read transmission for SM states READ_MS_BYTE,
- * 	and READ_LS_BYTE.
- * 	Will store the data from the RXDATA buffer into the pointer from the
- * 	I2C_STATE_MACHINE_STRUCT, *readData. It stores MS byte first.
+ * 	A transfer flagged I2C_XFER_RETRY_NACK re-sends START and the read address
+ * 	while the slave NACKs it, this is how the Si7021 reports that a no hold
+ * 	conversion is still running. After nack_max retries the slave is taken
+ * 	to be gone, so a dead device cannot hold the bus. That NACK and any
+ * 	other stop the transfer, which completes with I2C_XFER_NACK once the
+ * 	STOP is on the bus.
  *
  * @note
- *	If this interrupt handler is entered from any state other than READ_MS_BYTE
- *	or READ_LS, a false assert statement will be called.
+ *	If this interrupt handler is entered from states I2C_IDLE, I2C_RX, or
+ *	I2C_STOP, a false assert will be called
  *
  ******************************************************************************/
-static void rxdatav_int(){
-	switch(i2c_sm.current_state){
-		case INIT_SEND_ADDR:
-			EFM_ASSERT(false); //shouldn't be here
+static void nack_int(I2C_STATE_MACHINE_STRUCT *sm) {
+	I2C_XFER_STRUCT *xfer = sm->head;
+	switch(sm->current_state){
+		case I2C_ADDR_R:
+			if((xfer->flags & I2C_XFER_RETRY_NACK) && (xfer->nacks < xfer->nack_max)){
+				xfer->nacks++;
+				sm->i2c->CMD = I2C_CMD_START;
+				sm->i2c->TXDATA = (xfer->addr << 1) | I2C_READ;
+				break;
+			}
+			sm->nacked = true;
+			i2c_xfer_stop(sm);
 			break;
-		case SEND_MEASURE_TEMP_NHOLD:
-			EFM_ASSERT(false); //shouldn't be here
+		case I2C_ADDR_W:
+		case I2C_TX:
+			sm->nacked = true;
+			i2c_xfer_stop(sm);
 			break;
-		case SEND_RPT_START_ADDR:
+		case I2C_IDLE:
+		case I2C_RX:
+		case I2C_STOP:
 			EFM_ASSERT(false); //shouldn't be here
 			break;
-		case READ_MS_BYTE:
-			*i2c_sm.readData = (i2c_sm.i2c->RXDATA << 8); // Read the MS byte from RXDATA
-			i2c_sm.i2c->CMD |= I2C_CMD_ACK; // ack to confirm it has been read
-			i2c_sm.current_state = READ_LS;
-			break;
-		case READ_LS:
-			*i2c_sm.readData |= (i2c_sm.i2c->RXDATA); // receive LS byte into shifted readData variable
-			i2c_sm.i2c->CMD |= I2C_CMD_NACK;
-			i2c_sm.i2c->CMD = I2C_CMD_STOP;
-//			i2c_bus_reset(i2c_sm.i2c);
-			i2c_sm.current_state = STOP_END;
+		default:
+			EFM_ASSERT(false);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ * 	RXDATAV interrupt Handler for I2C state machine
+ *
+ * @details
+ * 	Stores the byte from the RXDATA buffer into the rx buffer of the transfer.
+ * 	Every byte but the last is ACKed, the last one is NACKed and followed by
+ * 	a STOP.
+ *
+ * @note
+ *	If this interrupt handler is entered from any state other than I2C_RX,
+ *	a false assert statement will be called.
+ *
+ ******************************************************************************/
+static void rxdatav_int(I2C_STATE_MACHINE_STRUCT *sm){
+	I2C_XFER_STRUCT *xfer = sm->head;
+	switch(sm->current_state){
+		case I2C_RX:
+			xfer->rx[sm->bytesDone++] = sm->i2c->RXDATA;
+			if(sm->bytesDone < xfer->rx_len){
+				sm->i2c->CMD = I2C_CMD_ACK; // ack to confirm it has been read
+			} else {
+				sm->i2c->IEN &= ~I2C_IEN_RXDATAV;
+				sm->i2c->CMD = I2C_CMD_NACK;
+				i2c_xfer_stop(sm);
+			}
 			break;
-		case STOP_END:
+		case I2C_IDLE:
+		case I2C_ADDR_W:
+		case I2C_TX:
+		case I2C_ADDR_R:
+		case I2C_STOP:
 			EFM_ASSERT(false); //shouldn't be here
 			break;
 		default:
@@ -188,69 +209,79 @@ static void rxdatav_int(){
 
 /***************************************************************************//**
  * @brief
- * 	MSTOP interrupt Handler for I2C state machine read sequence
+ * 	MSTOP interrupt Handler for I2C state machine
  *
  * @details
- * 	Contains processes for data Read transmission for only SM state STOP_END.
- * 	The blocked energy mode by I2C, I2C_EM_BLOCK, will be unblocked. A scheduled
- * 	event will be added from the I2C_STATE_MACHINE_STRUCT element callback.
- * 	The I2C bus will be reset and the SMbusy variable will be set to false.
+ * 	Completes the head transfer: the first bytes read, most significant first,
+ * 	are posted to the event queue of the bus with the transfer's event, see
+ * 	i2c_get_event(), and the transfer's callback is run. The next queued
+ * 	transfer is started right away; I2C_EM_BLOCK is only unblocked once the
+ * 	queue is empty.
  *
  * @note
- *	If this interrupt handler is entered from any state other than STOP_END,
+ *	If this interrupt handler is entered from any state other than I2C_STOP,
  *	a false assert statement will be called.
  *
  ******************************************************************************/
-static void mstop_int(){
-	if(i2c_sm->readWrite == true){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case SEND_MEASURE_TEMP_NHOLD:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case SEND_RPT_START_ADDR:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case READ_MS_BYTE:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case READ_LS:
-				EFM_ASSERT(false); //shouldn't be here
-				break;
-			case STOP_END:
-				i2c_sm.SMbusy = false;
-				sleep_unblock_mode(I2C_EM_BLOCK);
-				add_scheduled_event(i2c_sm.callback);
-				i2c_sm.current_state = INIT_SEND_ADDR;
-				break;
-			default:
-				EFM_ASSERT(false);
-		}	
-	}
-	if(i2c_sm->readWrite == false){
-		switch(i2c_sm.current_state){
-			case INIT_SEND_ADDR_W:
-				break;
-			case SEND_CMD_W:
-				break;
-			case SEND_DATA:
-				break;
-			case WAIT_COMPLETE:
-				break;
-			case STOP_END:
-				break;
-			default:
-				EFM_ASSERT(false);
-		}
+static void mstop_int(I2C_STATE_MACHINE_STRUCT *sm){
+	I2C_XFER_STRUCT *xfer = sm->head;
+	uint32_t payload = 0;
+	switch(sm->current_state){
+		case I2C_STOP:
+			xfer->status = sm->nacked ? I2C_XFER_NACK : I2C_XFER_DONE;
+			for(uint32_t i = 0; (i < xfer->rx_len) && (i < sizeof(payload)); i++){
+				payload = (payload << 8) | xfer->rx[i];
+			}
+
+			sm->head = xfer->next;
+			if(sm->head) i2c_xfer_begin(sm);
+			else {
+				sm->tail = NULL;
+				sm->current_state = I2C_IDLE;
+				sleep_unblock_mode(I2C_EM_BLOCK, SLEEP_TAG_I2C);
+			}
+
+			event_queue_post(&sm->events, xfer->event, payload);
+			if(xfer->callback) xfer->callback(xfer, xfer->ctx);
+			break;
+		case I2C_IDLE:
+		case I2C_ADDR_W:
+		case I2C_TX:
+		case I2C_ADDR_R:
+		case I2C_RX:
+			EFM_ASSERT(false); //shouldn't be here
+			break;
+		default:
+			EFM_ASSERT(false);
 	}
 }
 
-//***********************************************************************************
-// Private functions
-//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ *	Common I2C interrupt handling
+ *
+ * @details
+ *	Handles the interrupts of ACK, NACK, RXDATAV, and MSTOP to implement the
+ *	STATE MACHINE of the bus.
+ *
+ ******************************************************************************/
+static void i2c_irq(I2C_STATE_MACHINE_STRUCT *sm){
+	uint32_t int_flag = sm->i2c->IF & sm->i2c->IEN;
+	sm->i2c->IFC = int_flag;
 
+	if(int_flag & I2C_IF_ACK){
+		ack_int(sm);
+	}
+	if(int_flag & I2C_IF_NACK){
+		nack_int(sm);
+	}
+	if(int_flag & I2C_IF_RXDATAV){
+		rxdatav_int(sm);
+	}
+	if(int_flag & I2C_IF_MSTOP){
+		mstop_int(sm);
+	}
+}
 
 //***********************************************************************************
 // Global functions
@@ -263,10 +294,7 @@ static void mstop_int(){
  * @details
  *	Compatible with both I2C0 and I2C1. This function will open the peripheral by
  *	enabling clocks, setting values passed by I2C_OPEN_STRUCT i2c_setup, and enabling
- *	interrupts.
- *
- * @note
- *	Interrupt implementation currently only for Read SM.
+ *	interrupts. The transfer queue of the bus starts empty.
  *
  * @param[in] I2C_TypeDef
  * I2C peripheral to initialize.
@@ -276,6 +304,7 @@ static void mstop_int(){
  *
  ******************************************************************************/
 void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup){
+	I2C_STATE_MACHINE_STRUCT *sm = i2c_bus(i2c);
 	I2C_Init_TypeDef i2c_init_values;
 	if(i2c == I2C0) CMU_ClockEnable(cmuClock_I2C0, true);
 	if(i2c == I2C1) CMU_ClockEnable(cmuClock_I2C1, true);
@@ -301,18 +330,24 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup){
     i2c->ROUTEPEN |= (I2C_ROUTEPEN_SDAPEN * i2c_setup->sda_pin_en);
 	I2C_Init(i2c, &i2c_init_values);
 
+	/* Here I turn off AUTOACK because after reading from the RX Buffer we may need to send a NACK.  */
+	i2c->CTRL &= ~I2C_CTRL_AUTOACK;
+
+	sm->i2c = i2c;
+	sm->head = NULL;
+	sm->tail = NULL;
+	event_queue_init(&sm->events);
 	i2c_bus_reset(i2c);
+
 	/* Enabling Interrupts */
 	i2c->IFC  = i2c->IF;		//clear interrupt flag register
 	i2c->IEN  = I2C_IEN_ACK;  	//ack interrupt
 	i2c->IEN |= I2C_IEN_NACK;	//nack interrupt
 	i2c->IEN |= I2C_IEN_MSTOP;  //mstop interrupt
 
-	scheduled_Si7021_READ_CB = I2C_7021_READ_CB;
-	scheduled_Si7021_WRITE_CB = I2C_7021_WRITE_CB;
-
-	if(i2c == I2C0) NVIC_EnableIRQ(I2C0_IRQn);
-	if(i2c == I2C1) NVIC_EnableIRQ(I2C1_IRQn);
+	IRQn_Type irq = (i2c == I2C0) ? I2C0_IRQn : I2C1_IRQn;
+	irq_priority_set(irq);
+	NVIC_EnableIRQ(irq);
 }
 
 /***************************************************************************//**
@@ -332,6 +367,7 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup){
  *
  ******************************************************************************/
 void i2c_bus_reset(I2C_TypeDef *i2c){
+	EFM_ASSERT(i2c_bus(i2c)->head == NULL);
 	// save IEN state and disable during bus reset operation
 	uint32_t IENstate;
 	IENstate = i2c->IEN;
@@ -349,8 +385,7 @@ void i2c_bus_reset(I2C_TypeDef *i2c){
 	i2c->CMD = I2C_CMD_ABORT;
 
 	// reset I2C state machine
-	i2c_sm.SMbusy = false;
-	i2c_sm.current_state = 0; // reset to first state. 0- first due to enum
+	i2c_bus(i2c)->current_state = I2C_IDLE;
 
 	// clear IF and re-enable IEN state
 	i2c->IFC = i2c->IF & ~I2C_IF_MSTOP;
@@ -360,129 +395,173 @@ void i2c_bus_reset(I2C_TypeDef *i2c){
 
 /***************************************************************************//**
  * @brief
- *	Start an I2C Read/Write Transmission
+ *	Fills in an I2C transfer descriptor
  *
  * @details
- *	This function will begin a Master mode transmission initialize the state
- *	machine to the initial value, block the I2C_EM_BLOCK energy mode, and transfer
- *	the slave address with the read/write bit set by input variable readWrite.
- *
- * @note
- *	I2C_TypeDef The I2C START command will be sent in this function.
- *
- * @param[in] I2C_TypeDef
- *	The desired I2C peripheral to use.
+ *	Write only, read only and write-then-read (repeated START) transfers of
+ *	any length are described by leaving the unused phase empty. Flags, event
+ *	and callback default to none and nack_max to I2C_XFER_NACK_MAX, all can
+ *	be set before submitting.
  *
- * @param[in] uint32_t
- *	The 7 bit address of the desired SLAVE device *
+ * @param[in] *xfer
+ *	Descriptor owned by the caller.
  *
- * @param[in] uint32_t
- *	A pointer to where the transmission data will be stored.
+ * @param[in] addr
+ *	The 7 bit address of the desired SLAVE device
  *
- * @param[in] uint32_t
- *	The number of bytes to be transmitted.
+ * @param[in] *tx
+ *	Bytes written first, may be NULL if tx_len is 0.
  *
- * @param[in] uint32_t
- *	The command to be transferred to the target device
+ * @param[in] tx_len
+ *	Number of bytes to write.
  *
- * @param[in] bool
- *	A boolean variable indicating read/Write operation. 1-Read, 0- Write
+ * @param[in] *rx
+ *	Where the bytes read are stored, may be NULL if rx_len is 0.
  *
- * @param[in] uint32_t
- *	The callback event bit for the scheduler and to be used in the main.c while(1)
- *	loop.
+ * @param[in] rx_len
+ *	Number of bytes to read.
  *
  ******************************************************************************/
-void i2c_start(I2C_TypeDef *i2c, uint32_t slaveAddr, uint32_t *data, uint32_t numBytes, uint32_t command, bool readWrite, uint32_t	cb_event){
-	EFM_ASSERT((i2c->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE); //make sure i2c is ready
-	sleep_block_mode(I2C_EM_BLOCK); //make sure it doesn't go into the lowest available sleep state
-	/* initialize the state machine struct */
-	i2c_sm.current_state = 0; //this is a start function, so first state
-	i2c_sm.device_addr = slaveAddr;
-	i2c_sm.i2c = i2c;
-	i2c_sm.command = command;
-	i2c_sm.readWrite = readWrite;
-	i2c_sm.readData = data;
-	i2c_sm.numBytes = numBytes;
-	i2c_sm.bytesDone = 0; //no bytes have been sent/recieved so far
-	i2c_sm.SMbusy = true;
-	i2c_sm.callback = cb_event;
-	/* Here I turn off AUTOACK because after reading from the RX Buffer we may need to send a NACK.  */
-	i2c_sm.i2c->CTRL &= ~I2C_CTRL_AUTOACK;
-
-	i2c_sm.i2c->TXDATA = (slaveAddr << 1) | readWrite; // populate the txbus with the address to move forward with SM operation
-	i2c_sm.i2c->CMD = I2C_CMD_START; // send start command, will also transmit address
+void i2c_xfer_init(I2C_XFER_STRUCT *xfer, uint32_t addr, const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len){
+	EFM_ASSERT(tx_len || rx_len);
+	xfer->next = NULL;
+	xfer->addr = addr;
+	xfer->tx = tx;
+	xfer->tx_len = tx_len;
+	xfer->rx = rx;
+	xfer->rx_len = rx_len;
+	xfer->flags = 0;
+	xfer->event = SCHEDULER_NO_EVENT;
+	xfer->callback = NULL;
+	xfer->ctx = NULL;
+	xfer->nacks = 0;
+	xfer->nack_max = I2C_XFER_NACK_MAX;
+	xfer->status = I2C_XFER_IDLE;
 }
 
 /***************************************************************************//**
  * @brief
- *	I2C0 IRQ Handler
+ *	Queue a transfer on an I2C bus
  *
  * @details
- *	Handles the interrupts of ACK, NACK, MSTOP, and RXDATAV to implement the
- *	STATE MACHINE in operation
+ *	The transfer starts at once if the bus is idle, otherwise when the
+ *	transfers queued before it have completed. I2C_EM_BLOCK is blocked while
+ *	the bus has work.
  *
  * @note
- *	Currently only implemented for Read SM operation.
+ *	The descriptor and its buffers must stay valid until the transfer
+ *	completes. Callable from interrupt context, including a completion
+ *	callback.
+ *
+ * @param[in] *i2c
+ *	The desired I2C peripheral to use.
+ *
+ * @param[in] *xfer
+ *	Descriptor set up by i2c_xfer_init().
  *
  ******************************************************************************/
-void I2C0_IRQHandler(void){
-	uint32_t int_flag = I2C0->IF & I2C0->IEN;
-	I2C0->IFC = int_flag;
+void i2c_submit(I2C_TypeDef *i2c, I2C_XFER_STRUCT *xfer){
+	I2C_STATE_MACHINE_STRUCT *sm = i2c_bus(i2c);
+	EFM_ASSERT(!i2c_xfer_pending(xfer));
+	xfer->next = NULL;
+	xfer->nacks = 0;
+	xfer->status = I2C_XFER_QUEUED;
 
-	if(int_flag & I2C_IF_ACK){
-		ack_int();
-	}
-	if(int_flag & I2C_IF_NACK){
-		nack_int();
-	}
-	if(int_flag & I2C_IF_MSTOP){
-		mstop_int();
-	}
-	if(int_flag & I2C_IF_RXDATAV){
-		rxdatav_int();
-	}
-	if(int_flag & I2C_IF_TXBL){
-		txbl_int(); //TODO
-	}
-	if(int_flag & I2C_IF_TXC){
-		txc_int(); //TODO
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(IRQ_LEVEL_I2C);
+	if(sm->head){
+		sm->tail->next = xfer;
+		sm->tail = xfer;
+	} else {
+		EFM_ASSERT((i2c->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE); //make sure i2c is ready
+		sleep_block_mode(I2C_EM_BLOCK, SLEEP_TAG_I2C); //make sure it doesn't go into the lowest available sleep state
+		sm->head = xfer;
+		sm->tail = xfer;
+		i2c_xfer_begin(sm);
 	}
-
+	IRQ_MASK_EXIT();
 }
 
 /***************************************************************************//**
  * @brief
- *	I2C1 IRQ Handler
+ *	Returns true while a transfer is queued or on the bus
  *
- * @details
- *	Handles the interrupts of ACK, NACK, MSTOP, and RXDATAV to implement the
- *	STATE MACHINE in operation
+ ******************************************************************************/
+bool i2c_xfer_pending(I2C_XFER_STRUCT *xfer){
+	return (xfer->status == I2C_XFER_QUEUED) || (xfer->status == I2C_XFER_BUSY);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sleeps until a transfer has completed
  *
  * @note
- *	Currently only implemented for Read SM operation.
+ *	The bus holds I2C_EM_BLOCK, so the wait is spent in EM1. Must not be
+ *	called from interrupt context.
  *
  ******************************************************************************/
-void I2C1_IRQHandler(void){
-	uint32_t int_flag = I2C1->IF & I2C1->IEN;
-	I2C1->IFC = int_flag;
-
-	if(int_flag & I2C_IF_ACK){
-		ack_int();
-	}
-	if(int_flag & I2C_IF_NACK){
-		nack_int();
-	}
-	if(int_flag & I2C_IF_MSTOP){
-		mstop_int();
-	}
-	if(int_flag & I2C_IF_RXDATAV){
-		rxdatav_int();
+void i2c_wait(I2C_XFER_STRUCT *xfer){
+	CORE_DECLARE_IRQ_STATE;
+	while(i2c_xfer_pending(xfer)){
+		CORE_ENTER_CRITICAL();
+		if(i2c_xfer_pending(xfer)) enter_sleep(); // the I2C interrupt wakes the core even with interrupts masked
+		CORE_EXIT_CRITICAL();
 	}
+}
 
+/***************************************************************************//**
+ * @brief
+ *	I2C0 IRQ Handler
+ *
+ ******************************************************************************/
+void I2C0_IRQHandler(void){
+	TRACE_ENTER();
+	i2c_irq(&i2c_sm[0]);
+	TRACE_EXIT(TRACE_ISR_I2C0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	I2C1 IRQ Handler
+ *
+ ******************************************************************************/
+void I2C1_IRQHandler(void){
+	TRACE_ENTER();
+	i2c_irq(&i2c_sm[1]);
+	TRACE_EXIT(TRACE_ISR_I2C1);
 }
 
+/***************************************************************************//**
+ * @brief
+ *	Returns true while the bus has a transfer queued or in flight
+ *
+ ******************************************************************************/
 bool i2c_sm_busy(I2C_TypeDef *i2c){
-	if(i2c == i2c_sm.i2c) return i2c_sm.SMbusy;
-	return false;
+	return i2c_bus(i2c)->head != NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Take the oldest completed transfer of an I2C bus
+ *
+ * @details
+ *	Every transfer submitted with an event posts one record when it
+ *	completes. The payload holds up to the first four bytes read, most
+ *	significant first; the timestamp is the RTCC count at the STOP condition.
+ *
+ * @note
+ *	Should be called from the callback event handler until it returns false.
+ *
+ * @param[in] *i2c
+ *	The I2C peripheral the transfer was started on.
+ *
+ * @param[out] *msg
+ *	Where to copy the record.
+ *
+ * @return
+ *	Returns false once no record is left.
+ *
+ ******************************************************************************/
+bool i2c_get_event(I2C_TypeDef *i2c, EVENT_MSG_STRUCT *msg){
+	return event_queue_get(&i2c_bus(i2c)->events, msg);
 }
@@ -0,0 +1,128 @@
+/**
+ * @file irq.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief NVIC priority plan and BASEPRI critical sections
+ *
+ * Every interrupt the drivers enable has its preemption level and
+ * sub-priority in irq_plan[], each driver's *_open() applies it with
+ * irq_priority_set() before NVIC_EnableIRQ(). The LEUART preempts the I2C,
+ * both preempt the LETIMER and RTCC tick.
+ *
+ * Data shared only with interrupts of a level and below is protected with
+ * IRQ_MASK_ENTER(level), the interrupts above it keep running. Waits that
+ * sleep keep CORE_ENTER_CRITICAL(), WFI does not wake for an interrupt that
+ * BASEPRI masks.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "irq.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const struct {
+	IRQn_Type	irq;
+	uint8_t		level;
+	uint8_t		sub;
+} irq_plan[] = {
+	{ LEUART0_IRQn,		IRQ_LEVEL_LEUART,	0 },
+#if LEUART_COUNT > 1
+	{ LEUART1_IRQn,		IRQ_LEVEL_LEUART,	1 },
+#endif
+	{ I2C0_IRQn,		IRQ_LEVEL_I2C,		0 },	// the Si7021 bus
+	{ I2C1_IRQn,		IRQ_LEVEL_I2C,		1 },
+	{ LDMA_IRQn,		IRQ_LEVEL_LDMA,		1 },	// errors only
+	{ RTCC_IRQn,		IRQ_LEVEL_TICK,		0 },	// software timer deadlines
+	{ LETIMER0_IRQn,	IRQ_LEVEL_TICK,		1 },
+#if LETIMER_COUNT > 1
+	{ LETIMER1_IRQn,	IRQ_LEVEL_TICK,		1 },
+#endif
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Splits the NVIC priority field into the levels of the plan
+ *
+ * @note
+ *	Must be called before any driver is opened.
+ *
+ ******************************************************************************/
+void irq_open(void){
+	NVIC_SetPriorityGrouping(IRQ_PRIGROUP);
+	__set_BASEPRI(0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the NVIC priority of an interrupt in the plan
+ *
+ * @details
+ *	For the emlib init structures that take a priority, LDMA_Init() sets and
+ *	enables the LDMA interrupt itself.
+ *
+ ******************************************************************************/
+uint32_t irq_priority(IRQn_Type irq){
+	for(uint32_t i = 0; i < sizeof(irq_plan) / sizeof(irq_plan[0]); i++){
+		if(irq_plan[i].irq == irq) return NVIC_EncodePriority(IRQ_PRIGROUP, irq_plan[i].level, irq_plan[i].sub);
+	}
+	EFM_ASSERT(false);		// every interrupt the drivers enable needs a place in the plan
+	return NVIC_EncodePriority(IRQ_PRIGROUP, IRQ_LEVELS - 1, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sets the NVIC priority of an interrupt from the plan
+ *
+ ******************************************************************************/
+void irq_priority_set(IRQn_Type irq){
+	NVIC_SetPriority(irq, irq_priority(irq));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Masks the interrupts of a level and below, through IRQ_MASK_ENTER()
+ *
+ * @details
+ *	BASEPRI_MAX only raises the mask, so a section nested in a stricter one,
+ *	or running in an interrupt of the level, leaves it as it is.
+ *
+ * @param[in] level
+ *	IRQ_LEVEL_x, 1 to IRQ_LEVELS - 1. Level 0 can only be masked with PRIMASK.
+ *
+ * @return
+ *	The previous BASEPRI for irq_mask_exit().
+ *
+ ******************************************************************************/
+uint32_t irq_mask_enter(uint32_t level){
+	EFM_ASSERT((level > 0) && (level < IRQ_LEVELS));
+	uint32_t state = __get_BASEPRI();
+	__set_BASEPRI_MAX(IRQ_MASK_BASEPRI(level));
+	return state;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Restores the mask of before irq_mask_enter(), through IRQ_MASK_EXIT()
+ *
+ ******************************************************************************/
+void irq_mask_exit(uint32_t state){
+	__set_BASEPRI(state);
+}
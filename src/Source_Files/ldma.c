@@ -0,0 +1,161 @@
+/**
+ * @file ldma.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Thin driver over the emlib LDMA functions used to move peripheral
+ * data without waking the CPU for every byte.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "ldma.h"
+#include "trace.h"
+#include "irq.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LDMA_CHANNELS		8		// number of LDMA channels on the EFM32PG12
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static LDMA_Descriptor_t	ldma_desc[LDMA_CHANNELS][LDMA_SPAN_MAX];
+static LDMA_TransferCfg_t	ldma_cfg[LDMA_CHANNELS];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the TXBL request signal of an LEUART
+ *
+ ******************************************************************************/
+static LDMA_PeripheralSignal_t ldma_leuart_txbl(LEUART_TypeDef *leuart){
+#if LEUART_COUNT > 1
+	if(leuart == LEUART1) return ldmaPeripheralSignal_LEUART1_TXBL;
+#endif
+	EFM_ASSERT(leuart == LEUART0);
+	return ldmaPeripheralSignal_LEUART0_TXBL;
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	LDMA Init/Open Function
+ *
+ * @details
+ *	Initializes the LDMA controller with the emlib defaults and the priority
+ *	of the LDMA IRQ in the plan of irq.c. LDMA_Init() will enable the LDMA
+ *	clock and the LDMA IRQ in the NVIC.
+ *
+ * @note
+ *	Must be called before any driver requests an LDMA transfer.
+ *
+ ******************************************************************************/
+void ldma_open(void){
+	LDMA_Init_t ldma_init = LDMA_INIT_DEFAULT;
+	ldma_init.ldmaInitIrqPriority = irq_priority(LDMA_IRQn);
+	LDMA_Init(&ldma_init);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Start an LDMA transfer from memory into the LEUART TXDATA register
+ *
+ * @details
+ *	Builds one memory to peripheral byte descriptor per segment, linked to the
+ *	next one, all paced by the LEUART TXBL request. The segments go out back
+ *	to back as one frame without being copied together. No descriptor sets
+ *	the DONE interrupt flag, so the transfer completes without waking the
+ *	CPU. The calling driver is expected to use the LEUART TXC interrupt to
+ *	detect the end of the frame.
+ *
+ * @note
+ *	The segments must remain valid until the transfer has completed. With
+ *	LEUART_CTRL_TXDMAWU set, the LEUART will wake the LDMA out of EM2 for each
+ *	byte without involving the CPU.
+ *
+ * @param[in] ch
+ *	The LDMA channel to use.
+ *
+ * @param[in] *leuart
+ *	The LEUART peripheral that will pace the transfer.
+ *
+ * @param[in] *spans
+ *	The segments to transmit, in order.
+ *
+ * @param[in] count
+ *	The number of segments, 1 to LDMA_SPAN_MAX.
+ *
+ ******************************************************************************/
+void ldma_leuart_tx_start(uint32_t ch, LEUART_TypeDef *leuart, const LDMA_SPAN_STRUCT *spans, uint32_t count){
+	EFM_ASSERT(ch < LDMA_CHANNELS);
+	EFM_ASSERT((count > 0) && (count <= LDMA_SPAN_MAX));
+
+	LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldma_leuart_txbl(leuart));
+	for(uint32_t i = 0; i < count; i++){
+		EFM_ASSERT((spans[i].len > 0) && (spans[i].len <= LDMA_MAX_XFER));
+		LDMA_Descriptor_t desc = LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(spans[i].src, &leuart->TXDATA, spans[i].len, 1);
+		if(i == count - 1) desc.xfer.link = 0;
+		desc.xfer.doneIfs = 0;	// completion is signaled by the LEUART TXC, not the LDMA
+		ldma_desc[ch][i] = desc;
+	}
+
+	ldma_cfg[ch] = cfg;
+	LDMA_StartTransfer(ch, &ldma_cfg[ch], &ldma_desc[ch][0]);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	LDMA Channel Done Check
+ *
+ * @details
+ *	Returns true once every byte of the last transfer on the channel has been
+ *	moved by the LDMA.
+ *
+ * @param[in] ch
+ *	The LDMA channel to check.
+ *
+ ******************************************************************************/
+bool ldma_channel_done(uint32_t ch){
+	return LDMA_TransferDone(ch);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Abort an LDMA channel
+ *
+ * @param[in] ch
+ *	The LDMA channel to stop.
+ *
+ ******************************************************************************/
+void ldma_channel_stop(uint32_t ch){
+	LDMA_StopTransfer(ch);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	LDMA IRQ Handler
+ *
+ * @details
+ *	Channel done interrupts are not used by this application, any channel flag
+ *	is cleared. An LDMA error is a fatal condition.
+ *
+ * @note
+ *	LDMA_Init() enables the LDMA error interrupt.
+ *
+ ******************************************************************************/
+void LDMA_IRQHandler(void){
+	TRACE_ENTER();
+	uint32_t int_flag = LDMA_IntGetEnabled();
+	EFM_ASSERT(!(int_flag & LDMA_IF_ERROR));
+	LDMA_IntClear(int_flag);
+	TRACE_EXIT(TRACE_ISR_LDMA);
+}
@@ -17,6 +17,8 @@
 
 //** User/developer include files
 #include "letimer.h"
+#include "trace.h"
+#include "irq.h"
 
 //***********************************************************************************
 // defined files
@@ -26,13 +28,74 @@
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
-static uint32_t scheduled_comp0_cb;
-static uint32_t scheduled_comp1_cb;
-static uint32_t scheduled_uf_cb;
+static LETIMER_HANDLE_STRUCT letimer_handles[LETIMER_COUNT];
+
+// Per instance resources, in LETIMER number order
+static const struct {
+	CMU_Clock_TypeDef	clock;
+	IRQn_Type			irq;
+} letimer_instances[LETIMER_COUNT] = {
+	{ cmuClock_LETIMER0,	LETIMER0_IRQn },
+#if LETIMER_COUNT > 1
+	{ cmuClock_LETIMER1,	LETIMER1_IRQn },
+#endif
+};
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
+static void letimer_write_comp(LETIMER_TypeDef *letimer, volatile uint32_t *comp, uint32_t value);
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of a LETIMER peripheral, the index of its handle
+ *
+ ******************************************************************************/
+static uint32_t letimer_number(LETIMER_TypeDef *letimer){
+#if LETIMER_COUNT > 1
+	if(letimer == LETIMER1) return 1;
+#endif
+	EFM_ASSERT(letimer == LETIMER0);
+	return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Common LETIMER interrupt handling
+ *
+ * @details
+ * Clears the interrupt flags of the instance and posts the events of its
+ * handle.
+ *
+ * @note
+ * Interrupts stay enabled, add_scheduled_event() is safe against preemption
+ * and the flags are read and cleared in one IFC write.
+ *
+ ******************************************************************************/
+static void letimer_irq(LETIMER_TypeDef *letimer, LETIMER_HANDLE_STRUCT *handle){
+	uint32_t int_flag;
+	int_flag = letimer->IF & letimer->IEN;
+	letimer->IFC = int_flag;
+
+	if(int_flag & LETIMER_IF_COMP0){
+		EFM_ASSERT(!(letimer->IF & LETIMER_IF_COMP0));
+		add_scheduled_event(handle->comp0_cb);
+	}
+	if(int_flag & LETIMER_IF_COMP1){
+		EFM_ASSERT(!(letimer->IF & LETIMER_IF_COMP1));
+		add_scheduled_event(handle->comp1_cb);
+	}
+	if(int_flag & LETIMER_IF_UF){
+		EFM_ASSERT(!(letimer->IF & LETIMER_IF_UF));
+		add_scheduled_event(handle->uf_cb);
+	}
+	if(int_flag & LETIMER_IF_REP0){
+		EFM_ASSERT(!(letimer->IF & LETIMER_IF_REP0));
+	}
+	if(int_flag & LETIMER_IF_REP1){
+		EFM_ASSERT(!(letimer->IF & LETIMER_IF_REP1));
+	}
+}
 
 
 //***********************************************************************************
@@ -48,7 +111,8 @@ static uint32_t scheduled_uf_cb;
  * 	 to open one of the LETIMER peripherals for PWM operation to directly drive
  * 	 GPIO output pins of the device and/or create interrupts that can be used as
  * 	 a system "heart beat" or by a scheduler to determine whether any system
- * 	 functions need to be serviced.
+ * 	 functions need to be serviced. Each LETIMER posts the events of its own
+ * 	 app_letimer_struct.
  *
  * @note
  *   This function is normally called once to initialize the peripheral and the
@@ -64,14 +128,16 @@ static uint32_t scheduled_uf_cb;
  *
  ******************************************************************************/
 void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct){
+	uint32_t number = letimer_number(letimer);
+	LETIMER_HANDLE_STRUCT *handle = &letimer_handles[number];
 	LETIMER_Init_TypeDef letimer_pwm_values;
 
 	unsigned int period_cnt;
 	unsigned int period_active_cnt;
 
 	/*  Initializing LETIMER for PWM mode */
-	/*  Enable the routed clock to the LETIMER0 peripheral */
-	CMU_ClockEnable(cmuClock_LETIMER0,true);
+	/*  Enable the routed clock to the LETIMER peripheral */
+	CMU_ClockEnable(letimer_instances[number].clock,true);
 
 	letimer_start(letimer,false);
 
@@ -120,6 +186,7 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 	 */
 	period_cnt = app_letimer_struct->period * LETIMER_HZ;
 	period_active_cnt = app_letimer_struct->active_period * LETIMER_HZ;
+	EFM_ASSERT((period_cnt <= LETIMER_MAX_CNT) && (period_active_cnt < period_cnt));
 	letimer->COMP0 = period_cnt;
 	while(letimer->SYNCBUSY);
 	letimer->COMP1 = period_active_cnt;
@@ -149,14 +216,15 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 	letimer->IEN |= LETIMER_IEN_UF * app_letimer_struct->uf_irq_enable; //set UF to desired
 
 	//callbacks
-	scheduled_comp0_cb = app_letimer_struct->comp0_cb;
-	scheduled_comp1_cb = app_letimer_struct->comp1_cb;
-	scheduled_uf_cb = app_letimer_struct->uf_cb;
+	handle->comp0_cb = app_letimer_struct->comp0_cb;
+	handle->comp1_cb = app_letimer_struct->comp1_cb;
+	handle->uf_cb = app_letimer_struct->uf_cb;
 
-	// enable interrupts for LETIMER0 to NVIC
-	NVIC_EnableIRQ(LETIMER0_IRQn); // enable interrupts to CPU via NVIC interrupt enable
+	// enable interrupts for the LETIMER to NVIC
+	irq_priority_set(letimer_instances[number].irq);
+	NVIC_EnableIRQ(letimer_instances[number].irq); // enable interrupts to CPU via NVIC interrupt enable
 
-	if(letimer->STATUS & LETIMER_STATUS_RUNNING) sleep_block_mode(LETIMER_EM);
+	if(letimer->STATUS & LETIMER_STATUS_RUNNING) sleep_block_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
 
 
 
@@ -164,42 +232,27 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 
 /***************************************************************************//**
  * @brief
- * LETIMER IRQ Handler
- *
- * @details
- * Basic IRQ handler for the LETIEMR0 peripheral that will clear interrupt flags and
- * call event handlers.
- *
- * @note
- * This function runs Atomically to avoid nested interrupts inside of an IRQ Handler.
+ * LETIMER0 IRQ Handler
  *
  ******************************************************************************/
 void LETIMER0_IRQHandler(void){
-	__disable_irq();
-	uint32_t int_flag;
-	int_flag = LETIMER0->IF & LETIMER0->IEN;
-	LETIMER0->IFC = int_flag;
+	TRACE_ENTER();
+	letimer_irq(LETIMER0, &letimer_handles[0]);
+	TRACE_EXIT(TRACE_ISR_LETIMER0);
+}
 
-	if(int_flag & LETIMER_IF_COMP0){
-		EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_COMP0));
-		add_scheduled_event(scheduled_comp0_cb);
-	}
-	if(int_flag & LETIMER_IF_COMP1){
-		EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_COMP1));
-		add_scheduled_event(scheduled_comp1_cb);
-	}
-	if(int_flag & LETIMER_IF_UF){
-		EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_UF));
-		add_scheduled_event(scheduled_uf_cb);
-	}
-	if(int_flag & LETIMER_IF_REP0){
-		EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_REP0));
-	}
-	if(int_flag & LETIMER_IF_REP1){
-		EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_REP1));
-	}
-	__enable_irq();
+#if LETIMER_COUNT > 1
+/***************************************************************************//**
+ * @brief
+ * LETIMER1 IRQ Handler
+ *
+ ******************************************************************************/
+void LETIMER1_IRQHandler(void){
+	TRACE_ENTER();
+	letimer_irq(LETIMER1, &letimer_handles[1]);
+	TRACE_EXIT(TRACE_ISR_LETIMER1);
 }
+#endif
 
 /***************************************************************************//**
  * @brief
@@ -226,14 +279,69 @@ void LETIMER0_IRQHandler(void){
  ******************************************************************************/
 void letimer_start(LETIMER_TypeDef *letimer, bool enable){
 	if( enable) if(!(letimer->STATUS & LETIMER_STATUS_RUNNING)) {
-		sleep_block_mode(LETIMER_EM);
+		sleep_block_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
 		LETIMER_Enable(letimer, enable);
 		while(letimer->SYNCBUSY);
 	}
 	if(!enable) if((letimer->STATUS & LETIMER_STATUS_RUNNING)){
 		LETIMER_Enable(letimer, enable);
 		while(letimer->SYNCBUSY);
-		sleep_unblock_mode(LETIMER_EM);
+		sleep_unblock_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ * Changes the PWM period of a running LETIMER
+ *
+ * @details
+ * Loads new COMP0 (top) and COMP1 (active) values without stopping the
+ * LETIMER or touching its interrupts and routes. COMP0 is only reloaded into
+ * CNT on underflow, so the period in progress completes with its old length
+ * and the new one starts with the next period. The registers are written in
+ * the order that keeps COMP1 below COMP0 in between: COMP1 first when the
+ * period shrinks, COMP0 first when it grows.
+ *
+ * @note
+ * May be called while the LETIMER is running or stopped, but not from its
+ * interrupt handler, as it waits on SYNCBUSY.
+ *
+ * @param[in] letimer
+ * Pointer to the base peripheral address of the LETIMER peripheral opened by
+ * letimer_pwm_open().
+ *
+ * @param[in] period
+ * New period in seconds, at most LETIMER_MAX_CNT / LETIMER_HZ.
+ *
+ * @param[in] active_period
+ * New active period in seconds, shorter than the period.
+ *
+ ******************************************************************************/
+void letimer_set_period(LETIMER_TypeDef *letimer, float period, float active_period){
+	uint32_t period_cnt = period * LETIMER_HZ;
+	uint32_t period_active_cnt = active_period * LETIMER_HZ;
+	EFM_ASSERT((period_cnt <= LETIMER_MAX_CNT) && (period_active_cnt < period_cnt));
+
+	if(period_cnt < letimer->COMP0){
+		letimer_write_comp(letimer, &letimer->COMP1, period_active_cnt);
+		letimer_write_comp(letimer, &letimer->COMP0, period_cnt);
+	} else {
+		letimer_write_comp(letimer, &letimer->COMP0, period_cnt);
+		letimer_write_comp(letimer, &letimer->COMP1, period_active_cnt);
 	}
 }
 
+/***************************************************************************//**
+ * @brief
+ * Writes a LETIMER compare register across the low frequency domain
+ *
+ * @details
+ * A write is only accepted once the previous one has been synchronized, so
+ * SYNCBUSY is checked before and after the write.
+ *
+ ******************************************************************************/
+static void letimer_write_comp(LETIMER_TypeDef *letimer, volatile uint32_t *comp, uint32_t value){
+	while(letimer->SYNCBUSY);
+	*comp = value;
+	while(letimer->SYNCBUSY);
+}
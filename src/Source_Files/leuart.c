@@ -20,6 +20,8 @@
 //** Developer/user include files
 #include "leuart.h"
 #include "scheduler.h"
+#include "trace.h"
+#include "irq.h"
 
 //***********************************************************************************
 // defined files
@@ -29,16 +31,26 @@
 //***********************************************************************************
 // private variables
 //***********************************************************************************
-uint32_t	rx_done_evt;
-uint32_t	tx_done_evt;
-bool		leuart0_tx_busy;
-static 		LEUART_SM_STRUCT	leuart_sm;
+static		LEUART_HANDLE_STRUCT	leuart_handles[LEUART_COUNT];
+
+// Per instance resources, in LEUART number order
+static const struct {
+	CMU_Clock_TypeDef	clock;
+	IRQn_Type			irq;
+	uint32_t			ldma_ch;
+} leuart_instances[LEUART_COUNT] = {
+	{ cmuClock_LEUART0,	LEUART0_IRQn,	LDMA_LEUART0_TX_CH },
+#if LEUART_COUNT > 1
+	{ cmuClock_LEUART1,	LEUART1_IRQn,	LDMA_LEUART1_TX_CH },
+#endif
+};
 
 /***************************************************************************//**
  * @brief LEUART driver
  * @details
  *  This module contains all the functions to support the driver's state
- *  machine to transmit a string of data across the LEUART bus.  There are
+ *  machine to transmit a string of data across the LEUART bus, and to hand
+ *  every received byte to the rx_callback from the RXDATAV interrupt.  There are
  *  additional functions to support the Test Driven Development test that
  *  is used to validate the basic set up of the LEUART peripheral.  The
  *  TDD test for this class assumes that the LEUART is connected to the HM-18
@@ -51,33 +63,77 @@ static 		LEUART_SM_STRUCT	leuart_sm;
 // Private functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ * 	Returns the number of an LEUART peripheral, the index of its handle
+ *
+ ******************************************************************************/
+static uint32_t leuart_number(LEUART_TypeDef *leuart){
+#if LEUART_COUNT > 1
+	if(leuart == LEUART1) return 1;
+#endif
+	EFM_ASSERT(leuart == LEUART0);
+	return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * 	Returns the handle of an LEUART peripheral
+ *
+ ******************************************************************************/
+static LEUART_HANDLE_STRUCT *leuart_handle(LEUART_TypeDef *leuart){
+	return &leuart_handles[leuart_number(leuart)];
+}
+
+/***************************************************************************//**
+ * @brief
+ *	RXDATAV Interrupt Handler for the LEUART RX path
+ *
+ * @details
+ * 	Empties the RX FIFO into the rx_callback and posts rx_done_evt for every
+ * 	frame the callback reports complete. The LEUART receives in EM2, the core
+ * 	only wakes for the interrupt.
+ *
+ ******************************************************************************/
+static void rx_int(LEUART_TypeDef *leuart, LEUART_RX_STRUCT *rx){
+	while(leuart->STATUS & LEUART_STATUS_RXDATAV){
+		uint8_t data = leuart->RXDATA;
+		if(rx->callback(data, rx->ctx)) add_scheduled_event(rx->rx_done_evt);
+	}
+}
+
 /***************************************************************************//**
  * @brief
  *	TXBL Interrupt Handler for LEUART SM TX Sequence
  *
  * @details
  * 	The TXBL interrupt will handle the entirety of a TX data transfer for the
- * 	LEUART TX state machine. It will send data until the last bit and then will
- * 	go into the STOP_CLOSE state and wait for the TXC to be asserted.
+ * 	LEUART TX state machine. It will send the segments one after the other
+ * 	until the last byte and then will go into the STOP_CLOSE state and wait
+ * 	for the TXC to be asserted.
  *
  * @note
  * 	TXBL interrupt is enabled at the last character being sent.
  *
  ******************************************************************************/
-static void txbl_int(){
-	switch(leuart_sm.current_state){
+static void txbl_int(LEUART_SM_STRUCT *sm){
+	switch(sm->current_state){
 		case INIT_UART:
 			// ready to begin sending data
-			leuart_sm.current_state = SEND_DATA;
+			sm->current_state = SEND_DATA;
 			break;
 		case SEND_DATA:
-			leuart_sm.leuart->TXDATA = leuart_sm.output[leuart_sm.count];
-//			while(leuart_sm.leuart->SYNCBUSY);
-			leuart_sm.count ++;
-			if(leuart_sm.count == (leuart_sm.length)){
-				leuart_sm.current_state = STOP_CLOSE;
-				leuart_sm.leuart->IEN &= ~LEUART_IEN_TXBL;
-				leuart_sm.leuart->IEN |= LEUART_IEN_TXC;
+			sm->leuart->TXDATA = ((const uint8_t *)sm->span[sm->index].src)[sm->count];
+//			while(sm->leuart->SYNCBUSY);
+			sm->count ++;
+			if(sm->count == sm->span[sm->index].len){
+				sm->count = 0;
+				sm->index++;
+			}
+			if(sm->index == sm->spans){
+				sm->current_state = STOP_CLOSE;
+				sm->leuart->IEN &= ~LEUART_IEN_TXBL;
+				sm->leuart->IEN |= LEUART_IEN_TXC;
 			}
 			break;
 		case STOP_CLOSE:
@@ -95,14 +151,16 @@ static void txbl_int(){
  * @details
  * 	When TXC interrupt is enabled and it is then asserted, this indicated the
  * 	completion of a TX transfer. The SM will conclude and the device will return back
- * 	to the previous EM mode.
+ * 	to the previous EM mode. TX is left enabled for the next transfer, a CMD
+ * 	write here would still be synchronizing when the next one starts.
+ * 	In LDMA mode this is the only interrupt taken for the whole transfer.
  *
  * @note
  * 	The tx_done_event scheduled event will be added.
  *
  ******************************************************************************/
-static void txc_int(){
-	switch(leuart_sm.current_state){
+static void txc_int(LEUART_SM_STRUCT *sm){
+	switch(sm->current_state){
 		case INIT_UART:
 			EFM_ASSERT(false);
 			break;
@@ -110,19 +168,49 @@ static void txc_int(){
 			EFM_ASSERT(false);
 			break;
 		case STOP_CLOSE:
-			leuart_sm.leuart->CMD |= LEUART_CMD_TXDIS;
-//			while(leuart_sm.leuart->SYNCBUSY);
-			add_scheduled_event(tx_done_evt);
-			leuart_sm.leuart->IEN &= ~LEUART_IEN_TXC;
-			sleep_unblock_mode(LEUART_TX_EM);
-			leuart_sm.SMbusy = false;
-			leuart_sm.current_state = INIT_UART;
+			// with the LDMA feeding TXDATA, TXC is only valid once the channel is drained
+			if(sm->dma && !ldma_channel_done(sm->ldma_ch)) break;
+			add_scheduled_event(sm->tx_done_evt);
+			sm->leuart->IEN &= ~LEUART_IEN_TXC;
+			sleep_unblock_mode(LEUART_TX_EM, SLEEP_TAG_LEUART_TX);
+			sm->SMbusy = false;
+			sm->current_state = INIT_UART;
 			return;
 		default:
 			EFM_ASSERT(false);
 	}
 }
 
+/***************************************************************************//**
+ * @brief
+ *	Common LEUART interrupt handling
+ *
+ * @details
+ * 	Handles the interrupts of TXBL and TXC to implement the state machine in
+ * 	operation, and RXDATAV and RXOF of the RX path. RX is served first, the
+ * 	FIFO holds two bytes only.
+ *
+ * @note
+ * This function will clear all interrupts of the instance
+ ******************************************************************************/
+static void leuart_irq(LEUART_TypeDef *leuart, LEUART_HANDLE_STRUCT *handle){
+	uint32_t int_flag = leuart->IF & leuart->IEN;
+	leuart->IFC = int_flag;
+
+	if(int_flag & LEUART_IF_RXOF){
+		handle->rx.overruns++;
+	}
+	if(int_flag & LEUART_IF_RXDATAV){
+		rx_int(leuart, &handle->rx);
+	}
+	if(int_flag & LEUART_IF_TXBL){
+		txbl_int(&handle->tx);
+	}
+	if(int_flag & LEUART_IF_TXC){
+		txc_int(&handle->tx);
+	}
+}
+
 
 //***********************************************************************************
 // Global functions
@@ -136,9 +224,15 @@ static void txc_int(){
  * 	This function will open the given LEUART peripheral to the leuart_settings
  * 	passed. The LEUART clock will be enabled, pins will be routed, and the RX
  * 	and TX registers will be cleared. The IRQ handler will also be enabled.
+ * 	Every LEUART of the part has its own handle, state machine, events and
+ * 	LDMA channel, so they can run side by side.
  *
  * @note
- * 	The LEUART SM will be set to NOT busy when this function is called
+ * 	The LEUART SM will be set to NOT busy when this function is called. If
+ * 	tx_dma_en is set, ldma_open() must have been called beforehand. With an
+ * 	rx_callback the RXDATAV interrupt is enabled and LEUART_RX_EM blocked for
+ * 	as long as the LEUART is open. The start frame, signal frame, SFUBRX and
+ * 	RX block settings are applied as given.
  *
  * @param[in] *leuart
  * A pointer to the LEUART Peripheral to be opened.
@@ -148,6 +242,8 @@ static void txc_int(){
  *
  ******************************************************************************/
 void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
+	uint32_t number = leuart_number(leuart);
+	LEUART_HANDLE_STRUCT *handle = &leuart_handles[number];
 	LEUART_Init_TypeDef leuartInit_struct;
 	leuartInit_struct.enable = leuart_settings->enable;
 	leuartInit_struct.refFreq = leuart_settings->refFreq;
@@ -156,7 +252,7 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
 	leuartInit_struct.parity = leuart_settings->parity;
 	leuartInit_struct.stopbits = leuart_settings->stopbits;
 
-	if(leuart == LEUART0) CMU_ClockEnable(cmuClock_LEUART0, true);
+	CMU_ClockEnable(leuart_instances[number].clock, true);
 	if ((leuart->IF & 0x01) == 0) {
 		leuart->IFS = 0x01;
 		EFM_ASSERT(leuart->IF & 0x01);
@@ -171,41 +267,70 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
 	leuart->ROUTEPEN  = (LEUART_ROUTEPEN_RXPEN * leuart_settings->rx_pin_en);
 	leuart->ROUTEPEN  |=	(LEUART_ROUTEPEN_TXPEN * leuart_settings->tx_pin_en);
 
-	rx_done_evt = leuart_settings->rx_done_evt;
-	tx_done_evt = leuart_settings->tx_done_evt;
-	leuart_sm.SMbusy = false;
+	handle->tx.leuart = leuart;
+	handle->tx.tx_done_evt = leuart_settings->tx_done_evt;
+	handle->tx.SMbusy = false;
+	handle->tx.current_state = INIT_UART;
+	handle->tx.dma = leuart_settings->tx_dma_en;
+	handle->tx.ldma_ch = leuart_instances[number].ldma_ch;
+	handle->rx.callback = leuart_settings->rx_callback;
+	handle->rx.ctx = leuart_settings->rx_ctx;
+	handle->rx.rx_done_evt = leuart_settings->rx_done_evt;
+	handle->rx.overruns = 0;
 
 	LEUART_Init(leuart, &leuartInit_struct) ;
-	leuart_cmd_write(HM10_LEUART0, (LEUART_CMD_CLEARRX | LEUART_CMD_CLEARTX));
+	uint32_t ctrl = 0;
+	if(handle->tx.dma) ctrl |= LEUART_CTRL_TXDMAWU;	// let TXBL wake the LDMA while the CPU remains in EM2
+	if(leuart_settings->sfubrx) ctrl |= LEUART_CTRL_SFUBRX;
+	if(ctrl){
+		leuart->CTRL |= ctrl;
+		while(leuart->SYNCBUSY);
+	}
+	if(leuart_settings->startframe_en){
+		leuart->STARTFRAME = leuart_settings->startframe;
+		while(leuart->SYNCBUSY);
+	}
+	if(leuart_settings->sigframe_en){
+		leuart->SIGFRAME = leuart_settings->sigframe;
+		while(leuart->SYNCBUSY);
+	}
+	leuart_cmd_write(leuart, (LEUART_CMD_CLEARRX | LEUART_CMD_CLEARTX));
 	LEUART_Enable(leuart, leuart_settings->enable);
-	while(!((leuart->STATUS & LEUART_STATUS_RXENS)& leuart_settings->rx_en) && !((leuart->STATUS & LEUART_STATUS_TXENS) & leuart_settings->tx_en));
+	while(!((leuart->STATUS & LEUART_STATUS_RXENS) && leuart_settings->rx_en) && !((leuart->STATUS & LEUART_STATUS_TXENS) && leuart_settings->tx_en));
+	if(leuart_settings->rxblocken) leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);
 
-	if(leuart == LEUART0) NVIC_EnableIRQ(LEUART0_IRQn);
+	if(handle->rx.callback){
+		leuart->IEN |= LEUART_IEN_RXDATAV | LEUART_IEN_RXOF;
+		sleep_block_mode(LEUART_RX_EM, SLEEP_TAG_LEUART_RX);
+	}
+
+	irq_priority_set(leuart_instances[number].irq);
+	NVIC_EnableIRQ(leuart_instances[number].irq);
 }
 
 /***************************************************************************//**
  * @brief
  *	LEUART0 IRQ Handler
  *
- * @details
- * 	Handles the interrupts of TXBL and TXC to implement the state machine in
- * 	operation.
- *
- * @note
- * This function will clear all LEUART0 interrupts
  ******************************************************************************/
-//
 void LEUART0_IRQHandler(void){
-	uint32_t int_flag = LEUART0->IF & LEUART0->IEN;
-	LEUART0->IFC = int_flag;
+	TRACE_ENTER();
+	leuart_irq(LEUART0, &leuart_handles[0]);
+	TRACE_EXIT(TRACE_ISR_LEUART0);
+}
 
-	if(int_flag & LEUART_IF_TXBL){
-		txbl_int();
-	}
-	if(int_flag & LEUART_IF_TXC){
-		txc_int();
-	}
+#if LEUART_COUNT > 1
+/***************************************************************************//**
+ * @brief
+ *	LEUART1 IRQ Handler
+ *
+ ******************************************************************************/
+void LEUART1_IRQHandler(void){
+	TRACE_ENTER();
+	leuart_irq(LEUART1, &leuart_handles[1]);
+	TRACE_EXIT(TRACE_ISR_LEUART1);
 }
+#endif
 
 /***************************************************************************//**
  * @brief
@@ -213,38 +338,78 @@ void LEUART0_IRQHandler(void){
  *
  * @details
  *  This function will initialize a TX transfer of the given string across the
- *  given LEUART peripheral. The TXBL and TXC interrupts are used and the state
- *  machine will send the first byte when TXBL IF is asserted.
- *
- * @note
- * If a current transmission is active, the function will wait for it to finish
- * before beginning a new one
+ *  given LEUART peripheral, as a single segment of leuart_start_spans().
  *
  * @param[in] *leuart
  * A poiner to the LEUART peripheral to be used
  *
  * @param[in] *string
- * A pointer to the string to be sent.
+ * A pointer to the data to be sent, which does not need to be NUL terminated.
  *
  * @param[in] string_len
  * The number of characters to be sent.
  ******************************************************************************/
 
 void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
-	while(leuart_tx_busy(leuart)); //stall if  busy
+	LEUART_SPAN_STRUCT span = { string, string_len };
+	leuart_start_spans(leuart, &span, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Start an LEUART transmission of several segments
+ *
+ * @details
+ *  This function will initialize a TX transfer of the segments, back to back
+ *  and without copying them, across the given LEUART peripheral. The TXBL and
+ *  TXC interrupts are used and the state machine will send the first byte
+ *  when TXBL IF is asserted. When the LEUART was opened with tx_dma_en, the
+ *  LDMA walks the segments with a descriptor chain and only the TXC interrupt
+ *  is enabled. Segments of 0 bytes are skipped.
+ *
+ * @note
+ * If a current transmission is active, the function will wait for it to finish
+ * before beginning a new one. The segments are not copied, they must stay valid
+ * until the tx_done_evt has been raised. At least one byte must be sent.
+ *
+ * @param[in] *leuart
+ * A poiner to the LEUART peripheral to be used
+ *
+ * @param[in] *spans
+ * The segments, in the order they are sent.
+ *
+ * @param[in] count
+ * The number of segments, up to LEUART_SPAN_MAX.
+ ******************************************************************************/
+
+void leuart_start_spans(LEUART_TypeDef *leuart, const LEUART_SPAN_STRUCT *spans, uint32_t count){
+	LEUART_SM_STRUCT *sm = &leuart_handle(leuart)->tx;
+	EFM_ASSERT(count <= LEUART_SPAN_MAX);
+	while(sm->SMbusy); //stall if  busy
+	if(!(leuart->STATUS & LEUART_STATUS_TXENS)) leuart_cmd_write(leuart, LEUART_CMD_TXEN);	// only if opened without TX
 	CORE_DECLARE_IRQ_STATE;
 	CORE_ENTER_CRITICAL();
 
 
-	leuart_sm.leuart = leuart;
-	leuart_sm.length = string_len;
-	leuart_sm.count = 0;
-	strcpy(leuart_sm.output, string);
-	leuart_sm.SMbusy = true;
-	sleep_block_mode(LEUART_TX_EM);
-
-	leuart_sm.leuart->CMD |= LEUART_CMD_TXEN;
-	leuart->IEN |= LEUART_IEN_TXBL;
+	sm->spans = 0;
+	for(uint32_t i = 0; i < count; i++){
+		if(spans[i].len) sm->span[sm->spans++] = spans[i];
+	}
+	EFM_ASSERT(sm->spans);
+	sm->index = 0;
+	sm->count = 0;
+	sm->SMbusy = true;
+	sleep_block_mode(LEUART_TX_EM, SLEEP_TAG_LEUART_TX);
+
+	if(sm->dma){
+		// LDMA moves every byte, the CPU only wakes on the final TXC
+		sm->current_state = STOP_CLOSE;
+		leuart->IFC = LEUART_IFC_TXC;
+		ldma_leuart_tx_start(sm->ldma_ch, leuart, sm->span, sm->spans);
+		leuart->IEN |= LEUART_IEN_TXC;
+	} else {
+		leuart->IEN |= LEUART_IEN_TXBL;
+	}
 
 	CORE_EXIT_CRITICAL();
 
@@ -265,7 +430,70 @@ void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
  ******************************************************************************/
 
 bool leuart_tx_busy(LEUART_TypeDef *leuart){
-	return leuart_sm.SMbusy;
+	return leuart_handle(leuart)->tx.SMbusy;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	LEUART RX overrun count
+ *
+ * @details
+ * Returns the number of times the RX FIFO overflowed since leuart_open(),
+ * each is at least one byte lost.
+ *
+ * @param[in] *leuart
+ * A pointer to the LEUART peripheral to be checked
+ ******************************************************************************/
+
+uint32_t leuart_rx_overruns(LEUART_TypeDef *leuart){
+	return leuart_handle(leuart)->rx.overruns;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Changes the baud rate of an open LEUART
+ *
+ * @note
+ *	Only in a window where nothing is transmitted and the other end sends
+ *	nothing, a frame crossing the change is garbled.
+ *
+ * @param[in] *leuart
+ * A pointer to the LEUART peripheral
+ *
+ * @param[in] baudrate
+ * The new rate, derived from the LEUART clock as in leuart_open()
+ ******************************************************************************/
+
+void leuart_baud_set(LEUART_TypeDef *leuart, uint32_t baudrate){
+	EFM_ASSERT(!leuart_tx_busy(leuart));
+	LEUART_BaudrateSet(leuart, 0, baudrate);
+	while(leuart->SYNCBUSY);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Rate the LEUART would run at for a requested baud rate
+ *
+ * @details
+ * 	The CLKDIV of LEUART_BaudrateSet() from the current LEUART clock. The
+ * 	LEUART samples a bit over at least one clock cycle, a rate above the
+ * 	clock is out of reach.
+ *
+ * @param[in] *leuart
+ * A pointer to the LEUART peripheral
+ *
+ * @param[in] baudrate
+ * The requested rate
+ *
+ * @return
+ * 	The actual rate, 0 if the clock cannot produce it
+ ******************************************************************************/
+
+uint32_t leuart_baud_reachable(LEUART_TypeDef *leuart, uint32_t baudrate){
+	uint64_t ref = CMU_ClockFreqGet(leuart_instances[leuart_number(leuart)].clock);
+	uint64_t div = (32 * ref) / baudrate;
+	if(div < 32) return 0;
+	return (uint32_t)((ref * 256) / (256 + (div - 32) * 8));
 }
 
 
@@ -303,7 +531,8 @@ uint32_t leuart_status(LEUART_TypeDef *leuart){
  * @note
  *   Before exiting this function to update  the CMD register, it must
  *   perform a SYNCBUSY while loop to ensure that the CMD has by synchronized
- *   to the lower frequency LEUART domain.
+ *   to the lower frequency LEUART domain. It also waits before the write, a
+ *   CMD written by LEUART_Enable() may still be synchronizing.
  *
  * @param[in] *leuart
  *   Defines the LEUART peripheral to access.
@@ -315,6 +544,7 @@ uint32_t leuart_status(LEUART_TypeDef *leuart){
 
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update){
 
+	while(leuart->SYNCBUSY);
 	leuart->CMD = cmd_update;
 	while(leuart->SYNCBUSY);
 }
@@ -0,0 +1,128 @@
+/**
+ * @file report.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Report-on-change decisions for sensor channels. A reading is only
+ * sent when it moved past the channel's deadband, when the heartbeat interval
+ * ran out, or when it toggled the channel's alarm, so unchanged readings cost
+ * no radio traffic. Free of hardware, the state machine runs the same on the
+ * host.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "report.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Initializes a channel that has not reported yet, alarm cleared
+ *
+ * @param[in] *channel
+ *	Channel owned by the caller.
+ *
+ * @param[in] *config
+ *	Deadband, intervals and alarm thresholds, copied.
+ *
+ ******************************************************************************/
+void report_init(REPORT_CHANNEL_STRUCT *channel, const REPORT_CONFIG_STRUCT *config){
+	channel->config = *config;
+	channel->last_value = 0;
+	channel->last_time = 0;
+	channel->reported = false;
+	channel->alarm = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Decides whether a reading has to be reported
+ *
+ * @details
+ *	Updates the alarm with hysteresis: it asserts when the value rises above
+ *	alarm_on and clears when it falls to alarm_off. The first reading, an
+ *	alarm edge, and a heartbeat due after max_interval are always reported.
+ *	Otherwise the reading is reported if it moved more than the deadband from
+ *	the last report and min_interval has passed.
+ *
+ * @note
+ *	Call report_sent() once the reading was actually sent. Intervals are
+ *	unsigned differences, so they survive the timestamp wrap.
+ *
+ * @param[in] *channel
+ *	Channel set up by report_init().
+ *
+ * @param[in] now
+ *	Timestamp of the reading.
+ *
+ * @param[in] value
+ *	The reading.
+ *
+ * @return
+ *	REPORT_SEND and REPORT_ALARM_EDGE flags.
+ *
+ ******************************************************************************/
+uint32_t report_check(REPORT_CHANNEL_STRUCT *channel, uint32_t now, int32_t value){
+	REPORT_CONFIG_STRUCT *config = &channel->config;
+	uint32_t result = 0;
+
+	if(config->alarm_en){
+		bool alarm = channel->alarm ? (value > config->alarm_off) : (value > config->alarm_on);
+		if(alarm != channel->alarm){
+			channel->alarm = alarm;
+			result |= REPORT_ALARM_EDGE | REPORT_SEND;
+		}
+	}
+	if(!channel->reported) return result | REPORT_SEND;
+
+	uint32_t elapsed = now - channel->last_time;
+	int32_t delta = value - channel->last_value;
+	if(config->max_interval && (elapsed >= config->max_interval)) result |= REPORT_SEND;
+	if(((delta > config->deadband) || (delta < -config->deadband)) && (elapsed >= config->min_interval)){
+		result |= REPORT_SEND;
+	}
+	return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Records a reading as reported
+ *
+ * @details
+ *	The reading becomes the reference of the deadband and the start of the
+ *	intervals.
+ *
+ ******************************************************************************/
+void report_sent(REPORT_CHANNEL_STRUCT *channel, uint32_t now, int32_t value){
+	channel->last_value = value;
+	channel->last_time = now;
+	channel->reported = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the alarm state of a channel
+ *
+ ******************************************************************************/
+bool report_alarm(REPORT_CHANNEL_STRUCT *channel){
+	return channel->alarm;
+}
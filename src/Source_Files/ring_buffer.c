@@ -0,0 +1,405 @@
+/**
+ * @file ring_buffer.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Variable length frame ring buffer. Frames are always stored in one
+ * contiguous span so that producers can write them in place and consumers
+ * (including the LDMA) can read them without copying.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+
+//** Standard Libraries
+#include <string.h>
+
+//** Silicon Lab include files
+
+//** User/developer include files
+#include "ring_buffer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Read a frame header
+ *
+ * @note
+ *	Frames are RING_ALIGN aligned so a header never straddles the buffer end.
+ *
+ ******************************************************************************/
+static uint32_t ring_hdr_read(RING_BUF_STRUCT *ring, uint32_t idx){
+	uint32_t pos = idx & ring->size_mask;
+	return ring->buf[pos] | ((uint32_t)ring->buf[pos + 1] << 8);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Write a frame header
+ *
+ ******************************************************************************/
+static void ring_hdr_write(RING_BUF_STRUCT *ring, uint32_t idx, uint32_t value){
+	uint32_t pos = idx & ring->size_mask;
+	ring->buf[pos] = value & 0xFF;
+	ring->buf[pos + 1] = (value >> 8) & 0xFF;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Step the read index past a wrap marker
+ *
+ * @note
+ *	Must be called with the read index pointing at a committed header.
+ *
+ ******************************************************************************/
+static void ring_skip_wrap(RING_BUF_STRUCT *ring){
+	if(ring_hdr_read(ring, ring->read_idx) == RING_WRAP_MARK){
+		ring->read_idx += ring->size - (ring->read_idx & ring->size_mask);
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Discard the oldest queued frame
+ *
+ * @details
+ *	Used by the RING_DROP_OLDEST policy. A frame that has been handed to the
+ *	consumer with ring_buf_peek() is never discarded.
+ *
+ * @return
+ *	Returns true if a frame was discarded.
+ *
+ ******************************************************************************/
+static bool ring_drop_oldest(RING_BUF_STRUCT *ring){
+	bool dropped = false;
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	if(!ring->peeked && (ring->read_idx != ring->write_idx)){
+		ring_skip_wrap(ring);
+		ring->read_idx += ring_buf_frame_size(ring_hdr_read(ring, ring->read_idx));
+		ring->dropped++;
+		dropped = true;
+	}
+	CORE_EXIT_CRITICAL();
+	return dropped;
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Initialize a ring buffer
+ *
+ * @details
+ *	Attaches the storage to the ring and resets the indices and statistics.
+ *
+ * @note
+ *	The size must be a power of two. block_wait is required for RING_BLOCK and
+ *	is also used by RING_DROP_OLDEST when the only queued frame is in flight.
+ *	It must not be called from interrupt context with a blocking policy.
+ *
+ * @param[in] *ring
+ *	The ring buffer to initialize.
+ *
+ * @param[in] *storage
+ *	Backing store of size bytes.
+ *
+ * @param[in] size
+ *	Capacity in bytes, a power of two.
+ *
+ * @param[in] policy
+ *	What to do with a frame that does not fit.
+ *
+ * @param[in] block_wait
+ *	Function that lets the consumer make progress, NULL if not used.
+ *
+ ******************************************************************************/
+void ring_buf_init(RING_BUF_STRUCT *ring, uint8_t *storage, uint32_t size, RING_POLICY policy, void (*block_wait)(void)){
+	EFM_ASSERT((size >= 2 * RING_HDR_SIZE) && ((size & (size - 1)) == 0));
+	EFM_ASSERT((policy != RING_BLOCK) || (block_wait != NULL));
+	ring->buf = storage;
+	ring->size = size;
+	ring->size_mask = size - 1;
+	ring->write_idx = 0;
+	ring->read_idx = 0;
+	ring->reserve_idx = 0;
+	ring->reserve_len = 0;
+	ring->peeked = false;
+	ring->peek_end = 0;
+	ring->policy = policy;
+	ring->block_wait = block_wait;
+	ring->dropped = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Reserve a contiguous span for a frame
+ *
+ * @details
+ *	Returns a pointer to len contiguous bytes that the producer fills in place
+ *	before calling ring_buf_commit(). If the frame does not fit before the end
+ *	of the buffer, a wrap marker is left behind and the frame starts at index 0.
+ *	When the buffer is full, the ring policy is applied.
+ *
+ * @note
+ *	Only one reservation may be outstanding. Nothing is visible to the consumer
+ *	until the frame is committed.
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[in] len
+ *	The number of payload bytes to reserve.
+ *
+ * @return
+ *	Pointer to the payload span, NULL if the frame was dropped.
+ *
+ ******************************************************************************/
+uint8_t *ring_buf_reserve(RING_BUF_STRUCT *ring, uint32_t len){
+	uint32_t need = ring_buf_frame_size(len);
+	uint32_t skip;
+	EFM_ASSERT(len <= RING_MAX_FRAME);
+	EFM_ASSERT(need <= ring->size);
+
+	while(1){
+		uint32_t tail = ring->size - (ring->write_idx & ring->size_mask);
+		skip = (need <= tail) ? 0 : tail;
+		if(skip && ring_buf_empty(ring)){
+			// nothing queued, move both indices to the start of the buffer
+			CORE_DECLARE_IRQ_STATE;
+			CORE_ENTER_CRITICAL();
+			if(ring_buf_empty(ring)){
+				ring->write_idx += skip;
+				ring->read_idx = ring->write_idx;
+				skip = 0;
+			}
+			CORE_EXIT_CRITICAL();
+		}
+		if(ring_buf_space(ring) >= (skip + need)) break;
+
+		if((ring->policy == RING_DROP_OLDEST) && ring_drop_oldest(ring)) continue;
+		if((ring->policy != RING_DROP_NEWEST) && (ring->block_wait != NULL)){
+			ring->block_wait();
+			continue;
+		}
+		ring->dropped++;
+		return NULL;
+	}
+
+	if(skip) ring_hdr_write(ring, ring->write_idx, RING_WRAP_MARK);
+	ring->reserve_idx = ring->write_idx + skip;
+	ring->reserve_len = len;
+	return &ring->buf[(ring->reserve_idx + RING_HDR_SIZE) & ring->size_mask];
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Publish a reserved frame
+ *
+ * @details
+ *	Writes the frame header and advances the write index so the frame becomes
+ *	visible to the consumer.
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[in] len
+ *	The number of payload bytes written, no more than reserved.
+ *
+ ******************************************************************************/
+void ring_buf_commit(RING_BUF_STRUCT *ring, uint32_t len){
+	EFM_ASSERT(len <= ring->reserve_len);
+	ring_hdr_write(ring, ring->reserve_idx, len);
+	__DMB(); // payload and header must land before the index moves
+	ring->write_idx = ring->reserve_idx + ring_buf_frame_size(len);
+	ring->reserve_len = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Copy a frame into the ring
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[in] *data
+ *	The payload to copy.
+ *
+ * @param[in] len
+ *	The payload length in bytes.
+ *
+ * @return
+ *	Returns true if the frame was queued.
+ *
+ ******************************************************************************/
+bool ring_buf_push(RING_BUF_STRUCT *ring, const void *data, uint32_t len){
+	uint8_t *dst = ring_buf_reserve(ring, len);
+	if(dst == NULL) return false;
+	memcpy(dst, data, len);
+	ring_buf_commit(ring, len);
+	return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Access the oldest frame in place
+ *
+ * @details
+ *	The frame stays in the ring, and is protected from the drop oldest policy,
+ *	until ring_buf_release() is called. Peeking again before the release
+ *	returns the same frame.
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[out] *len
+ *	The payload length of the frame.
+ *
+ * @return
+ *	Pointer to the contiguous payload, NULL if the ring is empty.
+ *
+ ******************************************************************************/
+uint8_t *ring_buf_peek(RING_BUF_STRUCT *ring, uint32_t *len){
+	uint8_t *frame;
+	return ring_buf_peek_frames(ring, &frame, len, 1) ? frame : NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Access the oldest frames in place
+ *
+ * @details
+ *	Hands out up to max frames in queue order, so a consumer can send them in
+ *	one transfer. They stay in the ring, and are protected from the drop
+ *	oldest policy, until ring_buf_release() frees them all. Peeking again
+ *	before the release returns the same frames.
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[out] **frames
+ *	Receives a pointer to the contiguous payload of each frame.
+ *
+ * @param[out] *lens
+ *	Receives the payload length of each frame.
+ *
+ * @param[in] max
+ *	Entries of frames and lens.
+ *
+ * @return
+ *	The number of frames handed out, 0 if the ring is empty.
+ *
+ ******************************************************************************/
+uint32_t ring_buf_peek_frames(RING_BUF_STRUCT *ring, uint8_t **frames, uint32_t *lens, uint32_t max){
+	uint32_t count = 0;
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	if(ring->read_idx != ring->write_idx){
+		ring_skip_wrap(ring);
+		uint32_t idx = ring->read_idx;
+		uint32_t end = ring->peeked ? ring->peek_end : ring->write_idx;
+		while((count < max) && (idx != end)){
+			if(ring_hdr_read(ring, idx) == RING_WRAP_MARK) idx += ring->size - (idx & ring->size_mask);
+			lens[count] = ring_hdr_read(ring, idx);
+			frames[count++] = &ring->buf[(idx + RING_HDR_SIZE) & ring->size_mask];
+			idx += ring_buf_frame_size(lens[count - 1]);
+		}
+		ring->peek_end = idx;
+		ring->peeked = true;
+	}
+	CORE_EXIT_CRITICAL();
+	return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Free the frames handed out by the last peek
+ *
+ * @note
+ *	Must follow a successful ring_buf_peek() or ring_buf_peek_frames().
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ ******************************************************************************/
+void ring_buf_release(RING_BUF_STRUCT *ring){
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	EFM_ASSERT(ring->peeked);
+	ring->read_idx = ring->peek_end;
+	ring->peeked = false;
+	CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Copy the oldest frame out of the ring
+ *
+ * @param[in] *ring
+ *	The ring buffer.
+ *
+ * @param[out] *dst
+ *	Destination, at least max_len bytes.
+ *
+ * @param[in] max_len
+ *	Bytes that fit in dst, a longer frame is truncated.
+ *
+ * @return
+ *	The payload length of the frame, 0 if the ring was empty.
+ *
+ ******************************************************************************/
+uint32_t ring_buf_pop(RING_BUF_STRUCT *ring, void *dst, uint32_t max_len){
+	uint32_t len;
+	uint8_t *frame = ring_buf_peek(ring, &len);
+	if(frame == NULL) return 0;
+	memcpy(dst, frame, (len < max_len) ? len : max_len);
+	ring_buf_release(ring);
+	return len;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Free space in bytes
+ *
+ * @note
+ *	A frame of len bytes uses ring_buf_frame_size(len) bytes, plus the bytes
+ *	up to the buffer end when it has to wrap.
+ *
+ ******************************************************************************/
+uint32_t ring_buf_space(RING_BUF_STRUCT *ring){
+	return ring->size - (ring->write_idx - ring->read_idx);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Bytes used by a frame of len payload bytes
+ *
+ ******************************************************************************/
+uint32_t ring_buf_frame_size(uint32_t len){
+	return RING_HDR_SIZE + ((len + RING_ALIGN - 1) & ~(RING_ALIGN - 1));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true if no frame is queued
+ *
+ ******************************************************************************/
+bool ring_buf_empty(RING_BUF_STRUCT *ring){
+	return ring->read_idx == ring->write_idx;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file rtcc.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Free running RTCC counter used as the low energy system time base.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "rtcc.h"
+#include "trace.h"
+#include "irq.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+const SW_TIMER_PORT rtcc_timer_port = {
+	RTCC_HZ,
+	rtcc_get_count,
+	rtcc_compare_set,
+	rtcc_compare_stop
+};
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	RTCC Init/Open Function
+ *
+ * @details
+ *	Enables the RTCC clock and starts the 32-bit counter free running at
+ *	RTCC_HZ. The counter is never reset, so differences of two readings are
+ *	valid across the wrap. Compare channel RTCC_TIMER_CH is set up for the
+ *	software timers but its interrupt stays off until a deadline is armed.
+ *
+ * @note
+ *	cmu_open() must have routed the LFXO to the LFE clock tree. RTCC_EM is
+ *	blocked so the counter keeps running while asleep.
+ *
+ ******************************************************************************/
+void rtcc_open(void){
+	RTCC_Init_TypeDef rtcc_init = RTCC_INIT_DEFAULT;
+	RTCC_CCChConf_TypeDef rtcc_compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+
+	CMU_ClockEnable(cmuClock_RTCC, true);
+
+	rtcc_init.enable = true;
+	rtcc_init.debugRun = false;
+	rtcc_init.presc = rtccCntPresc_1;
+	rtcc_init.cntWrapOnCCV1 = false;	// free running, wrap at 2^32
+	RTCC_Init(&rtcc_init);
+
+	RTCC_ChannelInit(RTCC_TIMER_CH, &rtcc_compare);
+	RTCC_IntDisable(RTCC_IEN_CC1);
+	RTCC_IntClear(RTCC_IF_CC1);
+	irq_priority_set(RTCC_IRQn);
+	NVIC_EnableIRQ(RTCC_IRQn);
+
+	sleep_block_mode(RTCC_EM, SLEEP_TAG_RTCC);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns the current RTCC count
+ *
+ * @return
+ *	The free running counter in RTCC_HZ ticks.
+ *
+ ******************************************************************************/
+uint32_t rtcc_get_count(void){
+	return RTCC_CounterGet();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Arm the software timer compare
+ *
+ * @details
+ *	The compare interrupt fires when the counter reaches count.
+ *
+ * @note
+ *	The caller makes sure count is at least SW_TIMER_MIN_LEAD ticks ahead.
+ *
+ * @param[in] count
+ *	Absolute counter value of the next deadline.
+ *
+ ******************************************************************************/
+void rtcc_compare_set(uint32_t count){
+	RTCC_ChannelCCVSet(RTCC_TIMER_CH, count);
+	RTCC_IntClear(RTCC_IF_CC1);
+	RTCC_IntEnable(RTCC_IEN_CC1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Disarm the software timer compare
+ *
+ ******************************************************************************/
+void rtcc_compare_stop(void){
+	RTCC_IntDisable(RTCC_IEN_CC1);
+	RTCC_IntClear(RTCC_IF_CC1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	RTCC IRQ Handler
+ *
+ * @details
+ *	The compare match of RTCC_TIMER_CH hands over to the software timers,
+ *	which program the next deadline.
+ *
+ ******************************************************************************/
+void RTCC_IRQHandler(void){
+	TRACE_ENTER();
+	uint32_t int_flag = RTCC_IntGetEnabled();
+	RTCC_IntClear(int_flag);
+
+	if(int_flag & RTCC_IF_CC1){
+		sw_timer_expire();
+	}
+	TRACE_EXIT(TRACE_ISR_RTCC);
+}
@@ -2,8 +2,8 @@
  * @file scheduler.c
  * @author Connor Peskin
  * @date September 17, 2020
- * @brief Outlines a scheduler that stores callback variables to a static
- * event_scheduled variable to schedule the event.
+ * @brief Outlines a scheduler that stores pending events in a static bitmap
+ * and dispatches them to registered handlers in priority order.
  */
 
 
@@ -16,23 +16,77 @@
 //** Silicon Lab include files
 #include "em_assert.h"
 #include "em_emu.h"
+#include "em_core.h"
 //** User/developer include files
 #include "scheduler.h"
+#include "trace.h"
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-
+#define SLOT_NONE		0xFF				// event has not been registered
+#define SLOT_WORD(p)	((p) >> 5)			// pending word of a priority slot
+#define SLOT_BIT(p)		(0x80000000u >> ((p) & 0x1F))	// priority 0 is the MSB
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
-static uint32_t event_scheduled;
+static volatile uint32_t	event_scheduled[SCHEDULER_WORDS];	// pending, by priority slot, set from interrupts
+static uint32_t				event_dispatching[SCHEDULER_WORDS];	// snapshot being dispatched, main loop only
+static uint8_t				event_slot[SCHEDULER_MAX_EVENTS];	// event id -> priority slot
+static SCHEDULER_HANDLER	slot_handler[SCHEDULER_MAX_EVENTS];	// priority slot -> handler
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ * Sets bits of a pending word with an exclusive load/store pair
+ *
+ * @details
+ * The store fails and the read-modify-write is retried if an interrupt was
+ * taken between the two, so the caller never masks interrupts.
+ *
+ * @return
+ * The word before the bits were set.
+ *
+ ******************************************************************************/
+static uint32_t slot_word_set(volatile uint32_t *word, uint32_t bits){
+	uint32_t old;
+	do {
+		old = __LDREXW(word);
+	} while(__STREXW(old | bits, word));
+	return old;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Clears bits of a pending word with an exclusive load/store pair
+ *
+ ******************************************************************************/
+static void slot_word_clear(volatile uint32_t *word, uint32_t bits){
+	uint32_t old;
+	do {
+		old = __LDREXW(word);
+	} while(__STREXW(old & ~bits, word));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads and clears a pending word with an exclusive load/store pair
+ *
+ * @return
+ * The pending bits taken.
+ *
+ ******************************************************************************/
+static uint32_t slot_word_take(volatile uint32_t *word){
+	uint32_t old;
+	do {
+		old = __LDREXW(word);
+	} while(__STREXW(0, word));
+	return old;
+}
 
 //***********************************************************************************
 // Global functions
@@ -43,16 +97,57 @@ static uint32_t event_scheduled;
  * Initializes the Scheduler
  *
  * @details
- * Initializes the scheduler by setting the static event_scheduled variable to 0x0
+ * Initializes the scheduler by clearing all pending events and all registered
+ * handlers.
  *
  * @note
  * This is an atomic operation.
  *
  ******************************************************************************/
 void scheduler_open(void){
-	__disable_irq();
-	event_scheduled = 0;
-	__enable_irq();
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	for(int i = 0; i < SCHEDULER_WORDS; i++){
+		event_scheduled[i] = 0;
+		event_dispatching[i] = 0;
+	}
+	for(int i = 0; i < SCHEDULER_MAX_EVENTS; i++){
+		event_slot[i] = SLOT_NONE;
+		slot_handler[i] = 0;
+	}
+	CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Registers an event handler with the Scheduler
+ *
+ * @details
+ * Binds the event id to a handler and a priority. The priority selects the
+ * bit the event occupies in the pending bitmap so that scheduler_dispatch()
+ * can find the most important pending event with a count leading zeros.
+ *
+ * @note
+ * Each priority can be used by one event only, 0 is the highest priority.
+ *
+ * @param[in] event
+ * The event id, 1 to SCHEDULER_MAX_EVENTS - 1.
+ *
+ * @param[in] handler
+ * The function to call from scheduler_dispatch() when the event is pending.
+ *
+ * @param[in] priority
+ * The priority of the event, 0 to SCHEDULER_MAX_EVENTS - 1.
+ *
+ ******************************************************************************/
+void scheduler_register(uint32_t event, SCHEDULER_HANDLER handler, uint32_t priority){
+	EFM_ASSERT((event != SCHEDULER_NO_EVENT) && (event < SCHEDULER_MAX_EVENTS));
+	EFM_ASSERT(priority < SCHEDULER_MAX_EVENTS);
+	EFM_ASSERT(slot_handler[priority] == 0);
+	EFM_ASSERT(event_slot[event] == SLOT_NONE);
+	if((event >= SCHEDULER_MAX_EVENTS) || (priority >= SCHEDULER_MAX_EVENTS)) return;
+	slot_handler[priority] = handler;
+	event_slot[event] = priority;
 }
 
 /***************************************************************************//**
@@ -60,20 +155,26 @@ void scheduler_open(void){
  * Adds event to Scheduler
  *
  * @details
- * Adds an event to the scheduler by OR'ing the events callback with the
- * static event_scheduled variable.
+ * Adds an event to the scheduler by setting the bit of its priority slot in
+ * the static event_scheduled bitmap.
  *
  * @note
- * This is an atomic operation to avoid missing scheduled events.
+ * The bit is set with LDREX/STREX, interrupts stay enabled and an interrupt
+ * that posts in between makes the store fail and retry instead of being lost.
+ * SCHEDULER_NO_EVENT is ignored so drivers can be opened without a callback.
+ * An id out of range or never registered is asserted, and ignored when
+ * asserts are compiled out.
  *
  * @param[in]
- * The callback variable for the desired event to add to the scheduler.
+ * The event id of the desired event to add to the scheduler.
  *
  ******************************************************************************/
 void add_scheduled_event(uint32_t event){
-	__disable_irq();
-	event_scheduled |= event;
-	__enable_irq();
+	if(event == SCHEDULER_NO_EVENT) return;
+	EFM_ASSERT((event < SCHEDULER_MAX_EVENTS) && (event_slot[event] != SLOT_NONE));
+	if((event >= SCHEDULER_MAX_EVENTS) || (event_slot[event] == SLOT_NONE)) return;
+	uint32_t slot = event_slot[event];
+	if(!(slot_word_set(&event_scheduled[SLOT_WORD(slot)], SLOT_BIT(slot)) & SLOT_BIT(slot))) trace_posted(slot);
 }
 
 /***************************************************************************//**
@@ -81,37 +182,102 @@ void add_scheduled_event(uint32_t event){
  * Removes event from Scheduler
  *
  * @details
- * Removes an event to the scheduler by removing the events callback from the
- * static event_scheduled variable.
+ * Removes an event from the scheduler by clearing the bit of its priority
+ * slot, including from a dispatch that is in progress.
  *
  * @note
- * This is an atomic operation to avoid missing scheduled events.
+ * Must be called from the main loop, a handler included. The pending bit is
+ * cleared with LDREX/STREX against interrupts that post, the dispatch
+ * snapshot is only touched by the main loop. An id out of range is asserted
+ * and ignored when asserts are compiled out; an unregistered one is ignored.
  *
  * @param[in]
- * The callback variable for the desired event to remove from the scheduler.
+ * The event id of the desired event to remove from the scheduler.
  *
  ******************************************************************************/
 void remove_scheduled_event(uint32_t event){
-	__disable_irq();
-	event_scheduled &= ~event;
-	__enable_irq();
+	if(event == SCHEDULER_NO_EVENT) return;
+	EFM_ASSERT(event < SCHEDULER_MAX_EVENTS);
+	if((event >= SCHEDULER_MAX_EVENTS) || (event_slot[event] == SLOT_NONE)) return;
+	uint32_t slot = event_slot[event];
+	slot_word_clear(&event_scheduled[SLOT_WORD(slot)], SLOT_BIT(slot));
+	event_dispatching[SLOT_WORD(slot)] &= ~SLOT_BIT(slot);
 }
 
 /***************************************************************************//**
  * @brief
- * Returns the Currently Scheduled Events
+ * Returns whether any event is pending
  *
  * @details
- * This function simply returns the static event_scheduled variable.
+ * This function returns the OR of the pending bitmap words.
  *
  * @note
- *
+ * The value is only meant to be tested against 0, use
+ * scheduled_event_pending() to test a single event.
  *
  * @return
- * Returns the currently scheduled events (by callback)- the static
- * event_scheduled variable.
+ * Returns non zero if at least one event is scheduled.
  *
  ******************************************************************************/
 uint32_t get_scheduled_events(void){
-	return event_scheduled;
+	uint32_t pending = 0;
+	for(int i = 0; i < SCHEDULER_WORDS; i++) pending |= event_scheduled[i];
+	return pending;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns whether an event is pending
+ *
+ * @param[in] event
+ * The event id to test.
+ *
+ * @return
+ * Returns true if the event is scheduled and has not been dispatched yet.
+ *
+ ******************************************************************************/
+bool scheduled_event_pending(uint32_t event){
+	EFM_ASSERT(event < SCHEDULER_MAX_EVENTS);
+	if((event == SCHEDULER_NO_EVENT) || (event >= SCHEDULER_MAX_EVENTS) || (event_slot[event] == SLOT_NONE)) return false;
+	uint32_t slot = event_slot[event];
+	return (event_scheduled[SLOT_WORD(slot)] & SLOT_BIT(slot)) != 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Dispatches all pending events
+ *
+ * @details
+ * Takes and clears a snapshot of the pending bitmap with LDREX/STREX,
+ * without masking interrupts, then calls the handler of every event in the
+ * snapshot from the highest to the lowest priority. Each step uses a count
+ * leading zeros on the snapshot, so the cost depends on the number of
+ * pending events and not on the number of registered ones.
+ *
+ * The snapshot is taken one word at a time, not in one critical section
+ * over the whole bitmap. It is therefore not a single instant across words:
+ * an event posted while the words are taken is dispatched now if its word
+ * had not been taken yet, and by the next call otherwise.
+ *
+ * @note
+ * Events scheduled while the handlers run are picked up by the next call.
+ * Handlers no longer need to remove their own event. With TRACE_ENABLED each
+ * handler and its wait since add_scheduled_event() are timed.
+ *
+ ******************************************************************************/
+void scheduler_dispatch(void){
+	for(int i = 0; i < SCHEDULER_WORDS; i++){
+		event_dispatching[i] = slot_word_take(&event_scheduled[i]);
+	}
+
+	for(int i = 0; i < SCHEDULER_WORDS; i++){
+		while(event_dispatching[i]){
+			uint32_t slot = __CLZ(event_dispatching[i]);
+			event_dispatching[i] &= ~SLOT_BIT(slot);
+			trace_dispatched((i << 5) + slot);
+			TRACE_ENTER();
+			slot_handler[(i << 5) + slot]();
+			TRACE_EXIT(TRACE_EVENT((i << 5) + slot));
+		}
+	}
 }
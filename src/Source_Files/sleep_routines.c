@@ -35,20 +35,107 @@
 //***********************************************************************************
 
 //** Standard Libraries
+#include <string.h>
 
 //** Silicon Lab include files
 
 //** User/developer include files
 #include "sleep_routines.h"
+#include "ble.h"
+#include "fmt.h"
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
 static int lowest_energy_mode[MAX_ENERGY_MODES];
 
+#ifdef SLEEP_STATS_ENABLED
+#define SLEEP_STATS_LINE	(9 + 1 + FMT_UINT_MAX_LEN + 3 + FMT_UINT_MAX_LEN + 1)	// "LEUART_TX <ms>ms <count>\n"
+
+typedef struct {
+	uint64_t	residency[MAX_ENERGY_MODES];	// ticks spent in each energy mode
+	uint32_t	entries[MAX_ENERGY_MODES];		// transitions into each energy mode
+	uint64_t	tag_held[MAX_SLEEP_TAGS];		// ticks each owner held at least one block
+	uint32_t	tag_blocks[MAX_SLEEP_TAGS];		// sleep_block_mode() calls per owner
+	uint32_t	tag_depth[MAX_SLEEP_TAGS];		// outstanding blocks per owner
+	uint32_t	tag_since[MAX_SLEEP_TAGS];		// first outstanding block was taken at
+	uint32_t	awake_since;					// last return to EM0
+	uint32_t	asleep_since;					// last sleep entry
+} SLEEP_STATS_STRUCT;
+
+static SLEEP_STATS_STRUCT sleep_stats;
+static const char * const sleep_tag_names[MAX_SLEEP_TAGS] = {
+	"APP", "RTCC", "LETIMER", "I2C", "LEUART_TX", "LEUART_RX"
+};
+#endif
+
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
+#ifdef SLEEP_STATS_ENABLED
+/***************************************************************************//**
+ * @brief
+ *	Starts the blocking interval of tag on its first outstanding block
+ *
+ * @note
+ *	Called inside the critical section of sleep_block_mode().
+ *
+ ******************************************************************************/
+static void sleep_stats_block(uint32_t tag){
+	EFM_ASSERT(tag < MAX_SLEEP_TAGS);
+	if(sleep_stats.tag_depth[tag]++ == 0) sleep_stats.tag_since[tag] = SLEEP_STATS_NOW();
+	sleep_stats.tag_blocks[tag]++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Closes the blocking interval of tag when its last block is released
+ *
+ * @note
+ *	Called inside the critical section of sleep_unblock_mode().
+ *
+ ******************************************************************************/
+static void sleep_stats_unblock(uint32_t tag){
+	EFM_ASSERT(tag < MAX_SLEEP_TAGS);
+	EFM_ASSERT(sleep_stats.tag_depth[tag] > 0);
+	if(--sleep_stats.tag_depth[tag] == 0){
+		sleep_stats.tag_held[tag] += SLEEP_STATS_NOW() - sleep_stats.tag_since[tag];
+	}
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Closes the EM0 interval just before the core goes to sleep
+ *
+ ******************************************************************************/
+static void sleep_stats_sleep(void){
+	uint32_t now = SLEEP_STATS_NOW();
+	sleep_stats.residency[EM0] += now - sleep_stats.awake_since;
+	sleep_stats.asleep_since = now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Charges the time just spent asleep to EM
+ *
+ * @details
+ *	Runs on wake up, before the pending interrupt is taken, so the interrupt
+ *	service time is counted as EM0.
+ *
+ ******************************************************************************/
+static void sleep_stats_wake(uint32_t EM){
+	uint32_t now = SLEEP_STATS_NOW();
+	sleep_stats.residency[EM] += now - sleep_stats.asleep_since;
+	sleep_stats.entries[EM]++;
+	sleep_stats.entries[EM0]++;
+	sleep_stats.awake_since = now;
+}
+#else
+#define sleep_stats_block(tag)		((void)(tag))
+#define sleep_stats_unblock(tag)	((void)(tag))
+#define sleep_stats_sleep()
+#define sleep_stats_wake(EM)
+#endif
 
 //***********************************************************************************
 // Global functions
@@ -59,7 +146,8 @@ static int lowest_energy_mode[MAX_ENERGY_MODES];
  * Initializes the sleep handler
  *
  * @details
- * Sets all entries of the static lowest_energy_mode[] array to 0.
+ * Sets all entries of the static lowest_energy_mode[] array to 0 and clears
+ * the residency profile if SLEEP_STATS_ENABLED is defined.
  *
  * @note
  * Upon initialization,
@@ -67,6 +155,9 @@ static int lowest_energy_mode[MAX_ENERGY_MODES];
  ******************************************************************************/
 void sleep_open(void){
 	for(int i = 0; i < MAX_ENERGY_MODES; i++) lowest_energy_mode[i] = 0;
+#ifdef SLEEP_STATS_ENABLED
+	memset(&sleep_stats, 0, sizeof(sleep_stats));
+#endif
 }
 
 /***************************************************************************//**
@@ -76,22 +167,27 @@ void sleep_open(void){
  * @details
  * This will modify the static lowest_energy_mode[] array to block the passed
  * sleep mode. A sleep mode should not be blocked more than 5 times- if so, the
- * sleep mode is likely not being unblocked.
+ * sleep mode is likely not being unblocked. The time the block is held is
+ * charged to tag in the residency profile.
  *
  * @note
  * This is an atomic operation. A mode should not be blocked 5 times without
  * being unblocked. This will cause this function to fail an assert statement.
  *
- * @param[in]
+ * @param[in] EM
  * The desired sleep mode to block.
  *
+ * @param[in] tag
+ * SLEEP_TAG_x of the driver taking the block, unused without SLEEP_STATS_ENABLED.
+ *
  ******************************************************************************/
-void sleep_block_mode(uint32_t EM){
+void sleep_block_mode(uint32_t EM, uint32_t tag){
 	CORE_DECLARE_IRQ_STATE;
 	CORE_ENTER_CRITICAL();
 
 	lowest_energy_mode[EM] ++;
 	EFM_ASSERT(lowest_energy_mode[EM] < 5);
+	sleep_stats_block(tag);
 
 	CORE_EXIT_CRITICAL();
 }
@@ -108,18 +204,21 @@ void sleep_block_mode(uint32_t EM){
  * This is an atomic operation. If a sleep mode is unblocked and hasn't been blocked
  * this function may fail an assert statement.
  *
- * @param[in]
+ * @param[in] EM
  * The desired sleep mode to unblock.
  *
+ * @param[in] tag
+ * SLEEP_TAG_x the block was taken with.
  *
  ******************************************************************************/
-void sleep_unblock_mode(uint32_t EM){
+void sleep_unblock_mode(uint32_t EM, uint32_t tag){
 	if(lowest_energy_mode[EM] > 0){
 		CORE_DECLARE_IRQ_STATE;
 		CORE_ENTER_CRITICAL();
 
 		lowest_energy_mode[EM] --;
 		EFM_ASSERT(lowest_energy_mode[EM]>=0);
+		sleep_stats_unblock(tag);
 
 		CORE_EXIT_CRITICAL();
 	}
@@ -131,7 +230,8 @@ void sleep_unblock_mode(uint32_t EM){
  *
  * @details
  * This function uses the static lowest_energy_modes[] array to find the deepest
- * sleep energy mode that is not blocked. It then enters that energy mode.
+ * sleep energy mode that is not blocked. It then enters that energy mode. With
+ * SLEEP_STATS_ENABLED the entry and wake up are timestamped on the RTCC.
  *
  * @note
  * This function runs atomically. This will never enter the EM4 energy state
@@ -151,16 +251,22 @@ void enter_sleep(void){
 		return;
 	}
 	if(lowest_energy_mode[EM2] > 0){
+		sleep_stats_sleep();
 		EMU_EnterEM1();
+		sleep_stats_wake(EM1);
 		CORE_EXIT_CRITICAL();
 		return;
 	}
 	if(lowest_energy_mode[EM3] > 0){
+		sleep_stats_sleep();
 		EMU_EnterEM2(true);
+		sleep_stats_wake(EM2);
 		CORE_EXIT_CRITICAL();
 		return;
 	}
+	sleep_stats_sleep();
 	EMU_EnterEM3(true);
+	sleep_stats_wake(EM3);
 	CORE_EXIT_CRITICAL();
 }
 
@@ -189,3 +295,81 @@ uint32_t current_block_energy_mode(void){
 	}
 	return MAX_ENERGY_MODES-1;
 }
+
+#ifdef SLEEP_STATS_ENABLED
+/***************************************************************************//**
+ * @brief
+ * Restarts the residency profile
+ *
+ * @details
+ * Clears the accumulated residency, transition and blocking counts. Blocks that
+ * are still held keep their depth and start a new interval now.
+ *
+ ******************************************************************************/
+void sleep_stats_reset(void){
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+
+	uint32_t now = SLEEP_STATS_NOW();
+	memset(sleep_stats.residency, 0, sizeof(sleep_stats.residency));
+	memset(sleep_stats.entries, 0, sizeof(sleep_stats.entries));
+	memset(sleep_stats.tag_held, 0, sizeof(sleep_stats.tag_held));
+	memset(sleep_stats.tag_blocks, 0, sizeof(sleep_stats.tag_blocks));
+	for(int i = 0; i < MAX_SLEEP_TAGS; i++) sleep_stats.tag_since[i] = now;
+	sleep_stats.awake_since = now;
+
+	CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Streams the residency profile over BLE
+ *
+ * @details
+ * Takes a snapshot with the open EM0 and blocking intervals closed at the
+ * current time, then writes one line per energy mode, "EMn <ms>ms <entries>",
+ * and one per tag, "<tag> <ms held>ms <blocks>".
+ *
+ * @note
+ * Must be called from the main loop, ble_reserve() may wait for the LEUART.
+ * The report's own transmission is charged to the next profile.
+ *
+ ******************************************************************************/
+void sleep_stats_dump(void){
+	SLEEP_STATS_STRUCT snap;
+
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	uint32_t now = SLEEP_STATS_NOW();
+	snap = sleep_stats;
+	CORE_EXIT_CRITICAL();
+
+	snap.residency[EM0] += now - snap.awake_since;
+	for(int i = 0; i < MAX_SLEEP_TAGS; i++){
+		if(snap.tag_depth[i]) snap.tag_held[i] += now - snap.tag_since[i];
+	}
+
+	for(int i = 0; i < MAX_ENERGY_MODES - 1 + MAX_SLEEP_TAGS; i++){
+		char *line = ble_reserve(SLEEP_STATS_LINE);
+		if(!line) return;
+		uint32_t n;
+		if(i < MAX_ENERGY_MODES - 1){
+			n = fmt_str(line, "EM");
+			n += fmt_uint(&line[n], i);
+			line[n++] = ' ';
+			n += fmt_uint(&line[n], (uint32_t)(snap.residency[i] * 1000 / SLEEP_STATS_HZ));
+			n += fmt_str(&line[n], "ms ");
+			n += fmt_uint(&line[n], snap.entries[i]);
+		} else {
+			uint32_t tag = i - (MAX_ENERGY_MODES - 1);
+			n = fmt_str(line, sleep_tag_names[tag]);
+			line[n++] = ' ';
+			n += fmt_uint(&line[n], (uint32_t)(snap.tag_held[tag] * 1000 / SLEEP_STATS_HZ));
+			n += fmt_str(&line[n], "ms ");
+			n += fmt_uint(&line[n], snap.tag_blocks[tag]);
+		}
+		line[n++] = '\n';
+		ble_commit(n);
+	}
+}
+#endif
@@ -0,0 +1,289 @@
+/**
+ * @file sw_timer.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Tickless software timers. Any number of one-shot and periodic timers
+ * share one free running counter; only the nearest deadline is programmed
+ * into its compare, so the CPU wakes once per expiry and never in between.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "sw_timer.h"
+#include "irq.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define DUE(t, now)		((int32_t)((t)->deadline - (now)) <= 0)
+#define SW_TIMER_MASK_LEVEL	IRQ_LEVEL_LEUART	// the RTCC expires timers, I2C callbacks and the BLE RX parser start them
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const SW_TIMER_PORT	*timer_port;
+static SW_TIMER_STRUCT		*timer_head;	// active timers, nearest deadline first
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Insert a timer in deadline order
+ *
+ * @note
+ *	Timers with the same deadline expire in the order they were started.
+ *	Must be called with SW_TIMER_MASK_LEVEL masked.
+ *
+ ******************************************************************************/
+static void sw_timer_insert(SW_TIMER_STRUCT *timer){
+	SW_TIMER_STRUCT **link = &timer_head;
+	while((*link != NULL) && ((int32_t)((*link)->deadline - timer->deadline) <= 0)){
+		link = &(*link)->next;
+	}
+	timer->next = *link;
+	*link = timer;
+	timer->active = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Unlink a timer from the deadline list
+ *
+ * @note
+ *	Must be called with SW_TIMER_MASK_LEVEL masked.
+ *
+ ******************************************************************************/
+static void sw_timer_unlink(SW_TIMER_STRUCT *timer){
+	SW_TIMER_STRUCT **link = &timer_head;
+	while(*link != NULL){
+		if(*link == timer){
+			*link = timer->next;
+			break;
+		}
+		link = &(*link)->next;
+	}
+	timer->next = NULL;
+	timer->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Program the compare for the nearest deadline
+ *
+ * @details
+ *	A deadline closer than SW_TIMER_MIN_LEAD, or already passed, is armed
+ *	SW_TIMER_MIN_LEAD ticks from now so the compare match cannot be missed.
+ *
+ * @note
+ *	Must be called with SW_TIMER_MASK_LEVEL masked.
+ *
+ ******************************************************************************/
+static void sw_timer_program(void){
+	if(timer_head == NULL){
+		timer_port->disarm();
+		return;
+	}
+	uint32_t now = timer_port->now();
+	uint32_t target = timer_head->deadline;
+	if((int32_t)(target - now) < SW_TIMER_MIN_LEAD) target = now + SW_TIMER_MIN_LEAD;
+	timer_port->arm(target);
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Software Timer Init/Open Function
+ *
+ * @details
+ *	Binds the timer service to the free running counter described by port and
+ *	empties the deadline list.
+ *
+ * @note
+ *	The counter must already be running. On target this is rtcc_timer_port
+ *	after rtcc_open(); a host test can pass a fake counter.
+ *
+ * @param[in] *port
+ *	The counter the deadlines are measured on.
+ *
+ ******************************************************************************/
+void sw_timer_open(const SW_TIMER_PORT *port){
+	EFM_ASSERT((port != NULL) && (port->hz != 0));
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(SW_TIMER_MASK_LEVEL);
+	timer_port = port;
+	timer_head = NULL;
+	timer_port->disarm();
+	IRQ_MASK_EXIT();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Initialize a software timer
+ *
+ * @details
+ *	On expiry the callback, if any, is called from the compare interrupt and
+ *	then the scheduler event, if any, is posted.
+ *
+ * @note
+ *	The timer structure is owned by the caller and must stay valid while the
+ *	timer is active.
+ *
+ * @param[in] *timer
+ *	The timer to initialize.
+ *
+ * @param[in] event
+ *	Scheduler event posted on expiry, SCHEDULER_NO_EVENT for none.
+ *
+ * @param[in] callback
+ *	Function called from interrupt context on expiry, NULL for none.
+ *
+ * @param[in] *ctx
+ *	Argument passed to the callback.
+ *
+ ******************************************************************************/
+void sw_timer_init(SW_TIMER_STRUCT *timer, uint32_t event, SW_TIMER_CALLBACK callback, void *ctx){
+	timer->next = NULL;
+	timer->deadline = 0;
+	timer->period = 0;
+	timer->event = event;
+	timer->callback = callback;
+	timer->ctx = ctx;
+	timer->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Start a software timer in milliseconds
+ *
+ * @param[in] *timer
+ *	An initialized timer, restarted if already active.
+ *
+ * @param[in] delay_ms
+ *	Time to the first expiry.
+ *
+ * @param[in] period_ms
+ *	Time between expiries, 0 for a one-shot.
+ *
+ ******************************************************************************/
+void sw_timer_start(SW_TIMER_STRUCT *timer, uint32_t delay_ms, uint32_t period_ms){
+	sw_timer_start_ticks(timer, sw_timer_ms_to_ticks(delay_ms), sw_timer_ms_to_ticks(period_ms));
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Start a software timer in counter ticks
+ *
+ * @details
+ *	Periodic deadlines advance by the period from the previous deadline, not
+ *	from the time the interrupt was serviced, so they do not drift.
+ *
+ * @note
+ *	Can be called from a timer callback.
+ *
+ * @param[in] *timer
+ *	An initialized timer, restarted if already active.
+ *
+ * @param[in] delay
+ *	Ticks to the first expiry.
+ *
+ * @param[in] period
+ *	Ticks between expiries, 0 for a one-shot.
+ *
+ ******************************************************************************/
+void sw_timer_start_ticks(SW_TIMER_STRUCT *timer, uint32_t delay, uint32_t period){
+	EFM_ASSERT((delay <= SW_TIMER_MAX_TICKS) && (period <= SW_TIMER_MAX_TICKS));
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(SW_TIMER_MASK_LEVEL);
+	bool was_head = (timer_head == timer);
+	if(timer->active) sw_timer_unlink(timer);
+	timer->deadline = timer_port->now() + delay;
+	timer->period = period;
+	sw_timer_insert(timer);
+	if(was_head || (timer_head == timer)) sw_timer_program();
+	IRQ_MASK_EXIT();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Stop a software timer
+ *
+ * @details
+ *	Nothing happens if the timer is not active. A scheduler event already
+ *	posted by the timer is not withdrawn.
+ *
+ * @param[in] *timer
+ *	The timer to stop.
+ *
+ ******************************************************************************/
+void sw_timer_stop(SW_TIMER_STRUCT *timer){
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(SW_TIMER_MASK_LEVEL);
+	if(timer->active){
+		bool was_head = (timer_head == timer);
+		sw_timer_unlink(timer);
+		if(was_head) sw_timer_program();
+	}
+	IRQ_MASK_EXIT();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Returns true while a timer is on the deadline list
+ *
+ ******************************************************************************/
+bool sw_timer_active(SW_TIMER_STRUCT *timer){
+	return timer->active;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Convert milliseconds to counter ticks, rounding up
+ *
+ ******************************************************************************/
+uint32_t sw_timer_ms_to_ticks(uint32_t ms){
+	return (uint32_t)(((uint64_t)ms * timer_port->hz + 999) / 1000);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Service every expired timer
+ *
+ * @details
+ *	Called by the compare interrupt of the counter. Expired timers are taken
+ *	off the front of the list in deadline order; periodic ones are put back
+ *	with their next deadline before the callback runs, so the callback may
+ *	stop or restart them. The compare is then programmed for the new nearest
+ *	deadline.
+ *
+ * @note
+ *	A periodic timer that was held off for more than a period skips the
+ *	missed expiries instead of firing them back to back.
+ *
+ ******************************************************************************/
+void sw_timer_expire(void){
+	IRQ_DECLARE_MASK_STATE;
+	IRQ_MASK_ENTER(SW_TIMER_MASK_LEVEL);
+	uint32_t now = timer_port->now();
+	while((timer_head != NULL) && DUE(timer_head, now)){
+		SW_TIMER_STRUCT *timer = timer_head;
+		sw_timer_unlink(timer);
+		if(timer->period){
+			do {
+				timer->deadline += timer->period;
+			} while(DUE(timer, now));
+			sw_timer_insert(timer);
+		}
+		if(timer->callback != NULL) timer->callback(timer->ctx);
+		add_scheduled_event(timer->event);
+		now = timer_port->now();
+	}
+	sw_timer_program();
+	IRQ_MASK_EXIT();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file trace.c
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Interrupt and scheduled event timing on the DWT cycle counter
+ *
+ * With TRACE_ENABLED defined in trace.h, every interrupt handler and every
+ * scheduled event handler is timed from entry to exit, and every scheduled
+ * event from add_scheduled_event() to the start of its handler. The min, max
+ * and mean of each are kept in trace_stats and trace_latency, the last
+ * TRACE_RING_SIZE handler runs in trace_ring, for tools/trace.gdb, and
+ * trace_dump() sends them over BLE. Without it the hooks compile to nothing.
+ *
+ * CYCCNT runs on the core clock, so a time is only valid if the core did not
+ * go below EM1 in between. Handlers do not sleep, and the main loop
+ * dispatches the events posted by the interrupt that woke it before it
+ * sleeps again.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "trace.h"
+
+#ifdef TRACE_ENABLED
+#include <string.h>
+
+#include "em_core.h"
+#include "ble.h"
+#include "fmt.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TRACE_LINE		(8 + 1 + 3 * (FMT_UINT_MAX_LEN + 1) + FMT_UINT_MAX_LEN + 1)	// "<name> <count> <min> <mean> <max>\n"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// Not static, tools/trace.gdb reads them by name
+TRACE_STAT_STRUCT		trace_stats[TRACE_POINTS];				// handler durations
+TRACE_STAT_STRUCT		trace_latency[SCHEDULER_MAX_EVENTS];	// post to dispatch, by priority slot
+TRACE_RECORD_STRUCT		trace_ring[TRACE_RING_SIZE];
+volatile uint32_t		trace_ring_head;						// next record written
+
+static uint32_t			trace_posted_at[SCHEDULER_MAX_EVENTS];
+static const char * const trace_isr_names[TRACE_ISR_COUNT] = {
+	"LETIMER0", "I2C0", "I2C1", "LEUART0", "LDMA", "RTCC", "LETIMER1", "LEUART1"
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Claims the next record of the ring with an exclusive load/store pair
+ *
+ * @details
+ *	A handler that preempts the claim makes the store fail and the claim is
+ *	retried, each writer gets its own record without masking interrupts.
+ *
+ ******************************************************************************/
+static TRACE_RECORD_STRUCT *trace_ring_claim(void){
+	uint32_t head;
+	do {
+		head = __LDREXW(&trace_ring_head);
+	} while(__STREXW(head + 1, &trace_ring_head));
+	return &trace_ring[head & (TRACE_RING_SIZE - 1)];
+}
+
+static void trace_stat_add(TRACE_STAT_STRUCT *stat, uint32_t cycles){
+	if((stat->count == 0) || (cycles < stat->min)) stat->min = cycles;
+	if(cycles > stat->max) stat->max = cycles;
+	stat->sum += cycles;
+	stat->count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Sends one "<name><index> <count> <min> <mean> <max>" line, cycles
+ *
+ * @return
+ *	false if the BLE buffer could not take the line
+ *
+ ******************************************************************************/
+static bool trace_line(const char *name, int32_t index, const TRACE_STAT_STRUCT *stat){
+	char *line = ble_reserve(TRACE_LINE);
+	if(!line) return false;
+	uint32_t n = fmt_str(line, name);
+	if(index >= 0) n += fmt_uint(&line[n], index);
+	line[n++] = ' ';
+	n += fmt_uint(&line[n], stat->count);
+	line[n++] = ' ';
+	n += fmt_uint(&line[n], stat->min);
+	line[n++] = ' ';
+	n += fmt_uint(&line[n], (uint32_t)(stat->sum / stat->count));
+	line[n++] = ' ';
+	n += fmt_uint(&line[n], stat->max);
+	line[n++] = '\n';
+	ble_commit(n);
+	return true;
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *	Starts the DWT cycle counter and clears the statistics
+ *
+ ******************************************************************************/
+void trace_open(void){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	trace_reset();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Clears the statistics and the ring
+ *
+ ******************************************************************************/
+void trace_reset(void){
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	memset(trace_stats, 0, sizeof(trace_stats));
+	memset(trace_latency, 0, sizeof(trace_latency));
+	memset(trace_ring, 0, sizeof(trace_ring));
+	trace_ring_head = 0;
+	CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Records a handler run, called through TRACE_EXIT()
+ *
+ * @details
+ *	Masks no interrupt, the LEUART and I2C keep the latency the trace
+ *	measures. A point is only ever updated from one context: an interrupt
+ *	does not preempt itself, and event handlers all run in the main loop. A
+ *	handler that preempts another updates its own point and claims its own
+ *	ring record, its run is part of the time of the handler it preempted.
+ *
+ * @param[in] point
+ *	TRACE_ISR_x or TRACE_EVENT(slot)
+ *
+ * @param[in] start
+ *	TRACE_NOW() at the entry of the handler
+ *
+ ******************************************************************************/
+void trace_exit(uint32_t point, uint32_t start){
+	uint32_t cycles = TRACE_NOW() - start;
+	EFM_ASSERT(point < TRACE_POINTS);
+	trace_stat_add(&trace_stats[point], cycles);
+	TRACE_RECORD_STRUCT *record = trace_ring_claim();
+	record->start = start;
+	record->cycles = cycles;
+	record->point = point;
+}
+
+/***************************************************************************//**
+ * @brief
+ *	An event of the priority slot went pending
+ *
+ * @note
+ *	Called from add_scheduled_event() after its atomic set, only when
+ *	the event was not already pending.
+ *
+ ******************************************************************************/
+void trace_posted(uint32_t slot){
+	trace_posted_at[slot] = TRACE_NOW();
+}
+
+/***************************************************************************//**
+ * @brief
+ *	The handler of the priority slot is about to run
+ *
+ ******************************************************************************/
+void trace_dispatched(uint32_t slot){
+	trace_stat_add(&trace_latency[slot], TRACE_NOW() - trace_posted_at[slot]);
+}
+
+/***************************************************************************//**
+ * @brief
+ *	Streams the statistics over BLE
+ *
+ * @details
+ *	One line per interrupt handler, "<name> <count> <min> <mean> <max>", then
+ *	per scheduler priority slot that ran, "EV<slot> ..." for the handler and
+ *	"LAT<slot> ..." for the wait before it, all in core clock cycles.
+ *
+ * @note
+ *	Must be called from the main loop, ble_reserve() may wait for the LEUART.
+ *	The dump's own transmission is part of the next statistics.
+ *
+ ******************************************************************************/
+void trace_dump(void){
+	for(uint32_t i = 0; i < TRACE_ISR_COUNT; i++){
+		if(trace_stats[i].count && !trace_line(trace_isr_names[i], -1, &trace_stats[i])) return;
+	}
+	for(uint32_t slot = 0; slot < SCHEDULER_MAX_EVENTS; slot++){
+		if(trace_stats[TRACE_EVENT(slot)].count && !trace_line("EV", slot, &trace_stats[TRACE_EVENT(slot)])) return;
+		if(trace_latency[slot].count && !trace_line("LAT", slot, &trace_latency[slot])) return;
+	}
+}
+#endif
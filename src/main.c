@@ -26,7 +26,7 @@ int main(void)
 
   /* Call application program to open / initialize all required peripheral */
   app_peripheral_setup();
-  EFM_ASSERT(get_scheduled_events() & BOOT_UP_CB);
+  EFM_ASSERT(scheduled_event_pending(BOOT_UP_CB));
 
   /* Infinite blink loop */
   while (1) {
@@ -35,24 +35,6 @@ int main(void)
 	  if(!get_scheduled_events()) enter_sleep();
 	  CORE_EXIT_CRITICAL();
 
-	  if(get_scheduled_events() & LETIMER0_UF_CB){
-		  scheduled_letimer0_uf_evt();
-	  }
-	  if(get_scheduled_events() & LETIMER0_COMP0_CB){
-		  scheduled_letimer0_comp0_evt();
-	  }
-	  if(get_scheduled_events() & LETIMER0_COMP1_CB){
-		  scheduled_letimer0_comp1_evt();
-	  }
-	  if(get_scheduled_events() & I2C_7021_READ_CB){
-		  scheduled_si7021_tempDone();
-	  }
-	  if(get_scheduled_events() & BOOT_UP_CB){
-		  scheduled_boot_up_cb();
-	  }
-	  if(get_scheduled_events() & BLE_TX_DONE_CB){
-		  ble_tx_done_cb();
-	  }
-
+	  scheduler_dispatch();
   }
 }
@@ -0,0 +1,105 @@
+/**
+ * @file ble_decode.cpp
+ * @author Connor Peskin
+ * @date October 16, 2026
+ * @brief Host side decoder of the BLE_FRAME_BINARY sample stream, see ble.h.
+ * Reads the raw bytes received from the HM-10 and writes one CSV line per
+ * sample record. Text between frames and frames with a bad CRC are skipped.
+ *
+ * Build:	g++ -std=c++17 -O2 -o ble_decode ble_decode.cpp
+ * Use:		ble_decode [capture.bin] > samples.csv
+ *
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t	FRAME_SYNC		= 0xA5;
+constexpr size_t	FRAME_HDR		= 7;		// SYNC, SEQ, LEN, TIME
+constexpr size_t	FRAME_CRC		= 2;
+constexpr unsigned	DT_SHIFT		= 10;		// record DT in RTCC ticks >> 10
+constexpr double	RTCC_HZ			= 32768.0;
+
+/* CRC-16/MCRF4XX, what the GPCRC computes for polynomial 0x1021 without bit reversal */
+uint16_t crc16(const uint8_t *data, size_t len){
+	uint16_t crc = 0xFFFF;
+	for(size_t i = 0; i < len; i++){
+		crc ^= data[i];
+		for(int b = 0; b < 8; b++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+	}
+	return crc;
+}
+
+uint32_t le16(const uint8_t *p){ return p[0] | (p[1] << 8); }
+uint32_t le32(const uint8_t *p){ return le16(p) | (le16(p + 2) << 16); }
+
+/* Walks the records of a frame whose CRC checked, printing them as CSV if print */
+bool walk_records(const uint8_t *frame, bool print){
+	uint32_t seq = frame[1];
+	size_t len = frame[2];
+	uint32_t time = le32(&frame[3]);
+	const uint8_t *rec = &frame[FRAME_HDR];
+	const uint8_t *end = rec + len;
+
+	while(rec < end){
+		uint32_t sensor = rec[0] >> 4;
+		uint32_t count = rec[0] & 0x0F;
+		if(!count || (rec + 3 + 2 * count > end)) return false;
+		if(print){
+			uint32_t ticks = time + (le16(&rec[1]) << DT_SHIFT);
+			std::printf("%u,%.3f,%u", seq, ticks / RTCC_HZ, sensor);
+			for(uint32_t i = 0; i < count; i++){
+				int16_t value = static_cast<int16_t>(le16(&rec[3 + 2 * i]));
+				std::printf(",%.2f", value / 100.0);
+			}
+			std::printf("\n");
+		}
+		rec += 3 + 2 * count;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char **argv){
+	std::vector<uint8_t> in;
+	if(argc > 1){
+		std::ifstream file(argv[1], std::ios::binary);
+		if(!file){
+			std::cerr << "ble_decode: cannot open " << argv[1] << "\n";
+			return 1;
+		}
+		in.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	} else {
+		in.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+	}
+
+	std::printf("seq,time_s,sensor,values...\n");
+	size_t frames = 0, bad = 0;
+	size_t i = 0;
+	while(i + FRAME_HDR + FRAME_CRC <= in.size()){
+		if(in[i] != FRAME_SYNC){
+			i++;
+			continue;
+		}
+		size_t total = FRAME_HDR + in[i + 2] + FRAME_CRC;
+		if(i + total > in.size()) break;
+		const uint8_t *frame = &in[i];
+		if(crc16(frame, total - FRAME_CRC) != le16(&frame[total - FRAME_CRC]) || !walk_records(frame, false)){
+			bad++;
+			i++;		// not a frame, resync on the next sync byte
+			continue;
+		}
+		walk_records(frame, true);
+		frames++;
+		i += total;
+	}
+	std::cerr << "ble_decode: " << frames << " frames, " << bad << " rejected sync bytes\n";
+	return 0;
+}